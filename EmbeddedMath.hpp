@@ -5,736 +5,6304 @@
 
 #include "math.h"
 #include "string.h"
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #define FLOAT_EPSILON 1.1920929e-7f
 
+// SIMD kernels are picked at compile time from the target flags.
+// Define EMBEDDEDMATH_DONT_VECTORIZE to always use the portable scalar code.
+#if !defined(EMBEDDEDMATH_DONT_VECTORIZE)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EMBEDDEDMATH_SSE2
+#if defined(__AVX__)
+#define EMBEDDEDMATH_AVX
+#endif
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define EMBEDDEDMATH_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+// Width in bytes of the packets used by coefficient-wise loops, 0 keeps every loop scalar.
+// Defaults to the SIMD register width of the target, define it to override (e.g. 0 on Cortex-M0).
+#if !defined(EMBEDDEDMATH_PACKET_BYTES)
+#if defined(EMBEDDEDMATH_AVX)
+#define EMBEDDEDMATH_PACKET_BYTES 32
+#elif defined(EMBEDDEDMATH_SSE2) || defined(EMBEDDEDMATH_NEON)
+#define EMBEDDEDMATH_PACKET_BYTES 16
+#else
+#define EMBEDDEDMATH_PACKET_BYTES 0
+#endif
+#endif
+
 namespace EmbeddedTypes
 {
-    template <typename ScalarType, int rows, int cols>
+    // tag for constructing a matrix without zero-filling it, for results that are overwritten completely
+    struct NoInit_t
+    {
+        explicit NoInit_t() = default;
+    };
+    inline constexpr NoInit_t NoInit{};
+
+    // size of a dimension only known at runtime, bounded by the MaxRows/MaxCols template arguments
+    inline constexpr int Dynamic = -1;
+
+    // storage options of EmbeddedCoreType, can be combined with |
+    enum StorageOptions
+    {
+        DefaultStorage = 0,
+        ColMajor = 0,
+        RowMajor = 0x1,   // rows are stored contiguously, ignored for column vectors
+        Aligned16 = 0x10, // storage starts on a 16-byte boundary
+        Aligned32 = 0x20, // storage starts on a 32-byte boundary
+        Padded = 0x40,    // every column (row when RowMajor) is padded so it starts on an aligned boundary, implies Aligned16 at least
+    };
+
+    // part of a square matrix read by triangularView<Mode>() and selfadjointView<UpLo>(), can be combined with |
+    enum UpLoType
+    {
+        Lower = 0x1,
+        Upper = 0x2,
+        UnitDiag = 0x4, // the diagonal reads as ones, triangularView only
+        ZeroDiag = 0x8, // the diagonal reads as zeros, triangularView only
+        UnitLower = Lower | UnitDiag,
+        UnitUpper = Upper | UnitDiag,
+        StrictlyLower = Lower | ZeroDiag,
+        StrictlyUpper = Upper | ZeroDiag,
+    };
+
+    // outcome of a decomposition, returned by info()
+    enum ComputationInfo
+    {
+        Success = 0,
+        NumericalIssue = 1, // e.g. a matrix that is not positive definite given to LLT
+    };
+
+    // kind of a block of a structured matrix, see EmbeddedStructuredType
+    enum BlockKind
+    {
+        ZeroBlock = 0,
+        IdentityBlock = 1, // square
+        DenseBlock = 2,
+    };
+
+    // sizes of the block rows, or block columns, of a structured matrix
+    template <int... Sizes>
+    struct BlockSizes
+    {
+    };
+
+    // kinds of the blocks of a structured matrix, block row after block row
+    template <int... Kinds>
+    struct BlockPattern
+    {
+    };
+
+    template <typename Derived>
+    class EmbeddedExprBase;
+
+    template <typename ScalarType, int rows, int cols, int Options = DefaultStorage, int MaxRows = rows, int MaxCols = cols>
     class EmbeddedCoreType;
 
-    template <typename ScalarType, int rows, int cols>
+    template <typename ScalarType, int rows, int cols, int Options, int MaxRows, int MaxCols>
+    class EmbeddedBoundedType;
+
+    template <typename ScalarType, int rows, int cols, int outerStride = rows, bool rowMajor = false>
     class EmbeddedRefType;
 
+    template <typename Derived>
+    class EmbeddedMapBase;
+
+    template <typename XprType, int BlockRows, int BlockCols>
+    class EmbeddedBlockType;
+
+    template <int OuterStrideAtCompileTime, int InnerStrideAtCompileTime>
+    class EmbeddedStride;
+
+    template <typename PlainObjectType, typename StrideType = EmbeddedStride<0, 0>>
+    class EmbeddedMapType;
+
+    template <typename PlainObjectType>
+    class EmbeddedMatrixRef;
+
+    template <typename BinaryOp, typename LhsType, typename RhsType>
+    class EmbeddedCwiseBinaryOp;
+
+    template <typename UnaryOp, typename XprType>
+    class EmbeddedCwiseUnaryOp;
+
+    template <typename XprType>
+    class EmbeddedTransposeType;
+
+    template <typename LhsType, typename RhsType>
+    class EmbeddedProductType;
+
+    template <typename XprType, int Mode>
+    class EmbeddedTriangularView;
+
+    template <typename XprType, int UpLo>
+    class EmbeddedSelfAdjointView;
+
+    template <typename ScalarType, int N>
+    class EmbeddedSymmetricType;
+
+    template <typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern>
+    class EmbeddedStructuredType;
+
+    template <typename ExpressionType>
+    class EmbeddedNoAlias;
+
     template <typename ScalarType>
     class EmbeddedQuaternion;
 
     template <class MatrixType>
     class PartialPivLU;
 
-    template <typename ScalarType, int rows, int cols>
-    class EmbeddedRefType
-    {
-    protected:
-        ScalarType (&RefElements)[rows * cols];
-        static constexpr int size = rows * cols;
-        const int subRows, subCols, subSize, startRow, startCol;
-        bool isColumnMajorOrder;
+    template <class MatrixType>
+    class LLT;
 
-    public:
-        using Scalar = ScalarType;
+    template <class MatrixType>
+    class LDLT;
 
-        EmbeddedRefType() = delete;
+    namespace internal
+    {
+        // compile-time description of every expression: Scalar, sizes, the plain type it evaluates to,
+        // the storage order, the distance between two columns (rows when row-major) in storage (-1 when the
+        // operands disagree), the alignment of the storage, whether coeff(index) walks the storage linearly,
+        // whether packet(row, col) reads along the inner dimension from any coefficient (every operand sharing
+        // the storage order), whether it is nested by reference and whether data() gives direct access to
+        // the coefficients, with MapOuterStride/MapInnerStride between columns and inside a column in memory
+        template <typename T>
+        struct traits;
+
+        // memory layout of an EmbeddedCoreType: storage order, alignment in bytes, leading dimension and
+        // array length. Column vectors are always column-major and row vectors always row-major.
+        template <typename ScalarType, int rows, int cols, int Options>
+        struct storage_layout
+        {
+            static constexpr bool IsRowMajor = (rows == 1 && cols != 1) || ((Options & RowMajor) && cols != 1);
+            static constexpr int InnerSize = IsRowMajor ? cols : rows;
+            static constexpr int OuterSize = IsRowMajor ? rows : cols;
+            static constexpr int Alignment = (Options & Aligned32) ? 32 : ((Options & (Aligned16 | Padded)) ? 16 : static_cast<int>(alignof(ScalarType)));
+            static constexpr int PadUnit = ((Options & Padded) && Alignment > static_cast<int>(sizeof(ScalarType))) ? Alignment / static_cast<int>(sizeof(ScalarType)) : 1;
+            static constexpr int OuterStride = (InnerSize + PadUnit - 1) / PadUnit * PadUnit;
+            static constexpr int StorageSize = OuterStride * OuterSize;
+        };
+
+        template <typename T>
+        struct traits<const T> : traits<T>
+        {
+        };
 
-        EmbeddedRefType(ScalarType (&Elements)[rows * cols],
-                        const int sub_rows, const int sub_cols,
-                        const int start_row, const int start_col) : RefElements(Elements),
-                                                                    subRows(sub_rows),
-                                                                    subCols(sub_cols),
-                                                                    subSize(sub_rows * sub_cols),
-                                                                    startRow(start_row),
-                                                                    startCol(start_col)
-        {
-            if ((sub_rows == rows) || (sub_cols == 1))
-                isColumnMajorOrder = true;
+        // true while the compiler evaluates a constant expression, where memcpy, packets and uninitialized
+        // storage are not allowed. Always false without the builtin (GCC < 9), constexpr use then fails to compile.
+        constexpr bool is_constant_evaluated()
+        {
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+            return __builtin_is_constant_evaluated();
+#else
+            return false;
+#endif
+#elif defined(__GNUC__) && __GNUC__ >= 9
+            return __builtin_is_constant_evaluated();
+#else
+            return false;
+#endif
+        }
+
+        // plain matrix left uninitialized (NoInit), the size only matters along Dynamic dimensions.
+        // A constant expression must initialize every coefficient, it gets a zero-filled matrix instead.
+        template <typename PlainType>
+        constexpr PlainType plain_uninitialized(int rows = 0, int cols = 0)
+        {
+            if constexpr (PlainType::SizeAtCompileTime == Dynamic)
+                return PlainType(rows, cols, NoInit);
             else
-                isColumnMajorOrder = false;
+                return is_constant_evaluated() ? PlainType() : PlainType(NoInit);
         }
 
-        inline ScalarType &operator()(int index)
+        template <typename T>
+        struct is_product : std::false_type
+        {
+        };
+
+        template <typename LhsType, typename RhsType>
+        struct is_product<EmbeddedProductType<LhsType, RhsType>> : std::true_type
+        {
+        };
+
+        // plain matrices are held by reference inside an expression, expression nodes are held by value
+        // and products are evaluated once into their plain result
+        template <typename T>
+        struct ref_selector
+        {
+            using type = std::conditional_t<traits<T>::NestByRef, const T &,
+                                            std::conditional_t<is_product<T>::value, const typename traits<T>::PlainObject, const T>>;
+        };
+
+        // the type T is held as inside an expression
+        template <typename T>
+        using nested_t = std::remove_cv_t<std::remove_reference_t<typename ref_selector<T>::type>>;
+
+        // operands of a product are held like in any other expression, except that a nested product stays lazy:
+        // the whole chain A * B * C is then known when it is evaluated, and can be evaluated in the cheapest order
+        template <typename T>
+        struct product_ref_selector
+        {
+            using type = std::conditional_t<is_product<T>::value, const T, typename ref_selector<T>::type>;
+        };
+
+        template <typename T>
+        using product_nested_t = std::remove_cv_t<std::remove_reference_t<typename product_ref_selector<T>::type>>;
+
+        // src of a coefficient loop: a product is evaluated first, since dst may be one of its operands
+        template <typename T>
+        using assignment_source_t = std::conditional_t<is_product<T>::value, const typename traits<T>::PlainObject, const T &>;
+
+        // operand of a product: plain matrices are used in place, expressions and packed matrices are evaluated once
+        template <typename T>
+        struct eval_selector
+        {
+            using type = std::conditional_t<traits<T>::NestByRef && traits<T>::HasDirectAccess, const T &, const typename traits<T>::PlainObject>;
+        };
+
+        // Packet layer: a packet is a GCC/Clang vector extension of EMBEDDEDMATH_PACKET_BYTES bytes.
+        // The usual arithmetic operators work on it directly, so functors share one code path for
+        // packets and scalars. Without vector extensions, or for other scalar types, a packet is a
+        // single scalar and every loop below degrades to plain scalar code.
+        template <typename Scalar, int Bytes = EMBEDDEDMATH_PACKET_BYTES, typename Enable = void>
+        struct packet_traits
+        {
+            using type = Scalar;
+            static constexpr int size = 1;
+        };
+
+#if defined(__GNUC__) || defined(__clang__)
+        template <typename Scalar, int Bytes>
+        struct packet_traits<Scalar, Bytes,
+                             std::enable_if_t<(std::is_same<Scalar, float>::value || std::is_same<Scalar, double>::value) &&
+                                              (Bytes >= 2 * static_cast<int>(sizeof(Scalar)))>>
+        {
+            typedef Scalar type __attribute__((vector_size(Bytes)));
+            static constexpr int size = Bytes / static_cast<int>(sizeof(Scalar));
+        };
+#endif
+
+        template <typename Packet, typename Scalar>
+        inline Packet ploadu(const Scalar *from)
+        {
+            Packet result;
+            memcpy(&result, from, sizeof(Packet));
+            return result;
+        }
+
+        template <typename Packet, typename Scalar>
+        inline void pstoreu(Scalar *to, const Packet &from)
         {
-            int refIndex = ((int)(index / subRows) + startCol) * rows + (index % subRows) + startRow;
-            return RefElements[refIndex];
+            memcpy(to, &from, sizeof(Packet));
         }
 
-        inline const ScalarType &operator()(int index) const
+        // aligned versions, from/to must be aligned to sizeof(Packet)
+        template <typename Packet, typename Scalar>
+        inline Packet pload(const Scalar *from)
         {
-            int refIndex = ((int)(index / subRows) + startCol) * rows + (index % subRows) + startRow;
-            return RefElements[refIndex];
+            Packet result;
+#if defined(__GNUC__) || defined(__clang__)
+            memcpy(&result, __builtin_assume_aligned(from, sizeof(Packet)), sizeof(Packet));
+#else
+            memcpy(&result, from, sizeof(Packet));
+#endif
+            return result;
         }
 
-        inline ScalarType &operator()(int row, int col)
+        template <typename Packet, typename Scalar>
+        inline void pstore(Scalar *to, const Packet &from)
         {
-            int refIndex = (col + startCol) * rows + row + startRow;
-            return RefElements[refIndex];
+#if defined(__GNUC__) || defined(__clang__)
+            memcpy(__builtin_assume_aligned(to, sizeof(Packet)), &from, sizeof(Packet));
+#else
+            memcpy(to, &from, sizeof(Packet));
+#endif
         }
 
-        inline const ScalarType &operator()(int row, int col) const
+        template <typename Packet, bool Aligned, typename Scalar>
+        inline Packet ploadt(const Scalar *from)
+        {
+            if constexpr (Aligned)
+                return pload<Packet>(from);
+            else
+                return ploadu<Packet>(from);
+        }
+
+        template <bool Aligned, typename Packet, typename Scalar>
+        inline void pstoret(Scalar *to, const Packet &from)
         {
-            int refIndex = (col + startCol) * rows + row + startRow;
-            return RefElements[refIndex];
+            if constexpr (Aligned)
+                pstore(to, from);
+            else
+                pstoreu(to, from);
         }
 
-        template <int SubRows, int SubCols>
-        inline void operator=(const EmbeddedCoreType<Scalar, SubRows, SubCols> &other)
+        template <typename Packet, typename Scalar>
+        inline Packet pset1(const Scalar &value)
         {
-            for (int i = 0; i < subSize; ++i)
+            Packet result;
+            for (int i = 0; i < static_cast<int>(sizeof(Packet) / sizeof(Scalar)); ++i)
             {
-                this->operator()(i) = other(i);
+                reinterpret_cast<Scalar *>(&result)[i] = value;
             }
-            return;
+            return result;
+        }
+
+        // pairwise reduction of the lanes [Begin, Begin + Count), the constant lane indices keep it in registers
+        template <typename Scalar, int Begin, int Count, typename Packet, typename Functor>
+        inline Scalar predux_lanes(const Packet &packet, const Functor &func)
+        {
+            if constexpr (Count == 1)
+                return packet[Begin];
+            else
+                return func(predux_lanes<Scalar, Begin, Count / 2>(packet, func), predux_lanes<Scalar, Begin + Count / 2, Count - Count / 2>(packet, func));
         }
 
-        inline void operator=(const EmbeddedRefType<Scalar, rows, cols> &other)
+        // reduces the first count lanes of a packet with a binary functor, pairwise for a whole packet
+        template <typename Scalar, typename Packet, typename Functor>
+        inline Scalar predux(const Packet &packet, const Functor &func, int count = static_cast<int>(sizeof(Packet) / sizeof(Scalar)))
         {
-            for (int i = 0; i < subSize; ++i)
+            constexpr int Size = static_cast<int>(sizeof(Packet) / sizeof(Scalar));
+            if constexpr (Size > 1)
             {
-                this->operator()(i) = other(i);
+                if (count == Size)
+                    return predux_lanes<Scalar, 0, Size>(packet, func);
             }
-            return;
+            const Scalar *lanes = reinterpret_cast<const Scalar *>(&packet);
+            Scalar result = lanes[0];
+            for (int i = 1; i < count; ++i)
+            {
+                result = func(result, lanes[i]);
+            }
+            return result;
         }
 
-        inline void swap(EmbeddedRefType other)
+        // true if any of the first count lanes of a and b differs
+        template <typename Scalar, typename Packet>
+        inline bool pany_neq(const Packet &a, const Packet &b, int count = static_cast<int>(sizeof(Packet) / sizeof(Scalar)))
+        {
+            const Scalar *la = reinterpret_cast<const Scalar *>(&a);
+            const Scalar *lb = reinterpret_cast<const Scalar *>(&b);
+            bool result = false;
+            for (int i = 0; i < count; ++i)
+            {
+                result |= (la[i] != lb[i]);
+            }
+            return result;
+        }
+
+        template <typename Scalar>
+        struct scalar_sum_op
+        {
+            static constexpr bool PacketAccess = true;
+            constexpr Scalar operator()(const Scalar &a, const Scalar &b) const { return a + b; }
+            template <typename Packet>
+            inline Packet packetOp(const Packet &a, const Packet &b) const { return a + b; }
+        };
+
+        template <typename Scalar>
+        struct scalar_difference_op
+        {
+            static constexpr bool PacketAccess = true;
+            constexpr Scalar operator()(const Scalar &a, const Scalar &b) const { return a - b; }
+            template <typename Packet>
+            inline Packet packetOp(const Packet &a, const Packet &b) const { return a - b; }
+        };
+
+        template <typename Scalar>
+        struct scalar_product_op
+        {
+            static constexpr bool PacketAccess = true;
+            constexpr Scalar operator()(const Scalar &a, const Scalar &b) const { return a * b; }
+            template <typename Packet>
+            inline Packet packetOp(const Packet &a, const Packet &b) const { return a * b; }
+        };
+
+        template <typename Scalar>
+        struct scalar_quotient_op
+        {
+            static constexpr bool PacketAccess = true;
+            constexpr Scalar operator()(const Scalar &a, const Scalar &b) const { return a / b; }
+            template <typename Packet>
+            inline Packet packetOp(const Packet &a, const Packet &b) const { return a / b; }
+        };
+
+        template <typename Scalar>
+        struct scalar_min_op
+        {
+            static constexpr bool PacketAccess = false;
+            constexpr Scalar operator()(const Scalar &a, const Scalar &b) const { return (b < a) ? b : a; }
+        };
+
+        template <typename Scalar>
+        struct scalar_max_op
+        {
+            static constexpr bool PacketAccess = false;
+            constexpr Scalar operator()(const Scalar &a, const Scalar &b) const { return (a < b) ? b : a; }
+        };
+
+        template <typename Scalar>
+        struct scalar_opposite_op
+        {
+            static constexpr bool PacketAccess = true;
+            constexpr Scalar operator()(const Scalar &a) const { return -a; }
+            template <typename Packet>
+            inline Packet packetOp(const Packet &a) const { return -a; }
+        };
+
+        template <typename Scalar>
+        struct scalar_multiple_op
+        {
+            static constexpr bool PacketAccess = true;
+            Scalar factor;
+            constexpr Scalar operator()(const Scalar &a) const { return a * factor; }
+            template <typename Packet>
+            inline Packet packetOp(const Packet &a) const { return a * pset1<Packet>(factor); }
+        };
+
+        template <typename Scalar>
+        struct scalar_quotient1_op
+        {
+            static constexpr bool PacketAccess = true;
+            Scalar divisor;
+            constexpr Scalar operator()(const Scalar &a) const { return a / divisor; }
+            template <typename Packet>
+            inline Packet packetOp(const Packet &a) const { return a / pset1<Packet>(divisor); }
+        };
+
+        template <typename Scalar>
+        struct scalar_abs_op
+        {
+            static constexpr bool PacketAccess = false;
+            inline Scalar operator()(const Scalar &a) const { return fabs(a); }
+        };
+
+        template <typename Scalar>
+        struct scalar_abs2_op
+        {
+            static constexpr bool PacketAccess = true;
+            constexpr Scalar operator()(const Scalar &a) const { return a * a; }
+            template <typename Packet>
+            inline Packet packetOp(const Packet &a) const { return a * a; }
+        };
+
+        template <typename Scalar>
+        struct scalar_sqrt_op
+        {
+            static constexpr bool PacketAccess = false;
+            inline Scalar operator()(const Scalar &a) const { return sqrt(a); }
+        };
+
+        struct assign_op
+        {
+            template <typename Scalar>
+            constexpr void assignCoeff(Scalar &dst, const Scalar &src) const { dst = src; }
+            template <typename Packet>
+            inline Packet assignPacket(const Packet &, const Packet &src) const { return src; }
+        };
+
+        struct add_assign_op
+        {
+            template <typename Scalar>
+            constexpr void assignCoeff(Scalar &dst, const Scalar &src) const { dst += src; }
+            template <typename Packet>
+            inline Packet assignPacket(const Packet &dst, const Packet &src) const { return dst + src; }
+        };
+
+        struct sub_assign_op
+        {
+            template <typename Scalar>
+            constexpr void assignCoeff(Scalar &dst, const Scalar &src) const { dst -= src; }
+            template <typename Packet>
+            inline Packet assignPacket(const Packet &dst, const Packet &src) const { return dst - src; }
+        };
+
+        // true when whole packets can be read along every column (row when row-major) at storage indices,
+        // the last packet of each running into the padding
+        template <typename T>
+        struct inner_packet_access
+        {
+            static constexpr int PacketSize = packet_traits<typename traits<T>::Scalar>::size;
+            static constexpr bool value = PacketSize > 1 && traits<T>::HasPacketAccess &&
+                                          traits<T>::OuterStride > 0 && traits<T>::OuterStride % PacketSize == 0;
+        };
+
+        // true when a and b share the same storage order and leading dimension
+        template <typename A, typename B>
+        struct same_layout
+        {
+            static constexpr bool value = traits<A>::IsRowMajor == traits<B>::IsRowMajor && traits<A>::OuterStride == traits<B>::OuterStride;
+        };
+
+        // true when packets at multiples of the packet size can use aligned loads and stores
+        template <typename T>
+        struct aligned_packet_access
+        {
+            static constexpr bool value = traits<T>::Alignment >= static_cast<int>(sizeof(typename packet_traits<typename traits<T>::Scalar>::type));
+        };
+
+        // true when an assignment can load and store packets along the inner dimension of dst and src from
+        // any coefficient, both sides sharing the storage order and the inner size not being shorter than a packet
+        template <typename DstType, typename SrcType>
+        struct coeff_packet_access
+        {
+            static constexpr int PacketSize = packet_traits<typename traits<DstType>::Scalar>::size;
+            static constexpr bool RowMajor = traits<DstType>::IsRowMajor;
+            static constexpr int DstInner = RowMajor ? traits<DstType>::ColsAtCompileTime : traits<DstType>::RowsAtCompileTime;
+            static constexpr int SrcInner = RowMajor ? traits<SrcType>::ColsAtCompileTime : traits<SrcType>::RowsAtCompileTime;
+            static constexpr int InnerSize = (DstInner == Dynamic) ? SrcInner : DstInner;
+            static constexpr bool value = PacketSize > 1 && traits<DstType>::HasCoeffPacketAccess && traits<SrcType>::HasCoeffPacketAccess &&
+                                          RowMajor == traits<SrcType>::IsRowMajor && (InnerSize == Dynamic || InnerSize >= PacketSize);
+        };
+
+        // two dimensions that may match, checked at compile time unless one of them is Dynamic
+        template <int A, int B>
+        struct compatible_size
         {
-            if (this->isColumnMajorOrder = true && other.isColumnMajorOrder == true)
+            static constexpr bool value = A == B || A == Dynamic || B == Dynamic;
+        };
+
+        // evaluates a whole expression tree in a single loop, writing straight into dst
+        template <typename DstType, typename SrcType, typename Functor>
+        constexpr void call_assignment(DstType &dst, const SrcType &src, const Functor &func)
+        {
+            static_assert(compatible_size<traits<DstType>::RowsAtCompileTime, traits<SrcType>::RowsAtCompileTime>::value &&
+                              compatible_size<traits<DstType>::ColsAtCompileTime, traits<SrcType>::ColsAtCompileTime>::value,
+                          "assignment between matrices of different sizes");
+            // loop bounds come from whichever side has a fixed size, runtime values when both are Dynamic
+            constexpr bool DstFixed = traits<DstType>::SizeAtCompileTime != Dynamic;
+            const int numRows = DstFixed ? dst.rows() : src.rows();
+            const int numCols = DstFixed ? dst.cols() : src.cols();
+            using Packet = typename packet_traits<typename traits<DstType>::Scalar>::type;
+            constexpr int PacketSize = packet_traits<typename traits<DstType>::Scalar>::size;
+            if (is_constant_evaluated())
+            {
+                for (int j = 0; j < numCols; ++j)
+                {
+                    for (int i = 0; i < numRows; ++i)
+                    {
+                        func.assignCoeff(dst.coeffRef(i, j), src.coeff(i, j));
+                    }
+                }
+            }
+            else if constexpr (inner_packet_access<DstType>::value && inner_packet_access<SrcType>::value && same_layout<DstType, SrcType>::value)
+            {
+                // same layout on both sides: walk the whole storage, the padding is computed but never read back
+                constexpr bool Aligned = aligned_packet_access<DstType>::value && aligned_packet_access<SrcType>::value;
+                constexpr int StorageSize = traits<DstType>::OuterStride * traits<DstType>::OuterSize;
+                for (int i = 0; i < StorageSize; i += PacketSize)
+                {
+                    dst.template writePacket<Packet, Aligned>(i, func.assignPacket(dst.template packet<Packet, Aligned>(i),
+                                                                                   src.template packet<Packet, Aligned>(i)));
+                }
+            }
+            else if constexpr (traits<DstType>::HasLinearAccess && traits<SrcType>::HasLinearAccess)
+            {
+                const int Size = numRows * numCols;
+                int i = 0;
+                if constexpr (PacketSize > 1 && traits<DstType>::HasPacketAccess && traits<SrcType>::HasPacketAccess)
+                {
+                    constexpr bool Aligned = aligned_packet_access<DstType>::value && aligned_packet_access<SrcType>::value;
+                    const int FullSize = Size / PacketSize * PacketSize;
+                    for (; i < FullSize; i += PacketSize)
+                    {
+                        dst.template writePacket<Packet, Aligned>(i, func.assignPacket(dst.template packet<Packet, Aligned>(i),
+                                                                                       src.template packet<Packet, Aligned>(i)));
+                    }
+                }
+                for (; i < Size; ++i)
+                {
+                    func.assignCoeff(dst.coeffRef(i), src.coeff(i));
+                }
+            }
+            else if constexpr (coeff_packet_access<DstType, SrcType>::value)
+            {
+                // packets down each column (along each row when row-major) from its first coefficient, scalar tail
+                constexpr bool RowMajor = traits<DstType>::IsRowMajor;
+                const int innerSize = RowMajor ? numCols : numRows;
+                const int outerSize = RowMajor ? numRows : numCols;
+                const int fullInner = innerSize / PacketSize * PacketSize;
+                for (int j = 0; j < outerSize; ++j)
+                {
+                    int i = 0;
+                    for (; i < fullInner; i += PacketSize)
+                    {
+                        const int row = RowMajor ? j : i;
+                        const int col = RowMajor ? i : j;
+                        dst.template writePacket<Packet>(row, col, func.assignPacket(dst.template packet<Packet>(row, col),
+                                                                                     src.template packet<Packet>(row, col)));
+                    }
+                    for (; i < innerSize; ++i)
+                    {
+                        const int row = RowMajor ? j : i;
+                        const int col = RowMajor ? i : j;
+                        func.assignCoeff(dst.coeffRef(row, col), src.coeff(row, col));
+                    }
+                }
+            }
+            else if constexpr (traits<DstType>::IsRowMajor)
             {
-                ScalarType tmp[subRows * subCols];
-                memcpy(tmp, &(this->operator()(0)), sizeof(ScalarType) * subRows * subCols);
-                memcpy(&(this->operator()(0)), &(other(0)), sizeof(ScalarType) * subRows * subCols);
-                memcpy(&(other(0)), tmp, sizeof(ScalarType) * subRows * subCols);
+                for (int i = 0; i < numRows; ++i)
+                {
+                    for (int j = 0; j < numCols; ++j)
+                    {
+                        func.assignCoeff(dst.coeffRef(i, j), src.coeff(i, j));
+                    }
+                }
             }
             else
             {
-                for (int i = 0; i < subSize; ++i)
+                for (int j = 0; j < numCols; ++j)
                 {
-                    ScalarType tmp = this->operator()(i);
-                    this->operator()(i) = other(i);
-                    other(i) = tmp;
+                    for (int i = 0; i < numRows; ++i)
+                    {
+                        func.assignCoeff(dst.coeffRef(i, j), src.coeff(i, j));
+                    }
                 }
             }
             return;
         }
-    };
 
-    template <typename ScalarType, int rows, int cols>
-    class EmbeddedCoreType
-    {
-    protected:
-        ScalarType Elements[rows * cols];
-        static constexpr int size = rows * cols;
+        // dst may be an operand of the product, which is evaluated into a temporary first
+        template <typename DstType, typename LhsType, typename RhsType, typename Functor>
+        constexpr void call_assignment(DstType &dst, const EmbeddedProductType<LhsType, RhsType> &src, const Functor &func)
+        {
+            const typename traits<EmbeddedProductType<LhsType, RhsType>>::PlainObject result(src);
+            call_assignment(dst, result, func);
+        }
 
-    public:
-        using Scalar = ScalarType;
-        static constexpr int RowsAtCompileTime = rows;
-        static constexpr int ColsAtCompileTime = cols;
-        static constexpr int MaxRankAtCompileTime = (RowsAtCompileTime < ColsAtCompileTime) ? RowsAtCompileTime : ColsAtCompileTime;
-        static constexpr int MaxDimAtCompileTime = (RowsAtCompileTime > ColsAtCompileTime) ? RowsAtCompileTime : ColsAtCompileTime;
+        template <typename DstType, typename LhsType, typename RhsType, typename Functor>
+        constexpr void product_assignment(DstType &dst, const EmbeddedProductType<LhsType, RhsType> &src, const Functor &func);
 
-        EmbeddedCoreType()
+        // copies the lower triangle of a column-major matrix to the upper one, gathering each column of the upper
+        // triangle from its row in packets
+        template <typename T>
+        inline void mirror_lower_columns(T *data, int stride, int size)
         {
-            memset(Elements, (ScalarType)0, sizeof(ScalarType) * size);
+            using Packet = typename packet_traits<T>::type;
+            constexpr int PacketSize = packet_traits<T>::size;
+            for (int j = 1; j < size; ++j)
+            {
+                T *col = data + j * stride;
+                const T *row = data + j;
+                int i = 0;
+                for (; i + PacketSize <= j; i += PacketSize)
+                {
+                    Packet p;
+                    for (int l = 0; l < PacketSize; ++l)
+                    {
+                        p[l] = row[(i + l) * stride];
+                    }
+                    pstoreu(col + i, p);
+                }
+                for (; i < j; ++i)
+                {
+                    col[i] = row[i * stride];
+                }
+            }
         }
 
-        EmbeddedCoreType(const EmbeddedCoreType &other)
+        // copies the UpLo triangle of a square matrix to the other one
+        template <int UpLo, typename DstType>
+        constexpr void mirror_triangle(DstType &dst)
         {
-            static_assert((this->RowsAtCompileTime == other.RowsAtCompileTime) && (this->ColsAtCompileTime == other.ColsAtCompileTime));
-            memcpy(this->Elements, other.data(), sizeof(ScalarType) * size);
+            constexpr bool Columns = UpLo == Lower && packet_traits<typename traits<DstType>::Scalar>::size > 1 &&
+                                     traits<DstType>::HasDirectAccess && !traits<DstType>::IsRowMajor && traits<DstType>::MapInnerStride == 1;
+            const int size = dst.rows();
+            if (is_constant_evaluated() || !Columns)
+            {
+                for (int j = 1; j < size; ++j)
+                {
+                    for (int i = 0; i < j; ++i)
+                    {
+                        if constexpr (UpLo == Lower)
+                            dst.coeffRef(i, j) = dst.coeff(j, i);
+                        else
+                            dst.coeffRef(j, i) = dst.coeff(i, j);
+                    }
+                }
+            }
+            else if constexpr (Columns)
+            {
+                mirror_lower_columns(dst.data(), dst.outerStride(), size);
+            }
         }
 
-        template <int RefRows, int RefCols>
-        EmbeddedCoreType(const EmbeddedRefType<ScalarType, RefRows, RefCols> &other)
+        // a self-adjoint view is copied as a whole, which the packet loops do, and its stored triangle then
+        // mirrored inside dst. This also holds when dst is the viewed matrix.
+        template <typename DstType, typename XprType, int UpLo>
+        constexpr void call_assignment(DstType &dst, const EmbeddedSelfAdjointView<XprType, UpLo> &src, const assign_op &func)
         {
-            for (int i = 0; i < size; ++i)
+            call_assignment(dst, src.nestedExpression(), func);
+            mirror_triangle<UpLo>(dst);
+        }
+
+        // a packed symmetric matrix is expanded into the lower triangle of dst, one packed column after the
+        // other, and that triangle then mirrored
+        template <typename DstType, typename ScalarType, int N>
+        constexpr void call_assignment(DstType &dst, const EmbeddedSymmetricType<ScalarType, N> &src, const assign_op &)
+        {
+            const ScalarType *column = src.data();
+            for (int j = 0; j < N; ++j)
             {
-                this->operator()(i) = other(i);
+                for (int i = j; i < N; ++i)
+                {
+                    dst.coeffRef(i, j) = column[i - j];
+                }
+                column += N - j;
             }
+            mirror_triangle<Lower>(dst);
         }
 
-        EmbeddedCoreType(const ScalarType value)
+        // sizes and offsets of the block rows and block columns of a structured matrix and the kind of every block
+        template <typename RowBlocks, typename ColBlocks, typename Pattern>
+        struct block_layout;
+
+        template <int... RowSizes, int... ColSizes, int... Kinds>
+        struct block_layout<BlockSizes<RowSizes...>, BlockSizes<ColSizes...>, BlockPattern<Kinds...>>
         {
-            for (int i = 0; i < size; ++i)
+            static constexpr int BlockRows = static_cast<int>(sizeof...(RowSizes));
+            static constexpr int BlockCols = static_cast<int>(sizeof...(ColSizes));
+            static constexpr int Rows = (0 + ... + RowSizes);
+            static constexpr int Cols = (0 + ... + ColSizes);
+            static constexpr int rowSize[] = {RowSizes...};
+            static constexpr int colSize[] = {ColSizes...};
+            static constexpr int kind[] = {Kinds...};
+            static_assert(static_cast<int>(sizeof...(Kinds)) == BlockRows * BlockCols, "the pattern needs one kind per block");
+
+            static constexpr int rowOffset(int bi)
             {
-                Elements[i] = value;
+                int offset = 0;
+                for (int b = 0; b < bi; ++b)
+                {
+                    offset += rowSize[b];
+                }
+                return offset;
+            }
+
+            static constexpr int colOffset(int bj)
+            {
+                int offset = 0;
+                for (int b = 0; b < bj; ++b)
+                {
+                    offset += colSize[b];
+                }
+                return offset;
+            }
+
+            static constexpr int kindOf(int bi, int bj)
+            {
+                return kind[bi * BlockCols + bj];
+            }
+
+            // the dense blocks are stored one after the other, block row after block row, each column-major
+            static constexpr int denseOffset(int bi, int bj)
+            {
+                int offset = 0;
+                for (int b = 0; b < bi * BlockCols + bj; ++b)
+                {
+                    if (kind[b] == DenseBlock)
+                        offset += rowSize[b / BlockCols] * colSize[b % BlockCols];
+                }
+                return offset;
+            }
+
+            // first block of block row bi that is not zero, -1 when they all are
+            static constexpr int firstInRow(int bi)
+            {
+                for (int bj = 0; bj < BlockCols; ++bj)
+                {
+                    if (kindOf(bi, bj) != ZeroBlock)
+                        return bj;
+                }
+                return -1;
+            }
+
+            // first block of block column bj that is not zero, -1 when they all are
+            static constexpr int firstInColumn(int bj)
+            {
+                for (int bi = 0; bi < BlockRows; ++bi)
+                {
+                    if (kindOf(bi, bj) != ZeroBlock)
+                        return bi;
+                }
+                return -1;
+            }
+
+            static constexpr bool validKinds()
+            {
+                for (int b = 0; b < BlockRows * BlockCols; ++b)
+                {
+                    if (kind[b] != ZeroBlock && kind[b] != IdentityBlock && kind[b] != DenseBlock)
+                        return false;
+                    if (kind[b] == IdentityBlock && rowSize[b / BlockCols] != colSize[b % BlockCols])
+                        return false;
+                }
+                return true;
+            }
+        };
+
+        // compile-time layout of a structured matrix, with the number of coefficients its dense blocks take
+        template <typename RowBlocks, typename ColBlocks, typename Pattern>
+        struct block_structure : block_layout<RowBlocks, ColBlocks, Pattern>
+        {
+            using Layout = block_layout<RowBlocks, ColBlocks, Pattern>;
+            static_assert(Layout::validKinds(), "blocks are ZeroBlock, DenseBlock or a square IdentityBlock");
+            static constexpr int DenseSize = Layout::denseOffset(Layout::BlockRows, 0);
+        };
+
+        template <int BlockCols, typename Function, int... Bs>
+        inline void for_each_block(const Function &function, std::integer_sequence<int, Bs...>)
+        {
+            (function(std::integral_constant<int, Bs / BlockCols>(), std::integral_constant<int, Bs % BlockCols>()), ...);
+        }
+
+        // calls function(bi, bj) for every block, block row after block row, the indices being integral constants
+        template <typename Structure, typename Function>
+        inline void for_each_block(const Function &function)
+        {
+            for_each_block<Structure::BlockCols>(function, std::make_integer_sequence<int, Structure::BlockRows * Structure::BlockCols>());
+        }
+
+        // a structured matrix is assigned block by block: zero blocks only clear dst when assigned, identity
+        // blocks only touch the diagonal and dense blocks go through the packet loops
+        template <typename DstType, typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern, typename Functor>
+        inline void call_assignment(DstType &dst, const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &src, const Functor &func)
+        {
+            using Structure = block_structure<RowBlocks, ColBlocks, Pattern>;
+            constexpr bool Assign = std::is_same<Functor, assign_op>::value;
+            for_each_block<Structure>([&](auto bi, auto bj)
+                                      {
+                constexpr int BI = decltype(bi)::value, BJ = decltype(bj)::value;
+                constexpr int Kind = Structure::kindOf(BI, BJ);
+                constexpr int Row = Structure::rowOffset(BI), Col = Structure::colOffset(BJ);
+                auto block = dst.template block<Structure::rowSize[BI], Structure::colSize[BJ]>(Row, Col);
+                if constexpr (Kind == DenseBlock)
+                {
+                    call_assignment(block, src.template denseBlock<BI, BJ>(), func);
+                }
+                else
+                {
+                    if constexpr (Assign)
+                        block.setZero();
+                    if constexpr (Kind == IdentityBlock)
+                    {
+                        for (int d = 0; d < Structure::rowSize[BI]; ++d)
+                        {
+                            func.assignCoeff(block.coeffRef(d, d), ScalarType(1));
+                        }
+                    }
+                } });
+        }
+
+        // assignment to a dst that src does not read, e.g. one being constructed or one marked by noalias():
+        // products are then computed straight into dst
+        template <typename DstType, typename SrcType, typename Functor>
+        constexpr void call_assignment_no_alias(DstType &dst, const SrcType &src, const Functor &func)
+        {
+            if constexpr (is_product<SrcType>::value)
+                product_assignment(dst, src, func);
+            else
+                call_assignment(dst, src, func);
+        }
+
+        // a bounded matrix keeps its coefficients packed for the current size, so its leading dimension is
+        // only known at runtime (OuterStride is Dynamic) and it has linear access unless row-major
+        template <typename ScalarType, int rows, int cols, int Options, int MaxRows, int MaxCols>
+        struct traits<EmbeddedCoreType<ScalarType, rows, cols, Options, MaxRows, MaxCols>>
+        {
+            using Scalar = ScalarType;
+            using PlainObject = EmbeddedCoreType<ScalarType, rows, cols, Options, MaxRows, MaxCols>;
+            static constexpr int RowsAtCompileTime = rows;
+            static constexpr int ColsAtCompileTime = cols;
+            static constexpr int MaxRowsAtCompileTime = MaxRows;
+            static constexpr int MaxColsAtCompileTime = MaxCols;
+            static constexpr bool IsDynamic = rows == Dynamic || cols == Dynamic;
+            static constexpr int SizeAtCompileTime = IsDynamic ? Dynamic : rows * cols;
+            static constexpr bool IsRowMajor = storage_layout<ScalarType, rows, cols, Options>::IsRowMajor;
+            static constexpr int OuterSize = IsDynamic ? Dynamic : storage_layout<ScalarType, rows, cols, Options>::OuterSize;
+            static constexpr int OuterStride = IsDynamic ? Dynamic : storage_layout<ScalarType, rows, cols, Options>::OuterStride;
+            static constexpr int Alignment = storage_layout<ScalarType, rows, cols, Options>::Alignment;
+            static constexpr bool HasLinearAccess = (!IsRowMajor && (IsDynamic || OuterStride == rows)) || (cols == 1) || (rows == 1);
+            static constexpr bool HasPacketAccess = true;
+            static constexpr bool HasCoeffPacketAccess = true;
+            static constexpr bool NestByRef = true;
+            static constexpr bool HasDirectAccess = true;
+            static constexpr int MapOuterStride = OuterStride;
+            static constexpr int MapInnerStride = 1;
+        };
+
+        // expressions describe their operands as they hold them, so products among them count as plain matrices
+        template <typename BinaryOp, typename LhsXpr, typename RhsXpr>
+        struct traits<EmbeddedCwiseBinaryOp<BinaryOp, LhsXpr, RhsXpr>>
+        {
+            using LhsType = nested_t<LhsXpr>;
+            using RhsType = nested_t<RhsXpr>;
+            using Scalar = typename traits<LhsType>::Scalar;
+            using PlainObject = typename traits<LhsType>::PlainObject;
+            static constexpr int RowsAtCompileTime = traits<LhsType>::RowsAtCompileTime;
+            static constexpr int ColsAtCompileTime = traits<LhsType>::ColsAtCompileTime;
+            static constexpr int SizeAtCompileTime = traits<LhsType>::SizeAtCompileTime;
+            static constexpr bool IsRowMajor = traits<LhsType>::IsRowMajor;
+            static constexpr int OuterSize = traits<LhsType>::OuterSize;
+            static constexpr int OuterStride = same_layout<LhsType, RhsType>::value ? traits<LhsType>::OuterStride : -1;
+            static constexpr int Alignment = (traits<LhsType>::Alignment < traits<RhsType>::Alignment) ? traits<LhsType>::Alignment : traits<RhsType>::Alignment;
+            static constexpr bool HasLinearAccess = traits<LhsType>::HasLinearAccess && traits<RhsType>::HasLinearAccess;
+            static constexpr bool HasPacketAccess = traits<LhsType>::HasPacketAccess && traits<RhsType>::HasPacketAccess && BinaryOp::PacketAccess;
+            static constexpr bool HasCoeffPacketAccess = traits<LhsType>::HasCoeffPacketAccess && traits<RhsType>::HasCoeffPacketAccess &&
+                                                         traits<LhsType>::IsRowMajor == traits<RhsType>::IsRowMajor && BinaryOp::PacketAccess;
+            static constexpr bool NestByRef = false;
+            static constexpr bool HasDirectAccess = false;
+        };
+
+        template <typename UnaryOp, typename Xpr>
+        struct traits<EmbeddedCwiseUnaryOp<UnaryOp, Xpr>>
+        {
+            using XprType = nested_t<Xpr>;
+            using Scalar = typename traits<XprType>::Scalar;
+            using PlainObject = typename traits<XprType>::PlainObject;
+            static constexpr int RowsAtCompileTime = traits<XprType>::RowsAtCompileTime;
+            static constexpr int ColsAtCompileTime = traits<XprType>::ColsAtCompileTime;
+            static constexpr int SizeAtCompileTime = traits<XprType>::SizeAtCompileTime;
+            static constexpr bool IsRowMajor = traits<XprType>::IsRowMajor;
+            static constexpr int OuterSize = traits<XprType>::OuterSize;
+            static constexpr int OuterStride = traits<XprType>::OuterStride;
+            static constexpr int Alignment = traits<XprType>::Alignment;
+            static constexpr bool HasLinearAccess = traits<XprType>::HasLinearAccess;
+            static constexpr bool HasPacketAccess = traits<XprType>::HasPacketAccess && UnaryOp::PacketAccess;
+            static constexpr bool HasCoeffPacketAccess = traits<XprType>::HasCoeffPacketAccess && UnaryOp::PacketAccess;
+            static constexpr bool NestByRef = false;
+            static constexpr bool HasDirectAccess = false;
+        };
+
+        // plain type of a transpose, keeping the storage options and swapping the bounds
+        template <typename PlainType>
+        struct transpose_plain;
+
+        template <typename ScalarType, int rows, int cols, int Options, int MaxRows, int MaxCols>
+        struct transpose_plain<EmbeddedCoreType<ScalarType, rows, cols, Options, MaxRows, MaxCols>>
+        {
+            using type = EmbeddedCoreType<ScalarType, cols, rows, Options, MaxCols, MaxRows>;
+        };
+
+        // distances between columns and inside a column of an expression with direct access, Dynamic otherwise
+        template <typename T, bool = traits<T>::HasDirectAccess>
+        struct direct_strides
+        {
+            static constexpr int Outer = Dynamic;
+            static constexpr int Inner = Dynamic;
+        };
+
+        template <typename T>
+        struct direct_strides<T, true>
+        {
+            static constexpr int Outer = traits<T>::MapOuterStride;
+            static constexpr int Inner = traits<T>::MapInnerStride;
+        };
+
+        // A transpose reads the storage of its expression in the other order: the storage walk, the packets along
+        // the inner dimension and direct access are those of the expression, linear access only stays for vectors
+        template <typename Xpr>
+        struct traits<EmbeddedTransposeType<Xpr>>
+        {
+            using XprType = nested_t<Xpr>;
+            using Scalar = typename traits<XprType>::Scalar;
+            using PlainObject = typename transpose_plain<typename traits<XprType>::PlainObject>::type;
+            static constexpr int RowsAtCompileTime = traits<XprType>::ColsAtCompileTime;
+            static constexpr int ColsAtCompileTime = traits<XprType>::RowsAtCompileTime;
+            static constexpr int SizeAtCompileTime = traits<XprType>::SizeAtCompileTime;
+            static constexpr bool IsRowMajor = !traits<XprType>::IsRowMajor;
+            static constexpr int OuterSize = traits<XprType>::OuterSize;
+            static constexpr int OuterStride = traits<XprType>::OuterStride;
+            static constexpr int Alignment = traits<XprType>::Alignment;
+            static constexpr bool HasLinearAccess = traits<XprType>::HasLinearAccess && (RowsAtCompileTime == 1 || ColsAtCompileTime == 1);
+            static constexpr bool HasPacketAccess = traits<XprType>::HasPacketAccess;
+            static constexpr bool HasCoeffPacketAccess = traits<XprType>::HasCoeffPacketAccess;
+            static constexpr bool NestByRef = false;
+            static constexpr bool HasDirectAccess = traits<XprType>::HasDirectAccess;
+            static constexpr int MapOuterStride = direct_strides<XprType>::Outer;
+            static constexpr int MapInnerStride = direct_strides<XprType>::Inner;
+        };
+
+        template <typename T>
+        struct is_transpose : std::false_type
+        {
+        };
+
+        template <typename XprType>
+        struct is_transpose<EmbeddedTransposeType<XprType>> : std::true_type
+        {
+        };
+
+        // Triangular and self-adjoint views read their square matrix or expression coefficient by coefficient,
+        // picking a triangle, so they have neither packet nor linear access. Products evaluate them into the
+        // plain type of the matrix first.
+        template <typename Xpr>
+        struct triangular_view_traits
+        {
+            using XprType = nested_t<Xpr>;
+            using Scalar = typename traits<XprType>::Scalar;
+            using PlainObject = typename traits<XprType>::PlainObject;
+            static constexpr int RowsAtCompileTime = traits<XprType>::RowsAtCompileTime;
+            static constexpr int ColsAtCompileTime = traits<XprType>::ColsAtCompileTime;
+            static constexpr int SizeAtCompileTime = traits<XprType>::SizeAtCompileTime;
+            static constexpr bool IsRowMajor = traits<PlainObject>::IsRowMajor;
+            static constexpr int OuterSize = traits<PlainObject>::OuterSize;
+            static constexpr int OuterStride = Dynamic;
+            static constexpr int Alignment = static_cast<int>(alignof(Scalar));
+            static constexpr bool HasLinearAccess = false;
+            static constexpr bool HasPacketAccess = false;
+            static constexpr bool HasCoeffPacketAccess = false;
+            static constexpr bool NestByRef = false;
+            static constexpr bool HasDirectAccess = false;
+        };
+
+        template <typename Xpr, int Mode>
+        struct traits<EmbeddedTriangularView<Xpr, Mode>> : triangular_view_traits<std::remove_const_t<Xpr>>
+        {
+        };
+
+        template <typename Xpr, int UpLo>
+        struct traits<EmbeddedSelfAdjointView<Xpr, UpLo>> : triangular_view_traits<std::remove_const_t<Xpr>>
+        {
+        };
+
+        // A packed symmetric matrix reads like the full N x N matrix it evaluates to, but its storage only holds
+        // the lower triangle: it has neither packet, linear nor direct access. It is held by reference like a
+        // plain matrix, and products with it go to the packed kernels or evaluate it first.
+        template <typename ScalarType, int N>
+        struct traits<EmbeddedSymmetricType<ScalarType, N>>
+        {
+            using Scalar = ScalarType;
+            using PlainObject = EmbeddedCoreType<ScalarType, N, N>;
+            static constexpr int RowsAtCompileTime = N;
+            static constexpr int ColsAtCompileTime = N;
+            static constexpr int SizeAtCompileTime = N * N;
+            static constexpr bool IsRowMajor = false;
+            static constexpr int OuterSize = N;
+            static constexpr int OuterStride = Dynamic;
+            static constexpr int Alignment = static_cast<int>(alignof(Scalar));
+            static constexpr bool HasLinearAccess = false;
+            static constexpr bool HasPacketAccess = false;
+            static constexpr bool HasCoeffPacketAccess = false;
+            static constexpr bool NestByRef = true;
+            static constexpr bool HasDirectAccess = false;
+        };
+
+        // A structured matrix only stores its dense blocks, so like a packed symmetric one it reads like the plain
+        // matrix it evaluates to without packet, linear or direct access. Products and assignments go block by
+        // block.
+        template <typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern>
+        struct traits<EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern>>
+        {
+            using Structure = block_structure<RowBlocks, ColBlocks, Pattern>;
+            using Scalar = ScalarType;
+            using PlainObject = EmbeddedCoreType<ScalarType, Structure::Rows, Structure::Cols>;
+            static constexpr int RowsAtCompileTime = Structure::Rows;
+            static constexpr int ColsAtCompileTime = Structure::Cols;
+            static constexpr int SizeAtCompileTime = Structure::Rows * Structure::Cols;
+            static constexpr bool IsRowMajor = traits<PlainObject>::IsRowMajor;
+            static constexpr int OuterSize = traits<PlainObject>::OuterSize;
+            static constexpr int OuterStride = Dynamic;
+            static constexpr int Alignment = static_cast<int>(alignof(Scalar));
+            static constexpr bool HasLinearAccess = false;
+            static constexpr bool HasPacketAccess = false;
+            static constexpr bool HasCoeffPacketAccess = false;
+            static constexpr bool NestByRef = true;
+            static constexpr bool HasDirectAccess = false;
+        };
+
+        // Views over existing storage (blocks, maps and refs) point at their first coefficient. MapOuterStride and
+        // MapInnerStride are the distances between two columns (rows when row-major) and between two coefficients
+        // of a column, Dynamic when only known at runtime. OuterStride is only set when the view can be walked as
+        // one piece of storage, with whole columns and nothing but padding between them. The start of a view is
+        // not known at compile time, so nor is its alignment.
+        template <typename PlainType, bool RowMajor, int Outer, int Inner, int WalkStride, bool IsConst>
+        struct view_traits
+        {
+            using Scalar = typename traits<PlainType>::Scalar;
+            using PlainObject = PlainType;
+            static constexpr int RowsAtCompileTime = traits<PlainType>::RowsAtCompileTime;
+            static constexpr int ColsAtCompileTime = traits<PlainType>::ColsAtCompileTime;
+            static constexpr int SizeAtCompileTime = traits<PlainType>::SizeAtCompileTime;
+            static constexpr bool IsRowMajor = RowMajor;
+            static constexpr int InnerSize = IsRowMajor ? ColsAtCompileTime : RowsAtCompileTime;
+            static constexpr int OuterSize = IsRowMajor ? RowsAtCompileTime : ColsAtCompileTime;
+            static constexpr int OuterStride = WalkStride;
+            static constexpr int Alignment = static_cast<int>(alignof(Scalar));
+            static constexpr bool HasLinearAccess = Inner == 1 && (IsRowMajor ? RowsAtCompileTime == 1 : (ColsAtCompileTime == 1 || WalkStride == RowsAtCompileTime));
+            static constexpr bool HasPacketAccess = Inner == 1;
+            static constexpr bool HasCoeffPacketAccess = Inner == 1;
+            static constexpr bool NestByRef = false;
+            static constexpr bool HasDirectAccess = true;
+            static constexpr int MapOuterStride = Outer;
+            static constexpr int MapInnerStride = Inner;
+            static constexpr bool IsConstView = IsConst;
+        };
+
+        // true when the coefficients of T are read-only through data()
+        template <typename T>
+        struct has_const_data
+        {
+            static constexpr bool value = std::is_const<std::remove_pointer_t<decltype(std::declval<T &>().data())>>::value;
+        };
+
+        // a block keeps the strides of the matrix or view it is taken from, and can be walked like it when it
+        // spans its whole columns (rows when row-major)
+        template <typename XprType, int BlockRows, int BlockCols>
+        struct traits<EmbeddedBlockType<XprType, BlockRows, BlockCols>>
+            : view_traits<EmbeddedCoreType<typename traits<XprType>::Scalar, BlockRows, BlockCols>, traits<XprType>::IsRowMajor,
+                          traits<XprType>::MapOuterStride, traits<XprType>::MapInnerStride,
+                          (traits<XprType>::IsRowMajor ? BlockCols == traits<XprType>::ColsAtCompileTime : BlockRows == traits<XprType>::RowsAtCompileTime)
+                              ? traits<XprType>::OuterStride
+                              : Dynamic,
+                          has_const_data<XprType>::value>
+        {
+        };
+
+        // strides of a map, 0 in StrideType standing for the layout of the mapped type. A strided buffer is never
+        // walked as one piece of storage, its gaps may hold other data.
+        template <typename PlainObjectType, typename StrideType>
+        struct map_strides
+        {
+            using PlainType = std::remove_const_t<PlainObjectType>;
+            static constexpr int InnerSize = traits<PlainType>::IsRowMajor ? traits<PlainType>::ColsAtCompileTime : traits<PlainType>::RowsAtCompileTime;
+            static constexpr int Outer = (StrideType::OuterStrideAtCompileTime == 0) ? traits<PlainType>::OuterStride : StrideType::OuterStrideAtCompileTime;
+            static constexpr int Inner = (StrideType::InnerStrideAtCompileTime == 0) ? 1 : StrideType::InnerStrideAtCompileTime;
+            static constexpr int WalkStride = (Inner == 1 && Outer == InnerSize) ? Outer : Dynamic;
+        };
+
+        template <typename PlainObjectType, typename StrideType>
+        struct traits<EmbeddedMapType<PlainObjectType, StrideType>>
+            : view_traits<std::remove_const_t<PlainObjectType>, traits<PlainObjectType>::IsRowMajor,
+                          map_strides<PlainObjectType, StrideType>::Outer, map_strides<PlainObjectType, StrideType>::Inner,
+                          map_strides<PlainObjectType, StrideType>::WalkStride, std::is_const<PlainObjectType>::value>
+        {
+        };
+
+        // a ref has consecutive coefficients along the inner dimension and a leading dimension only known at runtime
+        template <typename PlainObjectType>
+        struct traits<EmbeddedMatrixRef<PlainObjectType>>
+            : view_traits<std::remove_const_t<PlainObjectType>, traits<PlainObjectType>::IsRowMajor, Dynamic, 1, Dynamic,
+                          std::is_const<PlainObjectType>::value>
+        {
+        };
+
+        template <typename T>
+        struct is_view
+        {
+            static constexpr bool value = std::is_base_of<EmbeddedMapBase<T>, T>::value;
+        };
+
+        // true when a Ref to PlainType can point into the storage of T: a matrix or view of the same size and
+        // storage order, with consecutive coefficients along the inner dimension
+        template <typename PlainType, typename T, bool = traits<T>::HasDirectAccess>
+        struct ref_compatible
+        {
+            static constexpr bool value = false;
+        };
+
+        template <typename PlainType, typename T>
+        struct ref_compatible<PlainType, T, true>
+        {
+            static constexpr bool value = traits<T>::RowsAtCompileTime == traits<PlainType>::RowsAtCompileTime &&
+                                          traits<T>::ColsAtCompileTime == traits<PlainType>::ColsAtCompileTime &&
+                                          traits<T>::IsRowMajor == traits<PlainType>::IsRowMajor && traits<T>::MapInnerStride == 1;
+        };
+
+        // true when a product has an operand with a Dynamic dimension
+        template <typename LhsType, typename RhsType>
+        struct is_bounded_product
+        {
+            static constexpr bool value = traits<LhsType>::SizeAtCompileTime == Dynamic || traits<RhsType>::SizeAtCompileTime == Dynamic;
+        };
+
+        // result of such a product: Dynamic where the operands are, bounded by their maximum sizes
+        template <typename LhsType, typename RhsType>
+        struct bounded_product_type
+        {
+            using LhsPlain = typename traits<LhsType>::PlainObject;
+            using RhsPlain = typename traits<RhsType>::PlainObject;
+            using type = EmbeddedCoreType<typename traits<LhsType>::Scalar, traits<LhsType>::RowsAtCompileTime, traits<RhsType>::ColsAtCompileTime,
+                                          DefaultStorage, LhsPlain::MaxRowsAtCompileTime, RhsPlain::MaxColsAtCompileTime>;
+        };
+
+        // views, and transposes of matrices or views, are used in place by products, other operands as selected
+        // by eval_selector. Transposes up to 3x3 are copied, which is cheaper than a generic loop in place
+        // when they then go to the unrolled kernels.
+        template <typename T>
+        struct product_operand
+        {
+            static constexpr bool SmallTranspose = traits<T>::RowsAtCompileTime != Dynamic && traits<T>::RowsAtCompileTime <= 3 &&
+                                                   traits<T>::ColsAtCompileTime != Dynamic && traits<T>::ColsAtCompileTime <= 3;
+            static constexpr bool InPlace = is_view<T>::value || (is_transpose<T>::value && traits<T>::HasDirectAccess && !SmallTranspose);
+            using type = std::conditional_t<InPlace, const T &, typename eval_selector<T>::type>;
+            using plain = std::remove_cv_t<std::remove_reference_t<type>>;
+        };
+
+        template <typename PlainType>
+        struct plain_options;
+
+        template <typename ScalarType, int rows, int cols, int Options, int MaxRows, int MaxCols>
+        struct plain_options<EmbeddedCoreType<ScalarType, rows, cols, Options, MaxRows, MaxCols>>
+        {
+            static constexpr int value = Options;
+        };
+
+        // plain result of a product: bounded when an operand has a Dynamic dimension, column-major when an
+        // operand is read in place, and otherwise keeping the storage options of lhs
+        template <typename LhsType, typename RhsType>
+        struct product_type
+        {
+            using Scalar = typename traits<LhsType>::Scalar;
+            static constexpr int Rows = traits<LhsType>::RowsAtCompileTime;
+            static constexpr int Cols = traits<RhsType>::ColsAtCompileTime;
+            using LhsPlain = typename traits<typename product_operand<LhsType>::plain>::PlainObject;
+            using type = std::conditional_t<is_bounded_product<LhsType, RhsType>::value, typename bounded_product_type<LhsType, RhsType>::type,
+                                            std::conditional_t<product_operand<LhsType>::InPlace || product_operand<RhsType>::InPlace,
+                                                               EmbeddedCoreType<Scalar, Rows, Cols>,
+                                                               EmbeddedCoreType<Scalar, Rows, Cols, plain_options<LhsPlain>::value>>>;
+        };
+
+        // a product is only ever evaluated as a whole, coefficient by coefficient or into a plain matrix,
+        // so it has neither packet nor linear access of its own
+        template <typename LhsXpr, typename RhsXpr>
+        struct traits<EmbeddedProductType<LhsXpr, RhsXpr>>
+        {
+            using LhsType = nested_t<LhsXpr>;
+            using RhsType = nested_t<RhsXpr>;
+            using Scalar = typename traits<LhsType>::Scalar;
+            using PlainObject = typename product_type<LhsType, RhsType>::type;
+            static constexpr int RowsAtCompileTime = traits<LhsType>::RowsAtCompileTime;
+            static constexpr int ColsAtCompileTime = traits<RhsType>::ColsAtCompileTime;
+            static constexpr int SizeAtCompileTime = traits<PlainObject>::SizeAtCompileTime;
+            static constexpr bool IsRowMajor = traits<PlainObject>::IsRowMajor;
+            static constexpr int OuterSize = traits<PlainObject>::OuterSize;
+            static constexpr int OuterStride = Dynamic;
+            static constexpr int Alignment = static_cast<int>(alignof(Scalar));
+            static constexpr bool HasLinearAccess = false;
+            static constexpr bool HasPacketAccess = false;
+            static constexpr bool HasCoeffPacketAccess = false;
+            static constexpr bool NestByRef = false;
+            static constexpr bool HasDirectAccess = false;
+        };
+    }
+
+    // Common base of matrices and lazy expressions.
+    // Arithmetic on it only builds expression nodes; nothing is computed until the expression is
+    // assigned to an EmbeddedCoreType or a block, where all operators are fused into one loop.
+    template <typename Derived>
+    class EmbeddedExprBase
+    {
+    public:
+        using Scalar = typename internal::traits<Derived>::Scalar;
+        using PlainObject = typename internal::traits<Derived>::PlainObject;
+        static constexpr int RowsAtCompileTime = internal::traits<Derived>::RowsAtCompileTime;
+        static constexpr int ColsAtCompileTime = internal::traits<Derived>::ColsAtCompileTime;
+        static constexpr int SizeAtCompileTime = internal::traits<Derived>::SizeAtCompileTime;
+
+        constexpr Derived &derived() { return *static_cast<Derived *>(this); }
+        constexpr const Derived &derived() const { return *static_cast<const Derived *>(this); }
+
+        // compile-time constants, except along a Dynamic dimension where the expression gives its runtime size
+        constexpr int rows() const
+        {
+            if constexpr (RowsAtCompileTime == Dynamic)
+                return derived().rows();
+            else
+                return RowsAtCompileTime;
+        }
+
+        constexpr int cols() const
+        {
+            if constexpr (ColsAtCompileTime == Dynamic)
+                return derived().cols();
+            else
+                return ColsAtCompileTime;
+        }
+
+        constexpr int size() const
+        {
+            if constexpr (SizeAtCompileTime == Dynamic)
+                return rows() * cols();
+            else
+                return SizeAtCompileTime;
+        }
+
+        template <typename OtherDerived>
+        constexpr const EmbeddedCwiseBinaryOp<internal::scalar_sum_op<Scalar>, Derived, OtherDerived>
+        operator+(const EmbeddedExprBase<OtherDerived> &other) const
+        {
+            return EmbeddedCwiseBinaryOp<internal::scalar_sum_op<Scalar>, Derived, OtherDerived>(derived(), other.derived());
+        }
+
+        template <typename OtherDerived>
+        constexpr const EmbeddedCwiseBinaryOp<internal::scalar_difference_op<Scalar>, Derived, OtherDerived>
+        operator-(const EmbeddedExprBase<OtherDerived> &other) const
+        {
+            return EmbeddedCwiseBinaryOp<internal::scalar_difference_op<Scalar>, Derived, OtherDerived>(derived(), other.derived());
+        }
+
+        constexpr const EmbeddedCwiseUnaryOp<internal::scalar_opposite_op<Scalar>, Derived> operator-() const
+        {
+            return EmbeddedCwiseUnaryOp<internal::scalar_opposite_op<Scalar>, Derived>(derived());
+        }
+
+        constexpr const EmbeddedCwiseUnaryOp<internal::scalar_multiple_op<Scalar>, Derived> operator*(const Scalar &factor) const
+        {
+            return EmbeddedCwiseUnaryOp<internal::scalar_multiple_op<Scalar>, Derived>(derived(), internal::scalar_multiple_op<Scalar>{factor});
+        }
+
+        friend constexpr const EmbeddedCwiseUnaryOp<internal::scalar_multiple_op<Scalar>, Derived> operator*(const Scalar &factor, const EmbeddedExprBase &xpr)
+        {
+            return xpr * factor;
+        }
+
+        constexpr const EmbeddedCwiseUnaryOp<internal::scalar_quotient1_op<Scalar>, Derived> operator/(const Scalar &divisor) const
+        {
+            return EmbeddedCwiseUnaryOp<internal::scalar_quotient1_op<Scalar>, Derived>(derived(), internal::scalar_quotient1_op<Scalar>{divisor});
+        }
+
+        template <typename OtherDerived>
+        constexpr const EmbeddedCwiseBinaryOp<internal::scalar_product_op<Scalar>, Derived, OtherDerived>
+        cwiseProduct(const EmbeddedExprBase<OtherDerived> &other) const
+        {
+            return EmbeddedCwiseBinaryOp<internal::scalar_product_op<Scalar>, Derived, OtherDerived>(derived(), other.derived());
+        }
+
+        template <typename OtherDerived>
+        constexpr const EmbeddedCwiseBinaryOp<internal::scalar_quotient_op<Scalar>, Derived, OtherDerived>
+        cwiseQuotient(const EmbeddedExprBase<OtherDerived> &other) const
+        {
+            return EmbeddedCwiseBinaryOp<internal::scalar_quotient_op<Scalar>, Derived, OtherDerived>(derived(), other.derived());
+        }
+
+        template <typename OtherDerived>
+        constexpr const EmbeddedCwiseBinaryOp<internal::scalar_min_op<Scalar>, Derived, OtherDerived>
+        cwiseMin(const EmbeddedExprBase<OtherDerived> &other) const
+        {
+            return EmbeddedCwiseBinaryOp<internal::scalar_min_op<Scalar>, Derived, OtherDerived>(derived(), other.derived());
+        }
+
+        template <typename OtherDerived>
+        constexpr const EmbeddedCwiseBinaryOp<internal::scalar_max_op<Scalar>, Derived, OtherDerived>
+        cwiseMax(const EmbeddedExprBase<OtherDerived> &other) const
+        {
+            return EmbeddedCwiseBinaryOp<internal::scalar_max_op<Scalar>, Derived, OtherDerived>(derived(), other.derived());
+        }
+
+        constexpr const EmbeddedCwiseUnaryOp<internal::scalar_abs_op<Scalar>, Derived> cwiseAbs() const
+        {
+            return EmbeddedCwiseUnaryOp<internal::scalar_abs_op<Scalar>, Derived>(derived());
+        }
+
+        constexpr const EmbeddedCwiseUnaryOp<internal::scalar_abs2_op<Scalar>, Derived> cwiseAbs2() const
+        {
+            return EmbeddedCwiseUnaryOp<internal::scalar_abs2_op<Scalar>, Derived>(derived());
+        }
+
+        constexpr const EmbeddedCwiseUnaryOp<internal::scalar_sqrt_op<Scalar>, Derived> cwiseSqrt() const
+        {
+            return EmbeddedCwiseUnaryOp<internal::scalar_sqrt_op<Scalar>, Derived>(derived());
+        }
+
+        // reductions below walk the expression once without materializing it
+        template <typename Functor>
+        constexpr Scalar redux(const Functor &func) const
+        {
+            Scalar result{};
+            using Packet = typename internal::packet_traits<Scalar>::type;
+            constexpr int PacketSize = internal::packet_traits<Scalar>::size;
+            constexpr bool Aligned = internal::aligned_packet_access<Derived>::value;
+            if (internal::is_constant_evaluated())
+            {
+                result = reduxCoeffs(func);
+            }
+            else if constexpr (internal::inner_packet_access<Derived>::value)
+            {
+                // full packets of every column (row when row-major) go to one accumulator, the packet holding
+                // the last coefficients of each to another, of which only the lanes inside the matrix are reduced
+                constexpr int Stride = internal::traits<Derived>::OuterStride;
+                constexpr int InnerSize = internal::traits<Derived>::IsRowMajor ? ColsAtCompileTime : RowsAtCompileTime;
+                constexpr int FullRows = InnerSize / PacketSize * PacketSize;
+                constexpr int TailRows = InnerSize - FullRows;
+                Packet full{}, tail{};
+                if constexpr (FullRows > 0)
+                    full = derived().template packet<Packet, Aligned>(0);
+                if constexpr (TailRows > 0)
+                    tail = derived().template packet<Packet, Aligned>(FullRows);
+                for (int i = PacketSize; i < FullRows; i += PacketSize)
+                {
+                    full = func.packetOp(full, derived().template packet<Packet, Aligned>(i));
+                }
+                for (int j = 1; j < internal::traits<Derived>::OuterSize; ++j)
+                {
+                    for (int i = 0; i < FullRows; i += PacketSize)
+                    {
+                        full = func.packetOp(full, derived().template packet<Packet, Aligned>(j * Stride + i));
+                    }
+                    if constexpr (TailRows > 0)
+                        tail = func.packetOp(tail, derived().template packet<Packet, Aligned>(j * Stride + FullRows));
+                }
+                if constexpr (FullRows > 0 && TailRows > 0)
+                    result = func(internal::predux<Scalar>(full, func), internal::predux<Scalar>(tail, func, TailRows));
+                else if constexpr (FullRows > 0)
+                    result = internal::predux<Scalar>(full, func);
+                else
+                    result = internal::predux<Scalar>(tail, func, TailRows);
+            }
+            else if constexpr (internal::traits<Derived>::HasLinearAccess && internal::traits<Derived>::HasPacketAccess &&
+                               PacketSize > 1 && (SizeAtCompileTime >= PacketSize || SizeAtCompileTime == Dynamic))
+            {
+                // a Dynamic size shorter than a packet takes the scalar loop alone
+                const int size = this->size();
+                int i = 1;
+                if (SizeAtCompileTime != Dynamic || size >= PacketSize)
+                {
+                    Packet packet = derived().template packet<Packet, Aligned>(0);
+                    for (i = PacketSize; i + PacketSize <= size; i += PacketSize)
+                    {
+                        packet = func.packetOp(packet, derived().template packet<Packet, Aligned>(i));
+                    }
+                    result = internal::predux<Scalar>(packet, func);
+                }
+                else
+                {
+                    result = derived().coeff(0);
+                }
+                for (; i < size; ++i)
+                {
+                    result = func(result, derived().coeff(i));
+                }
+            }
+            else if constexpr (internal::traits<Derived>::HasLinearAccess)
+            {
+                const int size = this->size();
+                result = derived().coeff(0);
+                for (int i = 1; i < size; ++i)
+                {
+                    result = func(result, derived().coeff(i));
+                }
+            }
+            else
+            {
+                result = reduxCoeffs(func);
+            }
+            return result;
+        }
+
+        constexpr Scalar sum() const
+        {
+            return redux(internal::scalar_sum_op<Scalar>());
+        }
+
+        constexpr Scalar squaredNorm() const
+        {
+            return cwiseAbs2().sum();
+        }
+
+        inline Scalar norm() const
+        {
+            return sqrt(squaredNorm());
+        }
+
+        template <typename OtherDerived>
+        constexpr Scalar dot(const EmbeddedExprBase<OtherDerived> &other) const
+        {
+            return cwiseProduct(other).sum();
+        }
+
+        inline PlainObject normalized() const
+        {
+            return derived() / norm();
+        }
+
+        constexpr PlainObject eval() const
+        {
+            return PlainObject(derived());
+        }
+
+        //! lazy transpose, products read it in place
+        constexpr EmbeddedTransposeType<Derived> transpose() const
+        {
+            return EmbeddedTransposeType<Derived>(derived());
+        }
+
+        //! lazy view of the Lower or Upper triangle of a square matrix, zeros elsewhere, see UpLoType
+        template <int Mode>
+        constexpr EmbeddedTriangularView<Derived, Mode> triangularView() const
+        {
+            return EmbeddedTriangularView<Derived, Mode>(derived());
+        }
+
+        //! lazy view of a symmetric matrix of which only the Lower or Upper triangle is read
+        template <int UpLo>
+        constexpr EmbeddedSelfAdjointView<const Derived, UpLo> selfadjointView() const
+        {
+            return EmbeddedSelfAdjointView<const Derived, UpLo>(derived());
+        }
+
+        template <typename OtherDerived>
+        constexpr bool operator==(const EmbeddedExprBase<OtherDerived> &other) const
+        {
+            using Packet = typename internal::packet_traits<Scalar>::type;
+            constexpr int PacketSize = internal::packet_traits<Scalar>::size;
+            constexpr bool Aligned = internal::aligned_packet_access<Derived>::value && internal::aligned_packet_access<OtherDerived>::value;
+            if constexpr (SizeAtCompileTime == Dynamic || internal::traits<OtherDerived>::SizeAtCompileTime == Dynamic)
+            {
+                if (rows() != other.rows() || cols() != other.cols())
+                    return false;
+            }
+            if (internal::is_constant_evaluated())
+            {
+                // coefficient loop below
+            }
+            else if constexpr (internal::inner_packet_access<Derived>::value && internal::inner_packet_access<OtherDerived>::value &&
+                               internal::same_layout<Derived, OtherDerived>::value)
+            {
+                // compares whole packets per column (row when row-major), ignoring the lanes that fall into the padding
+                constexpr int Stride = internal::traits<Derived>::OuterStride;
+                constexpr int InnerSize = internal::traits<Derived>::IsRowMajor ? ColsAtCompileTime : RowsAtCompileTime;
+                for (int j = 0; j < internal::traits<Derived>::OuterSize; ++j)
+                {
+                    for (int i = 0; i < InnerSize; i += PacketSize)
+                    {
+                        const int count = (InnerSize - i < PacketSize) ? InnerSize - i : PacketSize;
+                        if (internal::pany_neq<Scalar>(derived().template packet<Packet, Aligned>(j * Stride + i),
+                                                       other.derived().template packet<Packet, Aligned>(j * Stride + i), count))
+                            return false;
+                    }
+                }
+                return true;
+            }
+            else if constexpr (internal::traits<Derived>::HasLinearAccess && internal::traits<OtherDerived>::HasLinearAccess &&
+                               internal::traits<Derived>::HasPacketAccess && internal::traits<OtherDerived>::HasPacketAccess &&
+                               PacketSize > 1)
+            {
+                const int size = this->size();
+                int i = 0;
+                for (; i + PacketSize <= size; i += PacketSize)
+                {
+                    if (internal::pany_neq<Scalar>(derived().template packet<Packet, Aligned>(i), other.derived().template packet<Packet, Aligned>(i)))
+                        return false;
+                }
+                for (; i < size; ++i)
+                {
+                    if (derived().coeff(i) != other.derived().coeff(i))
+                        return false;
+                }
+                return true;
+            }
+            for (int j = 0; j < cols(); ++j)
+            {
+                for (int i = 0; i < rows(); ++i)
+                {
+                    if (derived().coeff(i, j) != other.derived().coeff(i, j))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        template <typename OtherDerived>
+        constexpr bool operator!=(const EmbeddedExprBase<OtherDerived> &other) const
+        {
+            return !(*this == other);
+        }
+
+        template <typename OtherDerived>
+        inline bool isApprox(const EmbeddedExprBase<OtherDerived> &other, const Scalar &epsilon = FLOAT_EPSILON) const
+        {
+            Scalar L2_Dis = (*this - other).norm();
+            return L2_Dis <= epsilon;
+        }
+
+    private:
+        // coefficient by coefficient reduction, used when nothing faster applies and in constant expressions
+        template <typename Functor>
+        constexpr Scalar reduxCoeffs(const Functor &func) const
+        {
+            const int numRows = rows(), numCols = cols();
+            Scalar result = derived().coeff(0, 0);
+            for (int i = 1; i < numRows; ++i)
+            {
+                result = func(result, derived().coeff(i, 0));
+            }
+            for (int j = 1; j < numCols; ++j)
+            {
+                for (int i = 0; i < numRows; ++i)
+                {
+                    result = func(result, derived().coeff(i, j));
+                }
+            }
+            return result;
+        }
+    };
+
+    template <typename BinaryOp, typename LhsType, typename RhsType>
+    class EmbeddedCwiseBinaryOp : public EmbeddedExprBase<EmbeddedCwiseBinaryOp<BinaryOp, LhsType, RhsType>>
+    {
+    protected:
+        typename internal::ref_selector<LhsType>::type m_lhs;
+        typename internal::ref_selector<RhsType>::type m_rhs;
+        const BinaryOp m_functor;
+
+    public:
+        using Scalar = typename internal::traits<EmbeddedCwiseBinaryOp>::Scalar;
+
+        constexpr EmbeddedCwiseBinaryOp(const LhsType &lhs, const RhsType &rhs, const BinaryOp &func = BinaryOp())
+            : m_lhs(lhs), m_rhs(rhs), m_functor(func)
+        {
+            static_assert(std::is_same<Scalar, typename internal::traits<RhsType>::Scalar>::value, "mixing different scalar types");
+            static_assert(internal::compatible_size<internal::traits<LhsType>::RowsAtCompileTime, internal::traits<RhsType>::RowsAtCompileTime>::value &&
+                              internal::compatible_size<internal::traits<LhsType>::ColsAtCompileTime, internal::traits<RhsType>::ColsAtCompileTime>::value,
+                          "coefficient-wise operation between matrices of different sizes");
+        }
+
+        constexpr int rows() const { return m_lhs.rows(); }
+        constexpr int cols() const { return m_lhs.cols(); }
+
+        constexpr Scalar coeff(int index) const
+        {
+            return m_functor(m_lhs.coeff(index), m_rhs.coeff(index));
+        }
+
+        constexpr Scalar coeff(int row, int col) const
+        {
+            return m_functor(m_lhs.coeff(row, col), m_rhs.coeff(row, col));
+        }
+
+        template <typename PacketType, bool Aligned = false>
+        inline PacketType packet(int index) const
+        {
+            return m_functor.packetOp(m_lhs.template packet<PacketType, Aligned>(index), m_rhs.template packet<PacketType, Aligned>(index));
+        }
+
+        template <typename PacketType>
+        inline PacketType packet(int row, int col) const
+        {
+            return m_functor.packetOp(m_lhs.template packet<PacketType>(row, col), m_rhs.template packet<PacketType>(row, col));
+        }
+    };
+
+    template <typename UnaryOp, typename XprType>
+    class EmbeddedCwiseUnaryOp : public EmbeddedExprBase<EmbeddedCwiseUnaryOp<UnaryOp, XprType>>
+    {
+    protected:
+        typename internal::ref_selector<XprType>::type m_xpr;
+        const UnaryOp m_functor;
+
+    public:
+        using Scalar = typename internal::traits<EmbeddedCwiseUnaryOp>::Scalar;
+
+        constexpr explicit EmbeddedCwiseUnaryOp(const XprType &xpr, const UnaryOp &func = UnaryOp())
+            : m_xpr(xpr), m_functor(func) {}
+
+        constexpr int rows() const { return m_xpr.rows(); }
+        constexpr int cols() const { return m_xpr.cols(); }
+
+        constexpr Scalar coeff(int index) const
+        {
+            return m_functor(m_xpr.coeff(index));
+        }
+
+        constexpr Scalar coeff(int row, int col) const
+        {
+            return m_functor(m_xpr.coeff(row, col));
+        }
+
+        template <typename PacketType, bool Aligned = false>
+        inline PacketType packet(int index) const
+        {
+            return m_functor.packetOp(m_xpr.template packet<PacketType, Aligned>(index));
+        }
+
+        template <typename PacketType>
+        inline PacketType packet(int row, int col) const
+        {
+            return m_functor.packetOp(m_xpr.template packet<PacketType>(row, col));
+        }
+
+        constexpr const internal::nested_t<XprType> &nestedExpression() const
+        {
+            return m_xpr;
+        }
+
+        constexpr const UnaryOp &functor() const
+        {
+            return m_functor;
+        }
+    };
+
+    // Transpose of a matrix or expression, read in place: coefficient (row, col) is (col, row) of the expression
+    // and the storage order flips, so packets still run along the storage of the expression. It is read-only.
+    template <typename XprType>
+    class EmbeddedTransposeType : public EmbeddedExprBase<EmbeddedTransposeType<XprType>>
+    {
+    protected:
+        typename internal::ref_selector<XprType>::type m_xpr;
+
+    public:
+        using Scalar = typename internal::traits<EmbeddedTransposeType>::Scalar;
+
+        constexpr explicit EmbeddedTransposeType(const XprType &xpr) : m_xpr(xpr) {}
+
+        constexpr int rows() const { return m_xpr.cols(); }
+        constexpr int cols() const { return m_xpr.rows(); }
+
+        // the index-th coefficient in column-major order, the same one as in the expression for vectors
+        constexpr Scalar coeff(int index) const
+        {
+            if constexpr (internal::traits<XprType>::RowsAtCompileTime == 1 || internal::traits<XprType>::ColsAtCompileTime == 1)
+                return m_xpr.coeff(index);
+            else
+                return m_xpr.coeff(index / rows(), index % rows());
+        }
+
+        constexpr Scalar coeff(int row, int col) const
+        {
+            return m_xpr.coeff(col, row);
+        }
+
+        constexpr Scalar operator()(int index) const
+        {
+            return coeff(index);
+        }
+
+        constexpr Scalar operator()(int row, int col) const
+        {
+            return coeff(row, col);
+        }
+
+        template <typename PacketType, bool Aligned = false>
+        inline PacketType packet(int index) const
+        {
+            return m_xpr.template packet<PacketType, Aligned>(index);
+        }
+
+        template <typename PacketType>
+        inline PacketType packet(int row, int col) const
+        {
+            return m_xpr.template packet<PacketType>(col, row);
+        }
+
+        // direct access to the storage of a matrix or view, in the other storage order
+        inline const Scalar *data() const
+        {
+            return m_xpr.data();
+        }
+
+        inline int outerStride() const
+        {
+            return m_xpr.outerStride();
+        }
+
+        inline int innerStride() const
+        {
+            return m_xpr.innerStride();
+        }
+
+        //! the expression being transposed
+        constexpr const internal::nested_t<XprType> &nestedExpression() const
+        {
+            return m_xpr;
+        }
+    };
+
+    // outerStride is the leading dimension of the referenced storage, larger than the inner size when padded,
+    // rowMajor its storage order. With outerStride Dynamic the storage holds rows x cols coefficients at most
+    // and the leading dimension is passed at runtime.
+    template <typename ScalarType, int storageRows, int storageCols, int outerStride, bool rowMajor>
+    class EmbeddedRefType
+    {
+    protected:
+        static constexpr int size = storageRows * storageCols;
+        static constexpr int outerSize = rowMajor ? storageRows : storageCols;
+        static constexpr int storageSize = (outerStride == Dynamic) ? size : outerStride * outerSize;
+        ScalarType (&RefElements)[storageSize];
+        const int subRows, subCols, subSize, startRow, startCol, stride;
+        bool isContiguous;
+
+        inline int refIndex(int row, int col) const
+        {
+            if constexpr (rowMajor)
+                return (row + startRow) * leadingDim() + col + startCol;
+            else
+                return (col + startCol) * leadingDim() + row + startRow;
+        }
+
+        inline int leadingDim() const
+        {
+            if constexpr (outerStride == Dynamic)
+                return stride;
+            else
+                return outerStride;
+        }
+
+    public:
+        using Scalar = ScalarType;
+
+        EmbeddedRefType() = delete;
+
+        EmbeddedRefType(ScalarType (&Elements)[storageSize],
+                        const int sub_rows, const int sub_cols,
+                        const int start_row, const int start_col,
+                        const int outer_stride = outerStride) : RefElements(Elements),
+                                                                subRows(sub_rows),
+                                                                subCols(sub_cols),
+                                                                subSize(sub_rows * sub_cols),
+                                                                startRow(start_row),
+                                                                startCol(start_col),
+                                                                stride(outer_stride)
+        {
+            // the block is one piece of memory, walked in storage order
+            if constexpr (rowMajor)
+                isContiguous = (sub_cols == leadingDim()) || (sub_rows == 1);
+            else
+                isContiguous = (sub_rows == leadingDim()) || (sub_cols == 1);
+        }
+
+        inline int rows() const { return subRows; }
+        inline int cols() const { return subCols; }
+
+        inline ScalarType &operator()(int index)
+        {
+            return RefElements[refIndex(index % subRows, index / subRows)];
+        }
+
+        inline const ScalarType &operator()(int index) const
+        {
+            return RefElements[refIndex(index % subRows, index / subRows)];
+        }
+
+        inline ScalarType &operator()(int row, int col)
+        {
+            return RefElements[refIndex(row, col)];
+        }
+
+        inline const ScalarType &operator()(int row, int col) const
+        {
+            return RefElements[refIndex(row, col)];
+        }
+
+        template <typename OtherDerived>
+        inline void operator=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::assignment_source_t<OtherDerived> src(other.derived());
+            for (int j = 0; j < subCols; ++j)
+            {
+                for (int i = 0; i < subRows; ++i)
+                {
+                    this->operator()(i, j) = src.coeff(i, j);
+                }
+            }
+            return;
+        }
+
+        inline void operator=(const EmbeddedRefType &other)
+        {
+            for (int j = 0; j < subCols; ++j)
+            {
+                for (int i = 0; i < subRows; ++i)
+                {
+                    this->operator()(i, j) = other(i, j);
+                }
+            }
+            return;
+        }
+
+        template <int OtherRows, int OtherCols, int OtherStride, bool OtherRowMajor>
+        inline void operator=(const EmbeddedRefType<ScalarType, OtherRows, OtherCols, OtherStride, OtherRowMajor> &other)
+        {
+            for (int j = 0; j < subCols; ++j)
+            {
+                for (int i = 0; i < subRows; ++i)
+                {
+                    this->operator()(i, j) = other(i, j);
+                }
+            }
+            return;
+        }
+
+        // compound assignments update the coefficients in place, a product on the right is evaluated first
+        template <typename OtherDerived>
+        inline void operator+=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::assignment_source_t<OtherDerived> src(other.derived());
+            for (int j = 0; j < subCols; ++j)
+            {
+                for (int i = 0; i < subRows; ++i)
+                {
+                    this->operator()(i, j) += src.coeff(i, j);
+                }
+            }
+            return;
+        }
+
+        template <typename OtherDerived>
+        inline void operator-=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::assignment_source_t<OtherDerived> src(other.derived());
+            for (int j = 0; j < subCols; ++j)
+            {
+                for (int i = 0; i < subRows; ++i)
+                {
+                    this->operator()(i, j) -= src.coeff(i, j);
+                }
+            }
+            return;
+        }
+
+        inline void operator*=(const ScalarType value)
+        {
+            for (int j = 0; j < subCols; ++j)
+            {
+                for (int i = 0; i < subRows; ++i)
+                {
+                    this->operator()(i, j) *= value;
+                }
+            }
+            return;
+        }
+
+        inline void operator/=(const ScalarType value)
+        {
+            for (int j = 0; j < subCols; ++j)
+            {
+                for (int i = 0; i < subRows; ++i)
+                {
+                    this->operator()(i, j) /= value;
+                }
+            }
+            return;
+        }
+
+        inline void swap(EmbeddedRefType other)
+        {
+            // contiguous blocks are swapped coefficient by coefficient in place, no buffer of the runtime size
+            if (this->isContiguous && other.isContiguous)
+            {
+                ScalarType *lhs = &(this->operator()(0, 0));
+                ScalarType *rhs = &(other(0, 0));
+                for (int i = 0; i < subSize; ++i)
+                {
+                    std::swap(lhs[i], rhs[i]);
+                }
+            }
+            else
+            {
+                for (int j = 0; j < subCols; ++j)
+                {
+                    for (int i = 0; i < subRows; ++i)
+                    {
+                        ScalarType tmp = this->operator()(i, j);
+                        this->operator()(i, j) = other(i, j);
+                        other(i, j) = tmp;
+                    }
+                }
+            }
+            return;
+        }
+    };
+
+    // Common base of the views over existing storage: blocks, maps and refs. A view keeps a pointer to its
+    // first coefficient and the distances between columns (rows when row-major) and between coefficients of
+    // a column, so an access is a multiply-add, with constant strides when they are known at compile time.
+    // Assigning to a view writes through to the storage it points into.
+    template <typename Derived>
+    class EmbeddedMapBase : public EmbeddedExprBase<Derived>
+    {
+    protected:
+        using Traits = internal::traits<Derived>;
+        using ScalarType = typename Traits::Scalar;
+        // coefficients of a view over const storage are read-only
+        using CoeffType = std::conditional_t<Traits::IsConstView, const ScalarType, ScalarType>;
+        static constexpr bool isRowMajor = Traits::IsRowMajor;
+        static constexpr int viewRows = Traits::RowsAtCompileTime;
+        static constexpr int viewCols = Traits::ColsAtCompileTime;
+        CoeffType *mapData;
+        const int outerStrideValue;
+        const int innerStrideValue;
+
+        EmbeddedMapBase(CoeffType *data, int outer, int inner) : mapData(data), outerStrideValue(outer), innerStrideValue(inner)
+        {
+        }
+
+        EmbeddedMapBase(const EmbeddedMapBase &other) = default;
+
+        // copying a view writes through like any other assignment, the derived views forward to it
+        inline EmbeddedMapBase &operator=(const EmbeddedMapBase &other)
+        {
+            internal::call_assignment(this->derived(), other.derived(), internal::assign_op());
+            return *this;
+        }
+
+        inline int mapIndex(int row, int col) const
+        {
+            if constexpr (isRowMajor)
+                return row * outerStride() + col * innerStride();
+            else
+                return col * outerStride() + row * innerStride();
+        }
+
+        // position of the index-th coefficient in column-major order
+        inline int mapIndex(int index) const
+        {
+            if constexpr (Traits::HasLinearAccess)
+                return index;
+            else if constexpr (viewCols == 1)
+                return mapIndex(index, 0);
+            else if constexpr (viewRows == 1)
+                return mapIndex(0, index);
+            else
+                return mapIndex(index % viewRows, index / viewRows);
+        }
+
+    public:
+        using Scalar = ScalarType;
+        static constexpr int RowsAtCompileTime = viewRows;
+        static constexpr int ColsAtCompileTime = viewCols;
+        static constexpr bool IsRowMajor = isRowMajor;
+
+        // assignments write through to the storage
+        template <typename OtherDerived>
+        inline Derived &operator=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::call_assignment(this->derived(), other.derived(), internal::assign_op());
+            return this->derived();
+        }
+
+        template <int RefRows, int RefCols, int RefStride, bool RefRowMajor>
+        inline Derived &operator=(const EmbeddedRefType<ScalarType, RefRows, RefCols, RefStride, RefRowMajor> &other)
+        {
+            for (int j = 0; j < viewCols; ++j)
+            {
+                for (int i = 0; i < viewRows; ++i)
+                {
+                    coeffRef(i, j) = other(i, j);
+                }
+            }
+            return this->derived();
+        }
+
+        template <typename OtherDerived>
+        inline Derived &operator+=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::call_assignment(this->derived(), other.derived(), internal::add_assign_op());
+            return this->derived();
+        }
+
+        template <typename OtherDerived>
+        inline Derived &operator-=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::call_assignment(this->derived(), other.derived(), internal::sub_assign_op());
+            return this->derived();
+        }
+
+        //! assignments through the result write products straight into the viewed coefficients, which they must not read
+        inline EmbeddedNoAlias<Derived> noalias()
+        {
+            return EmbeddedNoAlias<Derived>(this->derived());
+        }
+
+        using EmbeddedExprBase<Derived>::selfadjointView;
+
+        //! self-adjoint view that can also update the viewed coefficients, see EmbeddedSelfAdjointView::rankUpdate
+        template <int UpLo>
+        inline EmbeddedSelfAdjointView<Derived, UpLo> selfadjointView()
+        {
+            return EmbeddedSelfAdjointView<Derived, UpLo>(this->derived());
+        }
+
+        inline Derived &operator*=(const ScalarType value)
+        {
+            internal::call_assignment(this->derived(), this->derived() * value, internal::assign_op());
+            return this->derived();
+        }
+
+        inline Derived &operator/=(const ScalarType value)
+        {
+            internal::call_assignment(this->derived(), this->derived() / value, internal::assign_op());
+            return this->derived();
+        }
+
+        //! distance between two columns (rows when row-major) in data()
+        inline int outerStride() const
+        {
+            if constexpr (Traits::MapOuterStride != Dynamic)
+                return Traits::MapOuterStride;
+            else
+                return outerStrideValue;
+        }
+
+        //! distance between two coefficients of a column (row when row-major) in data()
+        inline int innerStride() const
+        {
+            if constexpr (Traits::MapInnerStride != Dynamic)
+                return Traits::MapInnerStride;
+            else
+                return innerStrideValue;
+        }
+
+        inline CoeffType *data()
+        {
+            return mapData;
+        }
+
+        inline const ScalarType *data() const
+        {
+            return mapData;
+        }
+
+        inline const ScalarType &coeff(int index) const
+        {
+            return mapData[mapIndex(index)];
+        }
+
+        inline const ScalarType &coeff(int row, int col) const
+        {
+            return mapData[mapIndex(row, col)];
+        }
+
+        inline CoeffType &coeffRef(int index)
+        {
+            return mapData[mapIndex(index)];
+        }
+
+        inline CoeffType &coeffRef(int row, int col)
+        {
+            return mapData[mapIndex(row, col)];
+        }
+
+        inline CoeffType &operator()(int index)
+        {
+            return coeffRef(index);
+        }
+
+        inline const ScalarType &operator()(int index) const
+        {
+            return coeff(index);
+        }
+
+        inline CoeffType &operator()(int row, int col)
+        {
+            return coeffRef(row, col);
+        }
+
+        inline const ScalarType &operator()(int row, int col) const
+        {
+            return coeff(row, col);
+        }
+
+        // packet access takes an index into the storage from the first coefficient of the view, only
+        // available when the coefficients of a column are consecutive
+        template <typename PacketType, bool Aligned = false>
+        inline PacketType packet(int index) const
+        {
+            return internal::ploadt<PacketType, Aligned>(mapData + index);
+        }
+
+        template <typename PacketType, bool Aligned = false>
+        inline void writePacket(int index, const PacketType &packet)
+        {
+            internal::pstoret<Aligned>(mapData + index, packet);
+        }
+
+        template <typename PacketType>
+        inline PacketType packet(int row, int col) const
+        {
+            return internal::ploadu<PacketType>(mapData + mapIndex(row, col));
+        }
+
+        template <typename PacketType>
+        inline void writePacket(int row, int col, const PacketType &packet)
+        {
+            internal::pstoreu(mapData + mapIndex(row, col), packet);
+        }
+
+        inline void setConstant(const ScalarType value)
+        {
+            this->derived() = Traits::PlainObject::Constant(value);
+        }
+
+        inline void setZero()
+        {
+            setConstant(static_cast<ScalarType>(0));
+        }
+
+        template <typename OtherDerived>
+        inline void swap(EmbeddedMapBase<OtherDerived> &other)
+        {
+            static_assert(internal::traits<OtherDerived>::RowsAtCompileTime == viewRows && internal::traits<OtherDerived>::ColsAtCompileTime == viewCols,
+                          "swapping views of different sizes");
+            for (int j = 0; j < viewCols; ++j)
+            {
+                for (int i = 0; i < viewRows; ++i)
+                {
+                    const ScalarType tmp = coeff(i, j);
+                    coeffRef(i, j) = other(i, j);
+                    other(i, j) = tmp;
+                }
+            }
+        }
+
+        // views returned by block() and row() are temporaries
+        template <typename OtherDerived>
+        inline void swap(EmbeddedMapBase<OtherDerived> &&other)
+        {
+            swap(other);
+        }
+
+        // blocks of a view are views into the same storage
+        template <int subrows, int subcols>
+        inline EmbeddedBlockType<Derived, subrows, subcols> block(int startRow, int startCol)
+        {
+            static_assert(subrows <= viewRows && subcols <= viewCols, "block larger than the view");
+            return EmbeddedBlockType<Derived, subrows, subcols>(this->derived(), startRow, startCol);
+        }
+
+        template <int subrows, int subcols>
+        inline EmbeddedBlockType<const Derived, subrows, subcols> block(int startRow, int startCol) const
+        {
+            static_assert(subrows <= viewRows && subcols <= viewCols, "block larger than the view");
+            return EmbeddedBlockType<const Derived, subrows, subcols>(this->derived(), startRow, startCol);
+        }
+
+        inline EmbeddedBlockType<Derived, 1, viewCols> row(int index)
+        {
+            return block<1, viewCols>(index, 0);
+        }
+
+        inline EmbeddedBlockType<const Derived, 1, viewCols> row(int index) const
+        {
+            return block<1, viewCols>(index, 0);
+        }
+
+        inline EmbeddedBlockType<Derived, viewRows, 1> col(int index)
+        {
+            return block<viewRows, 1>(0, index);
+        }
+
+        inline EmbeddedBlockType<const Derived, viewRows, 1> col(int index) const
+        {
+            return block<viewRows, 1>(0, index);
+        }
+
+        template <typename XprType, int length>
+        using SegmentType = EmbeddedBlockType<XprType, (viewCols == 1) ? length : 1, (viewCols == 1) ? 1 : length>;
+
+        template <int length>
+        inline SegmentType<Derived, length> segment(int start)
+        {
+            static_assert(viewRows == 1 || viewCols == 1, "segments are taken from vectors");
+            return block<(viewCols == 1) ? length : 1, (viewCols == 1) ? 1 : length>((viewCols == 1) ? start : 0, (viewCols == 1) ? 0 : start);
+        }
+
+        template <int length>
+        inline SegmentType<const Derived, length> segment(int start) const
+        {
+            static_assert(viewRows == 1 || viewCols == 1, "segments are taken from vectors");
+            return block<(viewCols == 1) ? length : 1, (viewCols == 1) ? 1 : length>((viewCols == 1) ? start : 0, (viewCols == 1) ? 0 : start);
+        }
+
+        template <int length>
+        inline SegmentType<Derived, length> head()
+        {
+            return segment<length>(0);
+        }
+
+        template <int length>
+        inline SegmentType<const Derived, length> head() const
+        {
+            return segment<length>(0);
+        }
+
+        template <int length>
+        inline SegmentType<Derived, length> tail()
+        {
+            return segment<length>(viewRows * viewCols - length);
+        }
+
+        template <int length>
+        inline SegmentType<const Derived, length> tail() const
+        {
+            return segment<length>(viewRows * viewCols - length);
+        }
+    };
+
+    // Block of compile-time size inside a matrix or view, returned by block<subrows, subcols>(), row() and col().
+    // It keeps the strides of what it is taken from and takes part in expressions and products like a matrix.
+    template <typename XprType, int BlockRows, int BlockCols>
+    class EmbeddedBlockType : public EmbeddedMapBase<EmbeddedBlockType<XprType, BlockRows, BlockCols>>
+    {
+        static_assert(BlockRows > 0 && BlockCols > 0, "blocks have a positive size");
+
+    public:
+        using Base = EmbeddedMapBase<EmbeddedBlockType>;
+        using Base::operator=;
+
+        EmbeddedBlockType(XprType &xpr, int startRow, int startCol)
+            : Base(xpr.data() + (Base::isRowMajor ? startRow * xpr.outerStride() + startCol * xpr.innerStride()
+                                                  : startCol * xpr.outerStride() + startRow * xpr.innerStride()),
+                   xpr.outerStride(), xpr.innerStride())
+        {
+        }
+
+        EmbeddedBlockType(const EmbeddedBlockType &other) = default;
+
+        inline EmbeddedBlockType &operator=(const EmbeddedBlockType &other)
+        {
+            Base::operator=(other);
+            return *this;
+        }
+    };
+
+    // Strides of a Map: OuterStrideAtCompileTime between two columns (rows when row-major) and
+    // InnerStrideAtCompileTime between two coefficients of a column. 0 keeps the layout of the mapped
+    // type, Dynamic takes the value given to the constructor.
+    template <int OuterStrideAtCompileTime_, int InnerStrideAtCompileTime_>
+    class EmbeddedStride
+    {
+    protected:
+        int outerValue;
+        int innerValue;
+
+    public:
+        static constexpr int OuterStrideAtCompileTime = OuterStrideAtCompileTime_;
+        static constexpr int InnerStrideAtCompileTime = InnerStrideAtCompileTime_;
+
+        constexpr EmbeddedStride() : outerValue(OuterStrideAtCompileTime), innerValue(InnerStrideAtCompileTime)
+        {
+            static_assert(OuterStrideAtCompileTime != Dynamic && InnerStrideAtCompileTime != Dynamic, "a Dynamic stride needs a value");
+        }
+
+        constexpr EmbeddedStride(int outer, int inner) : outerValue(outer), innerValue(inner)
+        {
+        }
+
+        constexpr int outer() const
+        {
+            return outerValue;
+        }
+
+        constexpr int inner() const
+        {
+            return innerValue;
+        }
+    };
+
+    template <int Value = Dynamic>
+    class EmbeddedOuterStride : public EmbeddedStride<Value, 0>
+    {
+    public:
+        constexpr EmbeddedOuterStride() : EmbeddedStride<Value, 0>()
+        {
+        }
+
+        constexpr EmbeddedOuterStride(int outer) : EmbeddedStride<Value, 0>(outer, 0)
+        {
+        }
+    };
+
+    template <int Value = Dynamic>
+    class EmbeddedInnerStride : public EmbeddedStride<0, Value>
+    {
+    public:
+        constexpr EmbeddedInnerStride() : EmbeddedStride<0, Value>()
+        {
+        }
+
+        constexpr EmbeddedInnerStride(int inner) : EmbeddedStride<0, Value>(0, inner)
+        {
+        }
+    };
+
+    // Fixed-size matrix over an existing buffer (a C array, a DMA buffer, a message payload) without copying it.
+    // Map<const T> is read-only. The buffer must outlive the map.
+    template <typename PlainObjectType, typename StrideType>
+    class EmbeddedMapType : public EmbeddedMapBase<EmbeddedMapType<PlainObjectType, StrideType>>
+    {
+        static_assert(internal::traits<PlainObjectType>::SizeAtCompileTime != Dynamic, "only fixed-size matrices can be mapped");
+        using Strides = internal::map_strides<PlainObjectType, StrideType>;
+
+    public:
+        using Base = EmbeddedMapBase<EmbeddedMapType>;
+        using Base::operator=;
+
+        explicit EmbeddedMapType(typename Base::CoeffType *data, const StrideType &stride = StrideType())
+            : Base(data, (Strides::Outer != Dynamic) ? Strides::Outer : stride.outer(), (Strides::Inner != Dynamic) ? Strides::Inner : stride.inner())
+        {
+        }
+
+        EmbeddedMapType(const EmbeddedMapType &other) = default;
+
+        inline EmbeddedMapType &operator=(const EmbeddedMapType &other)
+        {
+            Base::operator=(other);
+            return *this;
+        }
+    };
+
+    // Parameter type for functions taking a matrix without copying it. Ref<const T> binds to a T, a Map or a
+    // block of the same size and storage order, Ref<T> to writable ones. Expressions and strided maps must be
+    // evaluated first with .eval(), so that no hidden temporary is placed on the stack.
+    template <typename PlainObjectType>
+    class EmbeddedMatrixRef : public EmbeddedMapBase<EmbeddedMatrixRef<PlainObjectType>>
+    {
+        static_assert(internal::traits<PlainObjectType>::SizeAtCompileTime != Dynamic, "only fixed-size matrices can be referenced");
+        static constexpr bool isConst = std::is_const<PlainObjectType>::value;
+        using PlainType = std::remove_const_t<PlainObjectType>;
+
+    public:
+        using Base = EmbeddedMapBase<EmbeddedMatrixRef>;
+        using Base::operator=;
+
+        template <typename OtherDerived, typename = std::enable_if_t<internal::ref_compatible<PlainType, OtherDerived>::value &&
+                                                                     (isConst || !internal::has_const_data<OtherDerived>::value)>>
+        EmbeddedMatrixRef(EmbeddedExprBase<OtherDerived> &other)
+            : Base(other.derived().data(), other.derived().outerStride(), 1)
+        {
+        }
+
+        // temporaries: const refs bind to anything compatible, writable refs to views returned by value
+        template <typename OtherDerived, typename = std::enable_if_t<internal::ref_compatible<PlainType, OtherDerived>::value &&
+                                                                     (isConst || (internal::is_view<OtherDerived>::value && !internal::has_const_data<OtherDerived>::value))>>
+        EmbeddedMatrixRef(const EmbeddedExprBase<OtherDerived> &other)
+            : Base(const_cast<typename Base::CoeffType *>(other.derived().data()), other.derived().outerStride(), 1)
+        {
+        }
+
+        EmbeddedMatrixRef(const EmbeddedMatrixRef &other) = default;
+
+        inline EmbeddedMatrixRef &operator=(const EmbeddedMatrixRef &other)
+        {
+            Base::operator=(other);
+            return *this;
+        }
+    };
+
+    // Fixed-size matrix, the specializations below handle Dynamic dimensions
+    template <typename ScalarType, int rows, int cols, int Options, int MaxRows, int MaxCols>
+    class EmbeddedCoreType : public EmbeddedExprBase<EmbeddedCoreType<ScalarType, rows, cols, Options, MaxRows, MaxCols>>
+    {
+        static_assert(rows > 0 && cols > 0 && MaxRows == rows && MaxCols == cols, "fixed-size matrices are their own bound");
+
+    protected:
+        using Layout = internal::storage_layout<ScalarType, rows, cols, Options>;
+        static constexpr int totalSize = rows * cols;
+        static constexpr bool isRowMajor = Layout::IsRowMajor;
+        static constexpr int stride = Layout::OuterStride;
+        static constexpr int storageSize = Layout::StorageSize;
+        alignas(Layout::Alignment) ScalarType Elements[storageSize];
+
+        // position of coefficient (row, col) inside the (possibly padded) storage
+        static constexpr int storageIndex(int row, int col)
+        {
+            if constexpr (isRowMajor)
+                return row * stride + col;
+            else
+                return col * stride + row;
+        }
+
+        // position of the index-th coefficient in column-major order, whatever the storage order
+        static constexpr int storageIndex(int index)
+        {
+            if constexpr (cols == 1 || rows == 1 || (!isRowMajor && stride == rows))
+                return index;
+            else
+                return storageIndex(index % rows, index / rows);
+        }
+
+        template <typename OtherDerived>
+        static constexpr EmbeddedCoreType evaluate(const OtherDerived &other)
+        {
+            EmbeddedCoreType result = internal::plain_uninitialized<EmbeddedCoreType>();
+            internal::call_assignment_no_alias(result, other, internal::assign_op());
+            return result;
+        }
+
+    public:
+        using Scalar = ScalarType;
+        using Base = EmbeddedExprBase<EmbeddedCoreType>;
+        static constexpr int RowsAtCompileTime = rows;
+        static constexpr int ColsAtCompileTime = cols;
+        static constexpr int MaxRowsAtCompileTime = rows;
+        static constexpr int MaxColsAtCompileTime = cols;
+        static constexpr int OuterStrideAtCompileTime = stride;
+        static constexpr bool IsRowMajor = isRowMajor;
+        static constexpr int MaxRankAtCompileTime = (RowsAtCompileTime < ColsAtCompileTime) ? RowsAtCompileTime : ColsAtCompileTime;
+        static constexpr int MaxDimAtCompileTime = (RowsAtCompileTime > ColsAtCompileTime) ? RowsAtCompileTime : ColsAtCompileTime;
+
+        constexpr EmbeddedCoreType() : Elements{} {}
+
+        //! leaves all elements uninitialized
+        explicit EmbeddedCoreType(NoInit_t) {}
+
+        constexpr EmbeddedCoreType(const EmbeddedCoreType &other) = default;
+
+        template <int RefRows, int RefCols, int RefStride, bool RefRowMajor>
+        EmbeddedCoreType(const EmbeddedRefType<ScalarType, RefRows, RefCols, RefStride, RefRowMajor> &other)
+        {
+            for (int j = 0; j < ColsAtCompileTime; ++j)
+            {
+                for (int i = 0; i < RowsAtCompileTime; ++i)
+                {
+                    this->operator()(i, j) = other(i, j);
+                }
+            }
+        }
+
+        // evaluated into a temporary so the constructor stays usable in constant expressions, the copy is elided once inlined
+        template <typename OtherDerived>
+        constexpr EmbeddedCoreType(const EmbeddedExprBase<OtherDerived> &other)
+            : EmbeddedCoreType(evaluate(other.derived()))
+        {
+        }
+
+        EmbeddedCoreType &operator=(const EmbeddedCoreType &other) = default;
+
+        template <typename OtherDerived>
+        constexpr EmbeddedCoreType &operator=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::call_assignment(*this, other.derived(), internal::assign_op());
+            return *this;
+        }
+
+        constexpr EmbeddedCoreType(const ScalarType value)
+            : EmbeddedCoreType(Constant(value))
+        {
+        }
+
+        constexpr EmbeddedCoreType(const ScalarType a1, const ScalarType a2)
+            : EmbeddedCoreType(internal::plain_uninitialized<EmbeddedCoreType>())
+        {
+            static_assert(MaxDimAtCompileTime >= 2);
+            Elements[storageIndex(0)] = a1;
+            Elements[storageIndex(1)] = a2;
+        }
+
+        constexpr EmbeddedCoreType(const ScalarType a1, const ScalarType a2, const ScalarType a3)
+            : EmbeddedCoreType(internal::plain_uninitialized<EmbeddedCoreType>())
+        {
+            static_assert(MaxDimAtCompileTime >= 3);
+            Elements[storageIndex(0)] = a1;
+            Elements[storageIndex(1)] = a2;
+            Elements[storageIndex(2)] = a3;
+        }
+
+        constexpr EmbeddedCoreType(const ScalarType a1, const ScalarType a2, const ScalarType a3, const ScalarType a4)
+            : EmbeddedCoreType(internal::plain_uninitialized<EmbeddedCoreType>())
+        {
+            static_assert(MaxDimAtCompileTime >= 4);
+            Elements[storageIndex(0)] = a1;
+            Elements[storageIndex(1)] = a2;
+            Elements[storageIndex(2)] = a3;
+            Elements[storageIndex(3)] = a4;
+        }
+
+        constexpr ScalarType &x()
+        {
+            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 1);
+            return this->Elements[storageIndex(0)];
+        }
+        constexpr const ScalarType &x() const
+        {
+            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 1);
+            return this->Elements[storageIndex(0)];
+        }
+
+        constexpr ScalarType &y()
+        {
+            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 2);
+            return this->Elements[storageIndex(1)];
+        }
+        constexpr const ScalarType &y() const
+        {
+            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 2);
+            return this->Elements[storageIndex(1)];
+        }
+
+        constexpr ScalarType &z()
+        {
+            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 3);
+            return this->Elements[storageIndex(2)];
+        }
+        constexpr const ScalarType &z() const
+        {
+            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 3);
+            return this->Elements[storageIndex(2)];
+        }
+
+        constexpr ScalarType &operator()(int index)
+        {
+            return Elements[storageIndex(index)];
+        }
+
+        constexpr const ScalarType &operator()(int index) const
+        {
+            return Elements[storageIndex(index)];
+        }
+
+        constexpr ScalarType &operator()(int row, int col)
+        {
+            return Elements[storageIndex(row, col)];
+        }
+
+        constexpr const ScalarType &operator()(int row, int col) const
+        {
+            return Elements[storageIndex(row, col)];
+        }
+
+        //! column j starts at data() + j * outerStride(), row i at data() + i * outerStride() when row-major
+        constexpr ScalarType *data()
+        {
+            return Elements;
+        }
+
+        constexpr const ScalarType *data() const
+        {
+            return Elements;
+        }
+
+        //! distance between two columns (rows when row-major) in data(), the inner size unless padded
+        constexpr int outerStride() const
+        {
+            return stride;
+        }
+
+        //! distance between two coefficients of a column (row when row-major) in data()
+        constexpr int innerStride() const
+        {
+            return 1;
+        }
+
+        constexpr const ScalarType &coeff(int index) const
+        {
+            return Elements[storageIndex(index)];
+        }
+
+        constexpr const ScalarType &coeff(int row, int col) const
+        {
+            return Elements[storageIndex(row, col)];
+        }
+
+        constexpr ScalarType &coeffRef(int index)
+        {
+            return Elements[storageIndex(index)];
+        }
+
+        constexpr ScalarType &coeffRef(int row, int col)
+        {
+            return Elements[storageIndex(row, col)];
+        }
+
+        // packet access takes an index into the storage, which differs from the coefficient index when padded
+        template <typename PacketType, bool Aligned = false>
+        inline PacketType packet(int index) const
+        {
+            return internal::ploadt<PacketType, Aligned>(Elements + index);
+        }
+
+        template <typename PacketType, bool Aligned = false>
+        inline void writePacket(int index, const PacketType &packet)
+        {
+            internal::pstoret<Aligned>(Elements + index, packet);
+        }
+
+        // consecutive coefficients along the inner dimension, starting at (row, col)
+        template <typename PacketType>
+        inline PacketType packet(int row, int col) const
+        {
+            return internal::ploadu<PacketType>(Elements + storageIndex(row, col));
+        }
+
+        template <typename PacketType>
+        inline void writePacket(int row, int col, const PacketType &packet)
+        {
+            internal::pstoreu(Elements + storageIndex(row, col), packet);
+        }
+
+        template <typename OtherDerived>
+        constexpr EmbeddedCoreType &operator+=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::call_assignment(*this, other.derived(), internal::add_assign_op());
+            return *this;
+        }
+
+        template <typename OtherDerived>
+        constexpr EmbeddedCoreType &operator-=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::call_assignment(*this, other.derived(), internal::sub_assign_op());
+            return *this;
+        }
+
+        //! assignments through the result write products straight into this matrix, which they must not read
+        constexpr EmbeddedNoAlias<EmbeddedCoreType> noalias()
+        {
+            return EmbeddedNoAlias<EmbeddedCoreType>(*this);
+        }
+
+        using Base::selfadjointView;
+
+        //! self-adjoint view that can also update this matrix, see EmbeddedSelfAdjointView::rankUpdate
+        template <int UpLo>
+        constexpr EmbeddedSelfAdjointView<EmbeddedCoreType, UpLo> selfadjointView()
+        {
+            return EmbeddedSelfAdjointView<EmbeddedCoreType, UpLo>(*this);
+        }
+
+        constexpr EmbeddedCoreType &operator*=(const ScalarType factor)
+        {
+            internal::call_assignment(*this, *this * factor, internal::assign_op());
+            return *this;
+        }
+
+        constexpr EmbeddedCoreType &operator/=(const ScalarType factor)
+        {
+            internal::call_assignment(*this, *this / factor, internal::assign_op());
+            return *this;
+        }
+
+        //! sets the padding as well
+        constexpr void setConstant(const ScalarType value)
+        {
+            using Packet = typename internal::packet_traits<ScalarType>::type;
+            constexpr int PacketSize = internal::packet_traits<ScalarType>::size;
+            int i = 0;
+            if constexpr (PacketSize > 1)
+            {
+                if (!internal::is_constant_evaluated())
+                {
+                    const Packet packet = internal::pset1<Packet>(value);
+                    for (; i + PacketSize <= storageSize; i += PacketSize)
+                    {
+                        writePacket<Packet, internal::aligned_packet_access<EmbeddedCoreType>::value>(i, packet);
+                    }
+                }
+            }
+            for (; i < storageSize; ++i)
+            {
+                Elements[i] = value;
+            }
+            return;
+        }
+
+        constexpr void setZero()
+        {
+            setConstant(static_cast<ScalarType>(0));
+            return;
+        }
+
+        static constexpr EmbeddedCoreType Zero()
+        {
+            EmbeddedCoreType result = internal::plain_uninitialized<EmbeddedCoreType>();
+            result.setZero();
+            return result;
+        }
+
+        static constexpr EmbeddedCoreType Ones()
+        {
+            return Constant(static_cast<ScalarType>(1));
+        }
+
+        static constexpr EmbeddedCoreType Constant(const ScalarType value)
+        {
+            EmbeddedCoreType result = internal::plain_uninitialized<EmbeddedCoreType>();
+            result.setConstant(value);
+            return result;
+        }
+
+        constexpr void normalize()
+        {
+            *this /= this->norm();
+            return;
+        }
+
+        constexpr ScalarType trace() const
+        {
+            ScalarType result = 0;
+            for (int i = 0; i < MaxRankAtCompileTime; i++)
+            {
+                result += this->operator()(i, i);
+            }
+            return result;
+        }
+
+        constexpr ScalarType determinant() const
+        {
+            ScalarType result = 0;
+            const EmbeddedCoreType &m = *this;
+            if constexpr (RowsAtCompileTime == 1 && ColsAtCompileTime == 1)
+            {
+                result = m(0);
+            }
+            else if constexpr (RowsAtCompileTime == 2 && ColsAtCompileTime == 2)
+            {
+                result = m(0) * m(3) - m(1) * m(2);
+            }
+            else if constexpr (RowsAtCompileTime == 3 && ColsAtCompileTime == 3)
+            {
+                result = m(0) * m(4) * m(8) -
+                         m(0) * m(7) * m(5) -
+                         m(3) * m(1) * m(8) +
+                         m(3) * m(7) * m(2) +
+                         m(6) * m(1) * m(5) -
+                         m(6) * m(4) * m(2);
+            }
+            else
+            {
+                PartialPivLU<EmbeddedCoreType> lu(*this);
+                result = lu.determinant();
+            }
+            return result;
+        }
+
+        template <typename OtherDerived>
+        constexpr EmbeddedCoreType cross(const EmbeddedExprBase<OtherDerived> &other) const
+        {
+            const OtherDerived &rhs = other.derived();
+            EmbeddedCoreType result;
+            if constexpr (RowsAtCompileTime == 2 && ColsAtCompileTime == 1)
+            {
+                result(0) = this->Elements[1] * rhs.coeff(0);
+                result(1) = -this->Elements[0] * rhs.coeff(0);
+            }
+            else if constexpr (RowsAtCompileTime == 3 && ColsAtCompileTime == 1)
+            {
+                result(0) = this->Elements[1] * rhs.coeff(2) - this->Elements[2] * rhs.coeff(1);
+                result(1) = this->Elements[2] * rhs.coeff(0) - this->Elements[0] * rhs.coeff(2);
+                result(2) = this->Elements[0] * rhs.coeff(1) - this->Elements[1] * rhs.coeff(0);
+            }
+            return result;
+        }
+
+        constexpr void setIdentity()
+        {
+            setZero();
+            for (int i = 0; i < MaxRankAtCompileTime; i++)
+            {
+                this->operator()(i, i) = static_cast<ScalarType>(1);
+            }
+            return;
+        }
+
+        static constexpr EmbeddedCoreType Identity()
+        {
+            EmbeddedCoreType result;
+            for (int i = 0; i < MaxRankAtCompileTime; i++)
+            {
+                result(i, i) = static_cast<ScalarType>(1);
+            }
+            return result;
+        }
+
+        static constexpr EmbeddedCoreType UnitX()
+        {
+            static_assert(RowsAtCompileTime >= 3 && ColsAtCompileTime == 1, "UnitX() only works for vectors longer than 3x1");
+            EmbeddedCoreType result;
+            result.x() = static_cast<ScalarType>(1.0);
+            return result;
+        }
+
+        static constexpr EmbeddedCoreType UnitY()
+        {
+            static_assert(RowsAtCompileTime >= 3 && ColsAtCompileTime == 1, "UnitY() only works for vectors longer than 3x1");
+            EmbeddedCoreType result;
+            result.y() = static_cast<ScalarType>(1.0);
+            return result;
+        }
+
+        static constexpr EmbeddedCoreType UnitZ()
+        {
+            static_assert(RowsAtCompileTime >= 3 && ColsAtCompileTime == 1, "UnitZ() only works for vectors longer than 3x1");
+            EmbeddedCoreType result;
+            result.z() = static_cast<ScalarType>(1.0);
+            return result;
+        }
+
+        template <int subrows, int subcols>
+        inline EmbeddedBlockType<EmbeddedCoreType, subrows, subcols> block(int startrows, int startcols)
+        {
+            static_assert(subrows <= RowsAtCompileTime && subcols <= ColsAtCompileTime, "block larger than the matrix");
+            return EmbeddedBlockType<EmbeddedCoreType, subrows, subcols>(*this, startrows, startcols);
+        }
+
+        template <int subrows, int subcols>
+        inline EmbeddedBlockType<const EmbeddedCoreType, subrows, subcols> block(int startrows, int startcols) const
+        {
+            static_assert(subrows <= RowsAtCompileTime && subcols <= ColsAtCompileTime, "block larger than the matrix");
+            return EmbeddedBlockType<const EmbeddedCoreType, subrows, subcols>(*this, startrows, startcols);
+        }
+
+        inline EmbeddedRefType<Scalar, RowsAtCompileTime, ColsAtCompileTime, stride, isRowMajor> block(int startrows, int startcols, int subrows, int subcols)
+        {
+            return EmbeddedRefType<Scalar, RowsAtCompileTime, ColsAtCompileTime, stride, isRowMajor>(
+                *reinterpret_cast<Scalar(*)[storageSize]>(this->data()),
+                subrows, subcols, startrows, startcols);
+        }
+
+        inline EmbeddedBlockType<EmbeddedCoreType, 1, ColsAtCompileTime> row(const int index)
+        {
+            return EmbeddedBlockType<EmbeddedCoreType, 1, ColsAtCompileTime>(*this, index, 0);
+        }
+
+        inline EmbeddedBlockType<const EmbeddedCoreType, 1, ColsAtCompileTime> row(const int index) const
+        {
+            return EmbeddedBlockType<const EmbeddedCoreType, 1, ColsAtCompileTime>(*this, index, 0);
+        }
+
+        inline EmbeddedBlockType<EmbeddedCoreType, RowsAtCompileTime, 1> col(const int index)
+        {
+            return EmbeddedBlockType<EmbeddedCoreType, RowsAtCompileTime, 1>(*this, 0, index);
+        }
+
+        inline EmbeddedBlockType<const EmbeddedCoreType, RowsAtCompileTime, 1> col(const int index) const
+        {
+            return EmbeddedBlockType<const EmbeddedCoreType, RowsAtCompileTime, 1>(*this, 0, index);
+        }
+
+        // length coefficients of a vector from start, a column or a row like the vector itself
+        template <typename XprType, int length>
+        using SegmentType = EmbeddedBlockType<XprType, (cols == 1) ? length : 1, (cols == 1) ? 1 : length>;
+
+        template <int length>
+        inline SegmentType<EmbeddedCoreType, length> segment(int start)
+        {
+            static_assert(MaxRankAtCompileTime == 1, "segments are taken from vectors");
+            static_assert(length <= totalSize, "segment longer than the vector");
+            return SegmentType<EmbeddedCoreType, length>(*this, (cols == 1) ? start : 0, (cols == 1) ? 0 : start);
+        }
+
+        template <int length>
+        inline SegmentType<const EmbeddedCoreType, length> segment(int start) const
+        {
+            static_assert(MaxRankAtCompileTime == 1, "segments are taken from vectors");
+            static_assert(length <= totalSize, "segment longer than the vector");
+            return SegmentType<const EmbeddedCoreType, length>(*this, (cols == 1) ? start : 0, (cols == 1) ? 0 : start);
+        }
+
+        template <int length>
+        inline SegmentType<EmbeddedCoreType, length> head()
+        {
+            return segment<length>(0);
+        }
+
+        template <int length>
+        inline SegmentType<const EmbeddedCoreType, length> head() const
+        {
+            return segment<length>(0);
+        }
+
+        template <int length>
+        inline SegmentType<EmbeddedCoreType, length> tail()
+        {
+            return segment<length>(totalSize - length);
+        }
+
+        template <int length>
+        inline SegmentType<const EmbeddedCoreType, length> tail() const
+        {
+            return segment<length>(totalSize - length);
+        }
+
+        // the diagonal steps over one column and one coefficient (a row and one coefficient when row-major)
+        using DiagonalType = EmbeddedMapType<EmbeddedCoreType<ScalarType, MaxRankAtCompileTime, 1>, EmbeddedInnerStride<stride + 1>>;
+        using ConstDiagonalType = EmbeddedMapType<const EmbeddedCoreType<ScalarType, MaxRankAtCompileTime, 1>, EmbeddedInnerStride<stride + 1>>;
+
+        inline DiagonalType diagonal()
+        {
+            return DiagonalType(Elements);
+        }
+
+        inline ConstDiagonalType diagonal() const
+        {
+            return ConstDiagonalType(Elements);
+        }
+
+        constexpr EmbeddedCoreType inverse() const
+        {
+            EmbeddedCoreType result = internal::plain_uninitialized<EmbeddedCoreType>();
+
+            if constexpr (RowsAtCompileTime == 2 && ColsAtCompileTime == 2)
+            {
+                ScalarType det = this->determinant();
+                if (abs(det) < FLOAT_EPSILON)
+                    return EmbeddedCoreType::Zero();
+                ScalarType invDet = (ScalarType)1.0 / det;
+                const EmbeddedCoreType &m = *this;
+                result(0, 0) = m(3) * invDet;
+                result(0, 1) = -m(2) * invDet;
+                result(1, 0) = -m(1) * invDet;
+                result(1, 1) = m(0) * invDet;
+            }
+            else if constexpr (RowsAtCompileTime == 3 && ColsAtCompileTime == 3)
+            {
+                ScalarType det = this->determinant();
+                if (abs(det) < FLOAT_EPSILON)
+                    return EmbeddedCoreType::Zero();
+                ScalarType invDet = (ScalarType)1.0 / det;
+                const EmbeddedCoreType &m = *this;
+                result(0, 0) = (m(4) * m(8) - m(5) * m(7)) * invDet;
+                result(0, 1) = (m(6) * m(5) - m(3) * m(8)) * invDet;
+                result(0, 2) = (m(3) * m(7) - m(6) * m(4)) * invDet;
+
+                result(1, 0) = (m(2) * m(7) - m(1) * m(8)) * invDet;
+                result(1, 1) = (m(0) * m(8) - m(2) * m(6)) * invDet;
+                result(1, 2) = (m(1) * m(6) - m(0) * m(7)) * invDet;
+
+                result(2, 0) = (m(1) * m(5) - m(2) * m(4)) * invDet;
+                result(2, 1) = (m(2) * m(3) - m(0) * m(5)) * invDet;
+                result(2, 2) = (m(0) * m(4) - m(1) * m(3)) * invDet;
+            }
+            else
+            {
+                PartialPivLU<EmbeddedCoreType> lu(*this);
+                result = lu.inverse();
+            }
+            return result;
+        }
+
+        //! Cholesky factorization of this symmetric positive definite matrix, reading its lower triangle
+        inline LLT<EmbeddedCoreType> llt() const
+        {
+            return LLT<EmbeddedCoreType>(*this);
+        }
+
+        //! L * D * L^T factorization of this symmetric matrix, reading its lower triangle
+        inline LDLT<EmbeddedCoreType> ldlt() const
+        {
+            return LDLT<EmbeddedCoreType>(*this);
+        }
+
+        inline EmbeddedCoreType<ScalarType, 3, 1> eulerAngles(const int y = 2, const int p = 1, const int r = 0) const
+        {
+            // TODO: fix the first element to -PI/2 to PI/2
+            static_assert(RowsAtCompileTime == 3 && ColsAtCompileTime == 3);
+            EmbeddedCoreType<ScalarType, 3, 1> result = internal::plain_uninitialized<EmbeddedCoreType<ScalarType, 3, 1>>();
+
+            const EmbeddedCoreType &m = *this;
+            result(y) = atan2(m(5), m(8));
+            result(p) = atan2(-m(2), sqrt(m(5) * m(5) + m(8) * m(8)));
+            result(r) = atan2(m(1), m(0));
+            return result;
+        }
+
+        constexpr EmbeddedCoreType<ScalarType, MaxDimAtCompileTime, MaxDimAtCompileTime, Options> asDiagonal() const
+        {
+            static_assert(MaxRankAtCompileTime == 1);
+
+            EmbeddedCoreType<ScalarType, MaxDimAtCompileTime, MaxDimAtCompileTime, Options> result;
+            for (int i = 0; i < MaxDimAtCompileTime; i++)
+            {
+                result(i, i) = this->coeff(i);
+            }
+            return result;
+        }
+
+    };
+
+    // Matrix with Dynamic rows and/or cols, sized at runtime up to MaxRows x MaxCols.
+    // The storage is a static array of the maximum size, so resizing never touches the heap. The coefficients
+    // are packed for the current size (column-major unless RowMajor) and are not kept by resize().
+    // Padded is not supported, Aligned16/Aligned32 align the start of the storage.
+    template <typename ScalarType, int Rows, int Cols, int Options, int MaxRows, int MaxCols>
+    class EmbeddedBoundedType : public EmbeddedExprBase<EmbeddedCoreType<ScalarType, Rows, Cols, Options, MaxRows, MaxCols>>
+    {
+        static_assert(MaxRows > 0 && MaxCols > 0, "bounded matrices need a positive maximum size");
+        static_assert((Rows == Dynamic || Rows == MaxRows) && (Cols == Dynamic || Cols == MaxCols), "a fixed dimension is its own bound");
+        static_assert(!(Options & Padded), "bounded matrices are always packed");
+
+    protected:
+        using Derived = EmbeddedCoreType<ScalarType, Rows, Cols, Options, MaxRows, MaxCols>;
+        using Layout = internal::storage_layout<ScalarType, Rows, Cols, Options>;
+        static constexpr int maxSize = MaxRows * MaxCols;
+        static constexpr bool isRowMajor = Layout::IsRowMajor;
+        alignas(Layout::Alignment) ScalarType Elements[maxSize];
+        int numRows, numCols;
+
+        inline int storageIndex(int row, int col) const
+        {
+            if constexpr (isRowMajor)
+                return row * numCols + col;
+            else
+                return col * numRows + row;
+        }
+
+        // position of the index-th coefficient in column-major order, whatever the storage order
+        inline int storageIndex(int index) const
+        {
+            if constexpr (isRowMajor && Rows != 1)
+                return (numRows == 1 || numCols == 1) ? index : storageIndex(index % numRows, index / numRows);
+            else
+                return index;
+        }
+
+    public:
+        using Scalar = ScalarType;
+        using Base = EmbeddedExprBase<Derived>;
+        static constexpr int RowsAtCompileTime = Rows;
+        static constexpr int ColsAtCompileTime = Cols;
+        static constexpr int MaxRowsAtCompileTime = MaxRows;
+        static constexpr int MaxColsAtCompileTime = MaxCols;
+        static constexpr bool IsRowMajor = isRowMajor;
+
+        //! empty along every Dynamic dimension
+        EmbeddedBoundedType() : numRows(Rows == Dynamic ? 0 : Rows), numCols(Cols == Dynamic ? 0 : Cols) {}
+
+        //! zero-filled matrix of the given size
+        EmbeddedBoundedType(int num_rows, int num_cols)
+        {
+            resize(num_rows, num_cols);
+            setZero();
+        }
+
+        //! leaves all elements uninitialized
+        EmbeddedBoundedType(int num_rows, int num_cols, NoInit_t)
+        {
+            resize(num_rows, num_cols);
+        }
+
+        //! zero-filled vector of the given length
+        explicit EmbeddedBoundedType(int length)
+        {
+            resize(length);
+            setZero();
+        }
+
+        EmbeddedBoundedType(const EmbeddedBoundedType &other) : numRows(other.numRows), numCols(other.numCols)
+        {
+            memcpy(Elements, other.Elements, sizeof(ScalarType) * size());
+        }
+
+        template <int RefRows, int RefCols, int RefStride, bool RefRowMajor>
+        EmbeddedBoundedType(const EmbeddedRefType<ScalarType, RefRows, RefCols, RefStride, RefRowMajor> &other)
+        {
+            resize(other.rows(), other.cols());
+            for (int j = 0; j < numCols; ++j)
+            {
+                for (int i = 0; i < numRows; ++i)
+                {
+                    this->operator()(i, j) = other(i, j);
+                }
+            }
+        }
+
+        template <typename OtherDerived>
+        EmbeddedBoundedType(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            static_assert(internal::traits<OtherDerived>::RowsAtCompileTime <= MaxRows && internal::traits<OtherDerived>::ColsAtCompileTime <= MaxCols,
+                          "matrix larger than the bound");
+            resize(other.rows(), other.cols());
+            internal::call_assignment_no_alias(this->derived(), other.derived(), internal::assign_op());
+        }
+
+        EmbeddedBoundedType &operator=(const EmbeddedBoundedType &other)
+        {
+            resize(other.numRows, other.numCols);
+            memcpy(Elements, other.Elements, sizeof(ScalarType) * size());
+            return *this;
+        }
+
+        template <typename OtherDerived>
+        inline Derived &operator=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            static_assert(internal::traits<OtherDerived>::RowsAtCompileTime <= MaxRows && internal::traits<OtherDerived>::ColsAtCompileTime <= MaxCols,
+                          "matrix larger than the bound");
+            resize(other.rows(), other.cols());
+            internal::call_assignment(this->derived(), other.derived(), internal::assign_op());
+            return this->derived();
+        }
+
+        inline int rows() const { return numRows; }
+        inline int cols() const { return numCols; }
+        inline int size() const { return numRows * numCols; }
+
+        //! sizes along fixed dimensions are ignored, the coefficients are left unspecified
+        inline void resize(int num_rows, int num_cols)
+        {
+            numRows = (Rows == Dynamic) ? num_rows : Rows;
+            numCols = (Cols == Dynamic) ? num_cols : Cols;
+        }
+
+        inline void resize(int length)
+        {
+            static_assert(Rows == 1 || Cols == 1, "resize(length) only works for vectors");
+            if constexpr (Rows == 1)
+                resize(1, length);
+            else
+                resize(length, 1);
+        }
+
+        inline ScalarType &operator()(int index)
+        {
+            return Elements[storageIndex(index)];
+        }
+
+        inline const ScalarType &operator()(int index) const
+        {
+            return Elements[storageIndex(index)];
+        }
+
+        inline ScalarType &operator()(int row, int col)
+        {
+            return Elements[storageIndex(row, col)];
+        }
+
+        inline const ScalarType &operator()(int row, int col) const
+        {
+            return Elements[storageIndex(row, col)];
+        }
+
+        inline ScalarType *data()
+        {
+            return Elements;
+        }
+
+        inline const ScalarType *data() const
+        {
+            return Elements;
+        }
+
+        //! distance between two columns (rows when row-major) in data(), always the current inner size
+        inline int outerStride() const
+        {
+            return isRowMajor ? numCols : numRows;
+        }
+
+        //! distance between two coefficients of a column (row when row-major) in data()
+        constexpr int innerStride() const
+        {
+            return 1;
+        }
+
+        inline const ScalarType &coeff(int index) const
+        {
+            return Elements[storageIndex(index)];
+        }
+
+        inline const ScalarType &coeff(int row, int col) const
+        {
+            return Elements[storageIndex(row, col)];
+        }
+
+        inline ScalarType &coeffRef(int index)
+        {
+            return Elements[storageIndex(index)];
+        }
+
+        inline ScalarType &coeffRef(int row, int col)
+        {
+            return Elements[storageIndex(row, col)];
+        }
+
+        template <typename PacketType, bool Aligned = false>
+        inline PacketType packet(int index) const
+        {
+            return internal::ploadt<PacketType, Aligned>(Elements + index);
+        }
+
+        template <typename PacketType, bool Aligned = false>
+        inline void writePacket(int index, const PacketType &packet)
+        {
+            internal::pstoret<Aligned>(Elements + index, packet);
+        }
+
+        // consecutive coefficients along the inner dimension, starting at (row, col)
+        template <typename PacketType>
+        inline PacketType packet(int row, int col) const
+        {
+            return internal::ploadu<PacketType>(Elements + storageIndex(row, col));
+        }
+
+        template <typename PacketType>
+        inline void writePacket(int row, int col, const PacketType &packet)
+        {
+            internal::pstoreu(Elements + storageIndex(row, col), packet);
+        }
+
+        template <typename OtherDerived>
+        inline Derived &operator+=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::call_assignment(this->derived(), other.derived(), internal::add_assign_op());
+            return this->derived();
+        }
+
+        template <typename OtherDerived>
+        inline Derived &operator-=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::call_assignment(this->derived(), other.derived(), internal::sub_assign_op());
+            return this->derived();
+        }
+
+        //! assignments through the result write products straight into this matrix, which they must not read
+        inline EmbeddedNoAlias<Derived> noalias()
+        {
+            return EmbeddedNoAlias<Derived>(this->derived());
+        }
+
+        using Base::selfadjointView;
+
+        //! self-adjoint view that can also update this matrix, see EmbeddedSelfAdjointView::rankUpdate
+        template <int UpLo>
+        inline EmbeddedSelfAdjointView<Derived, UpLo> selfadjointView()
+        {
+            return EmbeddedSelfAdjointView<Derived, UpLo>(this->derived());
+        }
+
+        inline Derived &operator*=(const ScalarType factor)
+        {
+            internal::call_assignment(this->derived(), this->derived() * factor, internal::assign_op());
+            return this->derived();
+        }
+
+        inline Derived &operator/=(const ScalarType factor)
+        {
+            internal::call_assignment(this->derived(), this->derived() / factor, internal::assign_op());
+            return this->derived();
+        }
+
+        inline void setConstant(const ScalarType value)
+        {
+            const int length = size();
+            for (int i = 0; i < length; ++i)
+            {
+                Elements[i] = value;
+            }
+            return;
+        }
+
+        inline void setZero()
+        {
+            setConstant(static_cast<ScalarType>(0));
+            return;
+        }
+
+        inline void setIdentity()
+        {
+            setZero();
+            const int rank = (numRows < numCols) ? numRows : numCols;
+            for (int i = 0; i < rank; i++)
+            {
+                this->operator()(i, i) = static_cast<ScalarType>(1);
+            }
+            return;
+        }
+
+        static inline Derived Zero(int num_rows, int num_cols)
+        {
+            return Derived(num_rows, num_cols);
+        }
+
+        static inline Derived Ones(int num_rows, int num_cols)
+        {
+            Derived result(num_rows, num_cols, NoInit);
+            result.setConstant(static_cast<ScalarType>(1));
+            return result;
+        }
+
+        static inline Derived Identity(int num_rows, int num_cols)
+        {
+            Derived result(num_rows, num_cols, NoInit);
+            result.setIdentity();
+            return result;
+        }
+
+        inline void normalize()
+        {
+            *this /= this->norm();
+            return;
+        }
+
+        inline ScalarType trace() const
+        {
+            ScalarType result = 0;
+            const int rank = (numRows < numCols) ? numRows : numCols;
+            for (int i = 0; i < rank; i++)
+            {
+                result += this->operator()(i, i);
+            }
+            return result;
+        }
+
+        inline ScalarType determinant() const
+        {
+            PartialPivLU<Derived> lu(this->derived());
+            return lu.determinant();
+        }
+
+        inline Derived inverse() const
+        {
+            PartialPivLU<Derived> lu(this->derived());
+            return lu.inverse();
+        }
+
+        inline LLT<Derived> llt() const
+        {
+            return LLT<Derived>(this->derived());
+        }
+
+        inline LDLT<Derived> ldlt() const
+        {
+            return LDLT<Derived>(this->derived());
+        }
+
+        template <int subrows, int subcols>
+        inline EmbeddedBlockType<Derived, subrows, subcols> block(int startrows, int startcols)
+        {
+            return EmbeddedBlockType<Derived, subrows, subcols>(this->derived(), startrows, startcols);
+        }
+
+        template <int subrows, int subcols>
+        inline EmbeddedBlockType<const Derived, subrows, subcols> block(int startrows, int startcols) const
+        {
+            return EmbeddedBlockType<const Derived, subrows, subcols>(this->derived(), startrows, startcols);
+        }
+
+        inline EmbeddedRefType<Scalar, MaxRows, MaxCols, Dynamic, isRowMajor> block(int startrows, int startcols, int subrows, int subcols)
+        {
+            return EmbeddedRefType<Scalar, MaxRows, MaxCols, Dynamic, isRowMajor>(
+                *reinterpret_cast<Scalar(*)[maxSize]>(this->data()),
+                subrows, subcols, startrows, startcols, outerStride());
+        }
+
+        inline EmbeddedRefType<Scalar, MaxRows, MaxCols, Dynamic, isRowMajor> row(const int index)
+        {
+            return block(index, 0, 1, numCols);
+        }
+
+        inline EmbeddedRefType<Scalar, MaxRows, MaxCols, Dynamic, isRowMajor> col(const int index)
+        {
+            return block(0, index, numRows, 1);
+        }
+
+        // length coefficients of a bounded vector from start, the length fixed and the position at runtime
+        template <typename XprType, int length>
+        using SegmentType = EmbeddedBlockType<XprType, (Cols == 1) ? length : 1, (Cols == 1) ? 1 : length>;
+
+        template <int length>
+        inline SegmentType<Derived, length> segment(int start)
+        {
+            static_assert(Rows == 1 || Cols == 1, "segments are taken from vectors");
+            return SegmentType<Derived, length>(this->derived(), (Cols == 1) ? start : 0, (Cols == 1) ? 0 : start);
+        }
+
+        template <int length>
+        inline SegmentType<const Derived, length> segment(int start) const
+        {
+            static_assert(Rows == 1 || Cols == 1, "segments are taken from vectors");
+            return SegmentType<const Derived, length>(this->derived(), (Cols == 1) ? start : 0, (Cols == 1) ? 0 : start);
+        }
+
+        template <int length>
+        inline SegmentType<Derived, length> head()
+        {
+            return segment<length>(0);
+        }
+
+        template <int length>
+        inline SegmentType<const Derived, length> head() const
+        {
+            return segment<length>(0);
+        }
+
+        template <int length>
+        inline SegmentType<Derived, length> tail()
+        {
+            return segment<length>(numRows * numCols - length);
+        }
+
+        template <int length>
+        inline SegmentType<const Derived, length> tail() const
+        {
+            return segment<length>(numRows * numCols - length);
+        }
+    };
+
+    // Dynamic dimensions select EmbeddedBoundedType, e.g. Matrix<float, Dynamic, Dynamic, DefaultStorage, 8, 8>
+    template <typename ScalarType, int Options, int MaxRows, int MaxCols>
+    class EmbeddedCoreType<ScalarType, Dynamic, Dynamic, Options, MaxRows, MaxCols>
+        : public EmbeddedBoundedType<ScalarType, Dynamic, Dynamic, Options, MaxRows, MaxCols>
+    {
+    public:
+        using EmbeddedBoundedType<ScalarType, Dynamic, Dynamic, Options, MaxRows, MaxCols>::EmbeddedBoundedType;
+        using EmbeddedBoundedType<ScalarType, Dynamic, Dynamic, Options, MaxRows, MaxCols>::operator=;
+    };
+
+    template <typename ScalarType, int Cols, int Options, int MaxRows, int MaxCols>
+    class EmbeddedCoreType<ScalarType, Dynamic, Cols, Options, MaxRows, MaxCols>
+        : public EmbeddedBoundedType<ScalarType, Dynamic, Cols, Options, MaxRows, MaxCols>
+    {
+    public:
+        using EmbeddedBoundedType<ScalarType, Dynamic, Cols, Options, MaxRows, MaxCols>::EmbeddedBoundedType;
+        using EmbeddedBoundedType<ScalarType, Dynamic, Cols, Options, MaxRows, MaxCols>::operator=;
+    };
+
+    template <typename ScalarType, int Rows, int Options, int MaxRows, int MaxCols>
+    class EmbeddedCoreType<ScalarType, Rows, Dynamic, Options, MaxRows, MaxCols>
+        : public EmbeddedBoundedType<ScalarType, Rows, Dynamic, Options, MaxRows, MaxCols>
+    {
+    public:
+        using EmbeddedBoundedType<ScalarType, Rows, Dynamic, Options, MaxRows, MaxCols>::EmbeddedBoundedType;
+        using EmbeddedBoundedType<ScalarType, Rows, Dynamic, Options, MaxRows, MaxCols>::operator=;
+    };
+
+    namespace internal
+    {
+        // Portable kernels of the fixed-size products, all matrices column-major.
+        // The SIMD kernels below accumulate in the very same order, so both give bit-identical results.
+        template <typename T>
+        inline void matmul3x3_scalar(const T *lhs, const T *rhs, T *res)
+        {
+            res[0] = lhs[0] * rhs[0] + lhs[3] * rhs[1] + lhs[6] * rhs[2];
+            res[1] = lhs[1] * rhs[0] + lhs[4] * rhs[1] + lhs[7] * rhs[2];
+            res[2] = lhs[2] * rhs[0] + lhs[5] * rhs[1] + lhs[8] * rhs[2];
+            res[3] = lhs[0] * rhs[3] + lhs[3] * rhs[4] + lhs[6] * rhs[5];
+            res[4] = lhs[1] * rhs[3] + lhs[4] * rhs[4] + lhs[7] * rhs[5];
+            res[5] = lhs[2] * rhs[3] + lhs[5] * rhs[4] + lhs[8] * rhs[5];
+            res[6] = lhs[0] * rhs[6] + lhs[3] * rhs[7] + lhs[6] * rhs[8];
+            res[7] = lhs[1] * rhs[6] + lhs[4] * rhs[7] + lhs[7] * rhs[8];
+            res[8] = lhs[2] * rhs[6] + lhs[5] * rhs[7] + lhs[8] * rhs[8];
+        }
+
+        template <typename T>
+        inline void matmul4x4_scalar(const T *lhs, const T *rhs, T *res)
+        {
+            res[0] = lhs[0] * rhs[0] + lhs[4] * rhs[1] + lhs[8] * rhs[2] + lhs[12] * rhs[3];
+            res[1] = lhs[1] * rhs[0] + lhs[5] * rhs[1] + lhs[9] * rhs[2] + lhs[13] * rhs[3];
+            res[2] = lhs[2] * rhs[0] + lhs[6] * rhs[1] + lhs[10] * rhs[2] + lhs[14] * rhs[3];
+            res[3] = lhs[3] * rhs[0] + lhs[7] * rhs[1] + lhs[11] * rhs[2] + lhs[15] * rhs[3];
+            res[4] = lhs[0] * rhs[4] + lhs[4] * rhs[5] + lhs[8] * rhs[6] + lhs[12] * rhs[7];
+            res[5] = lhs[1] * rhs[4] + lhs[5] * rhs[5] + lhs[9] * rhs[6] + lhs[13] * rhs[7];
+            res[6] = lhs[2] * rhs[4] + lhs[6] * rhs[5] + lhs[10] * rhs[6] + lhs[14] * rhs[7];
+            res[7] = lhs[3] * rhs[4] + lhs[7] * rhs[5] + lhs[11] * rhs[6] + lhs[15] * rhs[7];
+            res[8] = lhs[0] * rhs[8] + lhs[4] * rhs[9] + lhs[8] * rhs[10] + lhs[12] * rhs[11];
+            res[9] = lhs[1] * rhs[8] + lhs[5] * rhs[9] + lhs[9] * rhs[10] + lhs[13] * rhs[11];
+            res[10] = lhs[2] * rhs[8] + lhs[6] * rhs[9] + lhs[10] * rhs[10] + lhs[14] * rhs[11];
+            res[11] = lhs[3] * rhs[8] + lhs[7] * rhs[9] + lhs[11] * rhs[10] + lhs[15] * rhs[11];
+            res[12] = lhs[0] * rhs[12] + lhs[4] * rhs[13] + lhs[8] * rhs[14] + lhs[12] * rhs[15];
+            res[13] = lhs[1] * rhs[12] + lhs[5] * rhs[13] + lhs[9] * rhs[14] + lhs[13] * rhs[15];
+            res[14] = lhs[2] * rhs[12] + lhs[6] * rhs[13] + lhs[10] * rhs[14] + lhs[14] * rhs[15];
+            res[15] = lhs[3] * rhs[12] + lhs[7] * rhs[13] + lhs[11] * rhs[14] + lhs[15] * rhs[15];
+        }
+
+        template <typename T>
+        inline void matvec3_scalar(const T *lhs, const T *rhs, T *res)
+        {
+            res[0] = lhs[0] * rhs[0] + lhs[3] * rhs[1] + lhs[6] * rhs[2];
+            res[1] = lhs[1] * rhs[0] + lhs[4] * rhs[1] + lhs[7] * rhs[2];
+            res[2] = lhs[2] * rhs[0] + lhs[5] * rhs[1] + lhs[8] * rhs[2];
+        }
+
+        template <typename T>
+        inline void matvec4_scalar(const T *lhs, const T *rhs, T *res)
+        {
+            res[0] = lhs[0] * rhs[0] + lhs[4] * rhs[1] + lhs[8] * rhs[2] + lhs[12] * rhs[3];
+            res[1] = lhs[1] * rhs[0] + lhs[5] * rhs[1] + lhs[9] * rhs[2] + lhs[13] * rhs[3];
+            res[2] = lhs[2] * rhs[0] + lhs[6] * rhs[1] + lhs[10] * rhs[2] + lhs[14] * rhs[3];
+            res[3] = lhs[3] * rhs[0] + lhs[7] * rhs[1] + lhs[11] * rhs[2] + lhs[15] * rhs[3];
+        }
+
+        // SIMD kernels: res(:, j) = lhs(:, 0) * rhs(0, j) + lhs(:, 1) * rhs(1, j) + ...
+        // Multiplies and adds are kept separate (no FMA) to round exactly like the scalar kernels.
+        // 3-row columns are loaded 4 wide where the 4th lane still lies inside the matrix, the last
+        // column is loaded and stored piecewise so no access goes past the end of the array.
+#if defined(EMBEDDEDMATH_SSE2)
+        inline void matmul4x4_simd(const float *lhs, const float *rhs, float *res)
+        {
+            const __m128 a0 = _mm_loadu_ps(lhs);
+            const __m128 a1 = _mm_loadu_ps(lhs + 4);
+            const __m128 a2 = _mm_loadu_ps(lhs + 8);
+            const __m128 a3 = _mm_loadu_ps(lhs + 12);
+            for (int j = 0; j < 4; ++j)
+            {
+                const float *b = rhs + 4 * j;
+                __m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[0]));
+                r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b[1])));
+                r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b[2])));
+                r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b[3])));
+                _mm_storeu_ps(res + 4 * j, r);
+            }
+        }
+
+        inline __m128 load3_ps(const float *p)
+        {
+            return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64 *>(p)), _mm_load_ss(p + 2));
+        }
+
+        inline void store3_ps(float *p, const __m128 &r)
+        {
+            _mm_storel_pi(reinterpret_cast<__m64 *>(p), r);
+            _mm_store_ss(p + 2, _mm_movehl_ps(r, r));
+        }
+
+        inline __m128 matvec3_ps(const __m128 &a0, const __m128 &a1, const __m128 &a2, const float *b)
+        {
+            __m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[0]));
+            r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b[1])));
+            return _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b[2])));
+        }
+
+        inline void matmul3x3_simd(const float *lhs, const float *rhs, float *res)
+        {
+            const __m128 a0 = _mm_loadu_ps(lhs);
+            const __m128 a1 = _mm_loadu_ps(lhs + 3);
+            const __m128 a2 = load3_ps(lhs + 6);
+            // the 4th lane of the first two columns spills into the next column and is overwritten right after
+            _mm_storeu_ps(res, matvec3_ps(a0, a1, a2, rhs));
+            _mm_storeu_ps(res + 3, matvec3_ps(a0, a1, a2, rhs + 3));
+            store3_ps(res + 6, matvec3_ps(a0, a1, a2, rhs + 6));
+        }
+
+        inline void matvec3_simd(const float *lhs, const float *rhs, float *res)
+        {
+            store3_ps(res, matvec3_ps(_mm_loadu_ps(lhs), _mm_loadu_ps(lhs + 3), load3_ps(lhs + 6), rhs));
+        }
+
+        inline void matvec4_simd(const float *lhs, const float *rhs, float *res)
+        {
+            __m128 r = _mm_mul_ps(_mm_loadu_ps(lhs), _mm_set1_ps(rhs[0]));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(lhs + 4), _mm_set1_ps(rhs[1])));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(lhs + 8), _mm_set1_ps(rhs[2])));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(lhs + 12), _mm_set1_ps(rhs[3])));
+            _mm_storeu_ps(res, r);
+        }
+
+#if defined(EMBEDDEDMATH_AVX)
+        inline __m256d matvec4_pd(const __m256d &a0, const __m256d &a1, const __m256d &a2, const __m256d &a3, const double *b)
+        {
+            __m256d r = _mm256_mul_pd(a0, _mm256_set1_pd(b[0]));
+            r = _mm256_add_pd(r, _mm256_mul_pd(a1, _mm256_set1_pd(b[1])));
+            r = _mm256_add_pd(r, _mm256_mul_pd(a2, _mm256_set1_pd(b[2])));
+            return _mm256_add_pd(r, _mm256_mul_pd(a3, _mm256_set1_pd(b[3])));
+        }
+
+        inline void matmul4x4_simd(const double *lhs, const double *rhs, double *res)
+        {
+            const __m256d a0 = _mm256_loadu_pd(lhs);
+            const __m256d a1 = _mm256_loadu_pd(lhs + 4);
+            const __m256d a2 = _mm256_loadu_pd(lhs + 8);
+            const __m256d a3 = _mm256_loadu_pd(lhs + 12);
+            for (int j = 0; j < 4; ++j)
+            {
+                _mm256_storeu_pd(res + 4 * j, matvec4_pd(a0, a1, a2, a3, rhs + 4 * j));
+            }
+        }
+
+        inline void matvec4_simd(const double *lhs, const double *rhs, double *res)
+        {
+            _mm256_storeu_pd(res, matvec4_pd(_mm256_loadu_pd(lhs), _mm256_loadu_pd(lhs + 4),
+                                             _mm256_loadu_pd(lhs + 8), _mm256_loadu_pd(lhs + 12), rhs));
+        }
+
+        inline __m256d matvec3_pd(const __m256d &a0, const __m256d &a1, const __m256d &a2, const double *b)
+        {
+            __m256d r = _mm256_mul_pd(a0, _mm256_set1_pd(b[0]));
+            r = _mm256_add_pd(r, _mm256_mul_pd(a1, _mm256_set1_pd(b[1])));
+            return _mm256_add_pd(r, _mm256_mul_pd(a2, _mm256_set1_pd(b[2])));
+        }
+
+        inline void matmul3x3_simd(const double *lhs, const double *rhs, double *res)
+        {
+            const __m256d a0 = _mm256_loadu_pd(lhs);
+            const __m256d a1 = _mm256_loadu_pd(lhs + 3);
+            const __m256d a2 = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(lhs + 6)), _mm_load_sd(lhs + 8), 1);
+            _mm256_storeu_pd(res, matvec3_pd(a0, a1, a2, rhs));
+            _mm256_storeu_pd(res + 3, matvec3_pd(a0, a1, a2, rhs + 3));
+            const __m256d r2 = matvec3_pd(a0, a1, a2, rhs + 6);
+            _mm_storeu_pd(res + 6, _mm256_castpd256_pd128(r2));
+            _mm_store_sd(res + 8, _mm256_extractf128_pd(r2, 1));
+        }
+#else
+        inline void matmul4x4_simd(const double *lhs, const double *rhs, double *res)
+        {
+            __m128d a[8];
+            for (int k = 0; k < 8; ++k)
+            {
+                a[k] = _mm_loadu_pd(lhs + 2 * k);
+            }
+            for (int j = 0; j < 4; ++j)
+            {
+                const double *b = rhs + 4 * j;
+                for (int h = 0; h < 2; ++h)
+                {
+                    __m128d r = _mm_mul_pd(a[h], _mm_set1_pd(b[0]));
+                    r = _mm_add_pd(r, _mm_mul_pd(a[2 + h], _mm_set1_pd(b[1])));
+                    r = _mm_add_pd(r, _mm_mul_pd(a[4 + h], _mm_set1_pd(b[2])));
+                    r = _mm_add_pd(r, _mm_mul_pd(a[6 + h], _mm_set1_pd(b[3])));
+                    _mm_storeu_pd(res + 4 * j + 2 * h, r);
+                }
+            }
+        }
+
+        inline void matvec4_simd(const double *lhs, const double *rhs, double *res)
+        {
+            for (int h = 0; h < 2; ++h)
+            {
+                __m128d r = _mm_mul_pd(_mm_loadu_pd(lhs + 2 * h), _mm_set1_pd(rhs[0]));
+                r = _mm_add_pd(r, _mm_mul_pd(_mm_loadu_pd(lhs + 4 + 2 * h), _mm_set1_pd(rhs[1])));
+                r = _mm_add_pd(r, _mm_mul_pd(_mm_loadu_pd(lhs + 8 + 2 * h), _mm_set1_pd(rhs[2])));
+                r = _mm_add_pd(r, _mm_mul_pd(_mm_loadu_pd(lhs + 12 + 2 * h), _mm_set1_pd(rhs[3])));
+                _mm_storeu_pd(res + 2 * h, r);
+            }
+        }
+
+        inline void matmul3x3_simd(const double *lhs, const double *rhs, double *res)
+        {
+            // rows 0-1 in one register, row 2 in the low lane of another
+            const __m128d a0 = _mm_loadu_pd(lhs), a0z = _mm_load_sd(lhs + 2);
+            const __m128d a1 = _mm_loadu_pd(lhs + 3), a1z = _mm_load_sd(lhs + 5);
+            const __m128d a2 = _mm_loadu_pd(lhs + 6), a2z = _mm_load_sd(lhs + 8);
+            for (int j = 0; j < 3; ++j)
+            {
+                const double *b = rhs + 3 * j;
+                const __m128d b0 = _mm_set1_pd(b[0]), b1 = _mm_set1_pd(b[1]), b2 = _mm_set1_pd(b[2]);
+                __m128d r = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a0, b0), _mm_mul_pd(a1, b1)), _mm_mul_pd(a2, b2));
+                __m128d rz = _mm_add_sd(_mm_add_sd(_mm_mul_sd(a0z, b0), _mm_mul_sd(a1z, b1)), _mm_mul_sd(a2z, b2));
+                _mm_storeu_pd(res + 3 * j, r);
+                _mm_store_sd(res + 3 * j + 2, rz);
+            }
+        }
+#endif
+
+        inline void matvec3_simd(const double *lhs, const double *rhs, double *res)
+        {
+            const __m128d b0 = _mm_set1_pd(rhs[0]), b1 = _mm_set1_pd(rhs[1]), b2 = _mm_set1_pd(rhs[2]);
+            __m128d r = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(lhs), b0), _mm_mul_pd(_mm_loadu_pd(lhs + 3), b1)),
+                                   _mm_mul_pd(_mm_loadu_pd(lhs + 6), b2));
+            __m128d rz = _mm_add_sd(_mm_add_sd(_mm_mul_sd(_mm_load_sd(lhs + 2), b0), _mm_mul_sd(_mm_load_sd(lhs + 5), b1)),
+                                    _mm_mul_sd(_mm_load_sd(lhs + 8), b2));
+            _mm_storeu_pd(res, r);
+            _mm_store_sd(res + 2, rz);
+        }
+
+        template <typename T>
+        struct has_simd_kernels
+        {
+            static constexpr bool value = std::is_same<T, float>::value || std::is_same<T, double>::value;
+        };
+#elif defined(EMBEDDEDMATH_NEON)
+        inline float32x4_t matvec4_f32(const float32x4_t &a0, const float32x4_t &a1, const float32x4_t &a2, const float32x4_t &a3, const float *b)
+        {
+            float32x4_t r = vmulq_n_f32(a0, b[0]);
+            r = vaddq_f32(r, vmulq_n_f32(a1, b[1]));
+            r = vaddq_f32(r, vmulq_n_f32(a2, b[2]));
+            return vaddq_f32(r, vmulq_n_f32(a3, b[3]));
+        }
+
+        inline void matmul4x4_simd(const float *lhs, const float *rhs, float *res)
+        {
+            const float32x4_t a0 = vld1q_f32(lhs);
+            const float32x4_t a1 = vld1q_f32(lhs + 4);
+            const float32x4_t a2 = vld1q_f32(lhs + 8);
+            const float32x4_t a3 = vld1q_f32(lhs + 12);
+            for (int j = 0; j < 4; ++j)
+            {
+                vst1q_f32(res + 4 * j, matvec4_f32(a0, a1, a2, a3, rhs + 4 * j));
+            }
+        }
+
+        inline void matvec4_simd(const float *lhs, const float *rhs, float *res)
+        {
+            vst1q_f32(res, matvec4_f32(vld1q_f32(lhs), vld1q_f32(lhs + 4), vld1q_f32(lhs + 8), vld1q_f32(lhs + 12), rhs));
+        }
+
+        inline float32x4_t load3_f32(const float *p)
+        {
+            return vld1q_lane_f32(p + 2, vcombine_f32(vld1_f32(p), vdup_n_f32(0.0f)), 2);
+        }
+
+        inline void store3_f32(float *p, const float32x4_t &r)
+        {
+            vst1_f32(p, vget_low_f32(r));
+            vst1q_lane_f32(p + 2, r, 2);
+        }
+
+        inline float32x4_t matvec3_f32(const float32x4_t &a0, const float32x4_t &a1, const float32x4_t &a2, const float *b)
+        {
+            float32x4_t r = vmulq_n_f32(a0, b[0]);
+            r = vaddq_f32(r, vmulq_n_f32(a1, b[1]));
+            return vaddq_f32(r, vmulq_n_f32(a2, b[2]));
+        }
+
+        inline void matmul3x3_simd(const float *lhs, const float *rhs, float *res)
+        {
+            const float32x4_t a0 = vld1q_f32(lhs);
+            const float32x4_t a1 = vld1q_f32(lhs + 3);
+            const float32x4_t a2 = load3_f32(lhs + 6);
+            vst1q_f32(res, matvec3_f32(a0, a1, a2, rhs));
+            vst1q_f32(res + 3, matvec3_f32(a0, a1, a2, rhs + 3));
+            store3_f32(res + 6, matvec3_f32(a0, a1, a2, rhs + 6));
+        }
+
+        inline void matvec3_simd(const float *lhs, const float *rhs, float *res)
+        {
+            store3_f32(res, matvec3_f32(vld1q_f32(lhs), vld1q_f32(lhs + 3), load3_f32(lhs + 6), rhs));
+        }
+
+#if defined(__aarch64__)
+        inline float64x2_t matvec4_f64(const float64x2_t *a, const double *b)
+        {
+            float64x2_t r = vmulq_n_f64(a[0], b[0]);
+            r = vaddq_f64(r, vmulq_n_f64(a[2], b[1]));
+            r = vaddq_f64(r, vmulq_n_f64(a[4], b[2]));
+            return vaddq_f64(r, vmulq_n_f64(a[6], b[3]));
+        }
+
+        inline void matmul4x4_simd(const double *lhs, const double *rhs, double *res)
+        {
+            float64x2_t a[8];
+            for (int k = 0; k < 8; ++k)
+            {
+                a[k] = vld1q_f64(lhs + 2 * k);
+            }
+            for (int j = 0; j < 4; ++j)
+            {
+                vst1q_f64(res + 4 * j, matvec4_f64(a, rhs + 4 * j));
+                vst1q_f64(res + 4 * j + 2, matvec4_f64(a + 1, rhs + 4 * j));
+            }
+        }
+
+        inline void matvec4_simd(const double *lhs, const double *rhs, double *res)
+        {
+            float64x2_t a[8];
+            for (int k = 0; k < 8; ++k)
+            {
+                a[k] = vld1q_f64(lhs + 2 * k);
+            }
+            vst1q_f64(res, matvec4_f64(a, rhs));
+            vst1q_f64(res + 2, matvec4_f64(a + 1, rhs));
+        }
+
+        inline void matmul3x3_simd(const double *lhs, const double *rhs, double *res)
+        {
+            // rows 0-1 in one register, row 2 in scalar code
+            const float64x2_t a0 = vld1q_f64(lhs), a1 = vld1q_f64(lhs + 3), a2 = vld1q_f64(lhs + 6);
+            for (int j = 0; j < 3; ++j)
+            {
+                const double *b = rhs + 3 * j;
+                float64x2_t r = vaddq_f64(vaddq_f64(vmulq_n_f64(a0, b[0]), vmulq_n_f64(a1, b[1])), vmulq_n_f64(a2, b[2]));
+                vst1q_f64(res + 3 * j, r);
+                res[3 * j + 2] = lhs[2] * b[0] + lhs[5] * b[1] + lhs[8] * b[2];
+            }
+        }
+
+        inline void matvec3_simd(const double *lhs, const double *rhs, double *res)
+        {
+            float64x2_t r = vaddq_f64(vaddq_f64(vmulq_n_f64(vld1q_f64(lhs), rhs[0]), vmulq_n_f64(vld1q_f64(lhs + 3), rhs[1])),
+                                      vmulq_n_f64(vld1q_f64(lhs + 6), rhs[2]));
+            vst1q_f64(res, r);
+            res[2] = lhs[2] * rhs[0] + lhs[5] * rhs[1] + lhs[8] * rhs[2];
+        }
+
+        template <typename T>
+        struct has_simd_kernels
+        {
+            static constexpr bool value = std::is_same<T, float>::value || std::is_same<T, double>::value;
+        };
+#else
+        template <typename T>
+        struct has_simd_kernels
+        {
+            static constexpr bool value = std::is_same<T, float>::value;
+        };
+#endif
+#else
+        template <typename T>
+        struct has_simd_kernels
+        {
+            static constexpr bool value = false;
+        };
+#endif
+
+        // dispatch at compile time: SIMD for float/double when the target has it, scalar otherwise
+        template <typename T>
+        inline void matmul3x3(const T *lhs, const T *rhs, T *res)
+        {
+            if constexpr (has_simd_kernels<T>::value)
+                matmul3x3_simd(lhs, rhs, res);
+            else
+                matmul3x3_scalar(lhs, rhs, res);
+        }
+
+        template <typename T>
+        inline void matmul4x4(const T *lhs, const T *rhs, T *res)
+        {
+            if constexpr (has_simd_kernels<T>::value)
+                matmul4x4_simd(lhs, rhs, res);
+            else
+                matmul4x4_scalar(lhs, rhs, res);
+        }
+
+        template <typename T>
+        inline void matvec3(const T *lhs, const T *rhs, T *res)
+        {
+            if constexpr (has_simd_kernels<T>::value)
+                matvec3_simd(lhs, rhs, res);
+            else
+                matvec3_scalar(lhs, rhs, res);
+        }
+
+        template <typename T>
+        inline void matvec4(const T *lhs, const T *rhs, T *res)
+        {
+            if constexpr (has_simd_kernels<T>::value)
+                matvec4_simd(lhs, rhs, res);
+            else
+                matvec4_scalar(lhs, rhs, res);
+        }
+
+        // Product kernel for padded storage: res(:, j) = lhs(:, 0) * rhs(0, j) + lhs(:, 1) * rhs(1, j) + ...
+        // computed in whole packets per column. The last packet of a column runs into the padding instead
+        // of needing a scalar tail, so both strides must be multiples of the packet size.
+        template <typename T, int Rows, int Depth, int Cols, int LhsStride, int ResStride, bool Aligned, typename RhsType>
+        inline void matmul_padded(const T *lhs, const RhsType &rhs, T *res)
+        {
+            using Packet = typename packet_traits<T>::type;
+            constexpr int PacketSize = packet_traits<T>::size;
+            static_assert(LhsStride % PacketSize == 0 && ResStride % PacketSize == 0, "strides must be multiples of the packet size");
+            for (int j = 0; j < Cols; ++j)
+            {
+                for (int i = 0; i < Rows; i += PacketSize)
+                {
+                    Packet r = ploadt<Packet, Aligned>(lhs + i) * pset1<Packet>(rhs(0, j));
+                    for (int k = 1; k < Depth; ++k)
+                    {
+                        r = r + ploadt<Packet, Aligned>(lhs + k * LhsStride + i) * pset1<Packet>(rhs(k, j));
+                    }
+                    pstoret<Aligned>(res + j * ResStride + i, r);
+                }
+            }
+        }
+
+        // dot products of one row of lhs with the NC columns of rhs from column j on, read in packets straight from
+        // storage. The NC sums share each packet of the row and are independent, so they overlap in the pipeline.
+        template <typename T, int Depth, typename ResType, typename Functor, int... Cs>
+        inline void matmul_dot_tile(const T *row, const T *rhs, int rhsStride, ResType &res, int i, int j, T alpha, const Functor &func,
+                                    std::integer_sequence<int, Cs...>)
+        {
+            using Packet = typename packet_traits<T>::type;
+            constexpr int PacketSize = packet_traits<T>::size;
+            constexpr int FullDepth = PacketSize > 1 ? Depth / PacketSize * PacketSize : 0;
+            T sums[sizeof...(Cs)] = {};
+            if constexpr (FullDepth > 0)
+            {
+                const Packet first = ploadu<Packet>(row);
+                Packet acc[sizeof...(Cs)] = {(first * ploadu<Packet>(rhs + (j + Cs) * rhsStride))...};
+                for (int k = PacketSize; k < FullDepth; k += PacketSize)
+                {
+                    const Packet a = ploadu<Packet>(row + k);
+                    ((acc[Cs] = acc[Cs] + a * ploadu<Packet>(rhs + (j + Cs) * rhsStride + k)), ...);
+                }
+                ((sums[Cs] = predux<T>(acc[Cs], scalar_sum_op<T>())), ...);
+            }
+            for (int k = FullDepth; k < Depth; ++k)
+            {
+                ((sums[Cs] += row[k] * rhs[(j + Cs) * rhsStride + k]), ...);
+            }
+            (func.assignCoeff(res.coeffRef(i, j + Cs), alpha * sums[Cs]), ...);
+        }
+
+        // Product kernel for a lhs with contiguous rows and a rhs with contiguous columns: res(i, j) is the dot
+        // product of row i of lhs and column j of rhs, for 4 columns at a time. This covers a row-major lhs, and
+        // v^T * M with a contiguous row vector. Like in matmul_runtime the sums times alpha are assigned, added
+        // or subtracted by func.
+        template <typename T, int Rows, int Depth, int Cols, typename ResType, typename Functor = assign_op>
+        inline void matmul_dot(const T *lhs, int lhsStride, const T *rhs, int rhsStride, ResType &res, T alpha = 1, const Functor &func = Functor())
+        {
+            constexpr int TileCols = 4;
+            constexpr int TileEnd = Cols / TileCols * TileCols;
+            for (int i = 0; i < Rows; ++i)
+            {
+                const T *row = lhs + i * lhsStride;
+                for (int j = 0; j < TileEnd; j += TileCols)
+                {
+                    matmul_dot_tile<T, Depth>(row, rhs, rhsStride, res, i, j, alpha, func, std::make_integer_sequence<int, TileCols>());
+                }
+                if constexpr (TileEnd < Cols)
+                {
+                    matmul_dot_tile<T, Depth>(row, rhs, rhsStride, res, i, TileEnd, alpha, func, std::make_integer_sequence<int, Cols - TileEnd>());
+                }
+            }
+        }
+
+        // Product kernel for sizes only known at runtime: res(:, j) = lhs(:, 0) * rhs(0, j) + lhs(:, 1) * rhs(1, j) + ...
+        // in packets down each column of a column-major lhs and res, with a scalar tail. The sum times alpha is
+        // assigned to, added to or subtracted from res by func.
+        template <typename T, typename RhsType, typename Functor = assign_op>
+        inline void matmul_runtime(const T *lhs, int lhsStride, const RhsType &rhs, T *res, int resStride, int rows, int depth, int cols,
+                                   T alpha = 1, const Functor &func = Functor())
+        {
+            using Packet = typename packet_traits<T>::type;
+            constexpr int PacketSize = packet_traits<T>::size;
+            const int fullRows = (PacketSize > 1) ? rows / PacketSize * PacketSize : 0;
+            for (int j = 0; j < cols; ++j)
+            {
+                T *resCol = res + j * resStride;
+                if constexpr (PacketSize > 1)
+                {
+                    for (int i = 0; i < fullRows; i += PacketSize)
+                    {
+                        Packet r = pset1<Packet>(static_cast<T>(0));
+                        for (int k = 0; k < depth; ++k)
+                        {
+                            r = r + ploadu<Packet>(lhs + k * lhsStride + i) * pset1<Packet>(rhs(k, j));
+                        }
+                        pstoreu(resCol + i, func.assignPacket(ploadu<Packet>(resCol + i), r * pset1<Packet>(alpha)));
+                    }
+                }
+                for (int i = fullRows; i < rows; ++i)
+                {
+                    T sum = 0;
+                    for (int k = 0; k < depth; ++k)
+                    {
+                        sum += lhs[k * lhsStride + i] * rhs(k, j);
+                    }
+                    func.assignCoeff(resCol[i], alpha * sum);
+                }
+            }
+        }
+
+        // rows [Row, Rows) of one column of an unrolled product: res(i, j) = lhs(i, 0) * rhs(0, j) + lhs(i, 1) * rhs(1, j) + ...
+        // in packets of Bytes while whole ones fit, then in narrower packets and at last scalars, so the
+        // unrolled sums cover every row without a loop
+        template <typename T, int Bytes, int Row, int Rows, typename RhsType, typename Functor, int... Ks>
+        inline void matmul_unrolled_rows(const T *lhs, int lhsStride, const RhsType &rhs, int j, T *resCol, T alpha, const Functor &func,
+                                         std::integer_sequence<int, Ks...> ks)
+        {
+            using Packet = typename packet_traits<T, Bytes>::type;
+            constexpr int PacketSize = packet_traits<T, Bytes>::size;
+            if constexpr (Row + PacketSize <= Rows)
+            {
+                Packet r = ploadu<Packet>(lhs + Row) * pset1<Packet>(rhs(0, j));
+                ((r = r + ploadu<Packet>(lhs + (Ks + 1) * lhsStride + Row) * pset1<Packet>(rhs(Ks + 1, j))), ...);
+                pstoreu(resCol + Row, func.assignPacket(ploadu<Packet>(resCol + Row), r * pset1<Packet>(alpha)));
+                matmul_unrolled_rows<T, Bytes, Row + PacketSize, Rows>(lhs, lhsStride, rhs, j, resCol, alpha, func, ks);
+            }
+            else if constexpr (PacketSize > 1)
+            {
+                matmul_unrolled_rows<T, Bytes / 2, Row, Rows>(lhs, lhsStride, rhs, j, resCol, alpha, func, ks);
+            }
+        }
+
+        // Product kernel for fixed sizes up to 8: res(:, j) = lhs(:, 0) * rhs(0, j) + lhs(:, 1) * rhs(1, j) + ...
+        // for a column-major lhs and res, streaming whole columns of lhs. The sums over k and the packets down
+        // each column are unrolled at compile time, columns are a loop to keep the code small. Like in
+        // matmul_runtime the sums times alpha are assigned, added or subtracted by func.
+        template <typename T, int Rows, int Depth, int Cols, typename RhsType, typename Functor = assign_op>
+        inline void matmul_unrolled(const T *lhs, int lhsStride, const RhsType &rhs, T *res, int resStride,
+                                    T alpha = 1, const Functor &func = Functor())
+        {
+            for (int j = 0; j < Cols; ++j)
+            {
+                matmul_unrolled_rows<T, EMBEDDEDMATH_PACKET_BYTES, 0, Rows>(lhs, lhsStride, rhs, j, res + j * resStride, alpha, func,
+                                                                           std::make_integer_sequence<int, Depth - 1>());
+            }
+        }
+
+        // Register tile of a blocked product: MP packets of rows of res by NC columns, summed over the whole depth.
+        // The MP * NC accumulators stay in registers, each packet of lhs is used NC times and each coefficient of
+        // rhs MP times, so a step over k loads MP + NC values for MP * NC multiply-adds.
+        template <typename T, int Bytes, int MP, int NC, int Depth, typename RhsType, typename Functor, int... Ps, int... Cs>
+        inline void matmul_tile(const T *lhs, int lhsStride, const RhsType &rhs, int j, T *res, int resStride, T alpha, const Functor &func,
+                                std::integer_sequence<int, Ps...>, std::integer_sequence<int, Cs...>)
+        {
+            using Packet = typename packet_traits<T, Bytes>::type;
+            constexpr int PacketSize = packet_traits<T, Bytes>::size;
+            Packet acc[MP * NC];
+            const auto init = [&](auto c)
+            {
+                const Packet b = pset1<Packet>(rhs(0, j + c));
+                ((acc[Ps * NC + c] = ploadu<Packet>(lhs + Ps * PacketSize) * b), ...);
+            };
+            (init(std::integral_constant<int, Cs>()), ...);
+            for (int k = 1; k < Depth; ++k)
+            {
+                const T *col = lhs + k * lhsStride;
+                const Packet a[MP] = {ploadu<Packet>(col + Ps * PacketSize)...};
+                const auto update = [&](auto c)
+                {
+                    const Packet b = pset1<Packet>(rhs(k, j + c));
+                    ((acc[Ps * NC + c] = acc[Ps * NC + c] + a[Ps] * b), ...);
+                };
+                (update(std::integral_constant<int, Cs>()), ...);
+            }
+            const auto store = [&](auto c)
+            {
+                T *resCol = res + c * resStride;
+                ((pstoreu(resCol + Ps * PacketSize, func.assignPacket(ploadu<Packet>(resCol + Ps * PacketSize), acc[Ps * NC + c] * pset1<Packet>(alpha)))), ...);
+            };
+            (store(std::integral_constant<int, Cs>()), ...);
+        }
+
+        // rows [Row, Rows) of a panel of NC columns of a blocked product: tiles of MP packets of Bytes while they
+        // fit, then one tile of the whole packets left, then the rows left in narrower packets and at last scalars
+        template <typename T, int Bytes, int MP, int Row, int Rows, int NC, int Depth, typename RhsType, typename Functor>
+        inline void matmul_panel(const T *lhs, int lhsStride, const RhsType &rhs, int j, T *res, int resStride, T alpha, const Functor &func)
+        {
+            constexpr int PacketSize = packet_traits<T, Bytes>::size;
+            constexpr int TileEnd = Row + (Rows - Row) / (MP * PacketSize) * (MP * PacketSize);
+            constexpr int Packets = (Rows - TileEnd) / PacketSize;
+            constexpr int Next = TileEnd + Packets * PacketSize;
+            for (int i = Row; i < TileEnd; i += MP * PacketSize)
+            {
+                matmul_tile<T, Bytes, MP, NC, Depth>(lhs + i, lhsStride, rhs, j, res + i, resStride, alpha, func,
+                                                     std::make_integer_sequence<int, MP>(), std::make_integer_sequence<int, NC>());
+            }
+            if constexpr (Packets > 0)
+            {
+                matmul_tile<T, Bytes, Packets, NC, Depth>(lhs + TileEnd, lhsStride, rhs, j, res + TileEnd, resStride, alpha, func,
+                                                          std::make_integer_sequence<int, Packets>(), std::make_integer_sequence<int, NC>());
+            }
+            if constexpr (Next < Rows && PacketSize > 1)
+            {
+                matmul_panel<T, Bytes / 2, MP, Next, Rows, NC, Depth>(lhs, lhsStride, rhs, j, res, resStride, alpha, func);
+            }
+        }
+
+        // MP packets of rows of a matrix-vector product, with the sum over k split into U interleaved partial sums
+        // per packet: k = u, u + U, u + 2U, ... accumulates into sum u. With few rows this still keeps several
+        // independent additions in flight instead of one chain as long as the depth.
+        template <typename T, int Bytes, int MP, int U, int Depth, typename RhsType, typename Functor, int... Ps, int... Us>
+        inline void matvec_tile(const T *lhs, int lhsStride, const RhsType &rhs, T *res, T alpha, const Functor &func,
+                                std::integer_sequence<int, Ps...>, std::integer_sequence<int, Us...>)
+        {
+            using Packet = typename packet_traits<T, Bytes>::type;
+            constexpr int PacketSize = packet_traits<T, Bytes>::size;
+            constexpr int StepEnd = Depth / U * U;
+            Packet acc[MP * U];
+            const auto init = [&](auto u)
+            {
+                const Packet b = pset1<Packet>(rhs(u, 0));
+                ((acc[Ps * U + u] = ploadu<Packet>(lhs + u * lhsStride + Ps * PacketSize) * b), ...);
+            };
+            (init(std::integral_constant<int, Us>()), ...);
+            for (int k = U; k < StepEnd; k += U)
+            {
+                const auto update = [&](auto u)
+                {
+                    const Packet b = pset1<Packet>(rhs(k + u, 0));
+                    ((acc[Ps * U + u] = acc[Ps * U + u] + ploadu<Packet>(lhs + (k + u) * lhsStride + Ps * PacketSize) * b), ...);
+                };
+                (update(std::integral_constant<int, Us>()), ...);
+            }
+            for (int k = StepEnd; k < Depth; ++k)
+            {
+                const Packet b = pset1<Packet>(rhs(k, 0));
+                ((acc[Ps * U] = acc[Ps * U] + ploadu<Packet>(lhs + k * lhsStride + Ps * PacketSize) * b), ...);
+            }
+            const auto store = [&](auto p)
+            {
+                Packet sum = acc[p * U];
+                ((sum = Us > 0 ? sum + acc[p * U + Us] : sum), ...);
+                pstoreu(res + p * PacketSize, func.assignPacket(ploadu<Packet>(res + p * PacketSize), sum * pset1<Packet>(alpha)));
+            };
+            (store(std::integral_constant<int, Ps>()), ...);
+        }
+
+        // rows [Row, Rows) of a matrix-vector product: tiles of 4 packets of Bytes while they fit, then one tile of
+        // the whole packets left, then the rows left in narrower packets and at last scalars. Tiles of fewer than
+        // 4 packets split the sum over k to keep 4 partial sums.
+        template <typename T, int Bytes, int Row, int Rows, int Depth, typename RhsType, typename Functor>
+        inline void matvec_rows(const T *lhs, int lhsStride, const RhsType &rhs, T *res, T alpha, const Functor &func)
+        {
+            constexpr int PacketSize = packet_traits<T, Bytes>::size;
+            constexpr int TileEnd = Row + (Rows - Row) / (4 * PacketSize) * (4 * PacketSize);
+            constexpr int Packets = (Rows - TileEnd) / PacketSize;
+            constexpr int Next = TileEnd + Packets * PacketSize;
+            for (int i = Row; i < TileEnd; i += 4 * PacketSize)
+            {
+                matvec_tile<T, Bytes, 4, 1, Depth>(lhs + i, lhsStride, rhs, res + i, alpha, func,
+                                                   std::make_integer_sequence<int, 4>(), std::make_integer_sequence<int, 1>());
+            }
+            if constexpr (Packets > 0)
+            {
+                constexpr int U = Depth >= 4 / Packets ? 4 / Packets : 1;
+                matvec_tile<T, Bytes, Packets, U, Depth>(lhs + TileEnd, lhsStride, rhs, res + TileEnd, alpha, func,
+                                                         std::make_integer_sequence<int, Packets>(), std::make_integer_sequence<int, U>());
+            }
+            if constexpr (Next < Rows && PacketSize > 1)
+            {
+                matvec_rows<T, Bytes / 2, Next, Rows, Depth>(lhs, lhsStride, rhs, res, alpha, func);
+            }
+        }
+
+        // Matrix-vector kernel for fixed sizes beyond 8, res = lhs * rhs with a single column of rhs, e.g. H * x or
+        // F * dx: res = lhs(:, 0) * rhs(0) + lhs(:, 1) * rhs(1) + ... down the columns of lhs. Every coefficient
+        // of lhs is used once, so the tiles keep 4 independent sums to keep the loads busy rather than to reuse
+        // registers.
+        template <typename T, int Rows, int Depth, typename RhsType, typename Functor = assign_op>
+        inline void matvec_columns(const T *lhs, int lhsStride, const RhsType &rhs, T *res, T alpha = 1, const Functor &func = Functor())
+        {
+            matvec_rows<T, EMBEDDEDMATH_PACKET_BYTES, 0, Rows, Depth>(lhs, lhsStride, rhs, res, alpha, func);
+        }
+
+        // Product kernel for fixed sizes beyond 8, e.g. the 15x15 to 60x60 covariances of error-state filters.
+        // res is computed in register tiles of two packets of rows by 4 columns (8x4 floats with SSE) over the
+        // whole depth by matmul_tile. Panels of 4 columns of rhs and res are visited in turn and every panel
+        // sweeps all of lhs, which at 64x64 floats is 16 KiB and stays in the L1 cache. Columns of lhs are read
+        // in place, no packing is needed at these sizes. A single column goes to matvec_columns. Like in
+        // matmul_runtime the sums times alpha are assigned, added or subtracted by func.
+        template <typename T, int Rows, int Depth, int Cols, typename RhsType, typename Functor = assign_op>
+        inline void matmul_blocked(const T *lhs, int lhsStride, const RhsType &rhs, T *res, int resStride,
+                                   T alpha = 1, const Functor &func = Functor())
+        {
+            constexpr int PanelCols = 4;
+            constexpr int PanelEnd = Cols / PanelCols * PanelCols;
+            if constexpr (Cols == 1)
+            {
+                matvec_columns<T, Rows, Depth>(lhs, lhsStride, rhs, res, alpha, func);
+            }
+            else
+            {
+                for (int j = 0; j < PanelEnd; j += PanelCols)
+                {
+                    matmul_panel<T, EMBEDDEDMATH_PACKET_BYTES, 2, 0, Rows, PanelCols, Depth>(lhs, lhsStride, rhs, j, res + j * resStride,
+                                                                                             resStride, alpha, func);
+                }
+                if constexpr (PanelEnd < Cols)
+                {
+                    matmul_panel<T, EMBEDDEDMATH_PACKET_BYTES, 2, 0, Rows, Cols - PanelEnd, Depth>(lhs, lhsStride, rhs, PanelEnd,
+                                                                                                   res + PanelEnd * resStride, resStride, alpha, func);
+                }
+            }
+        }
+
+        // Product with a view or transpose operand, reading both through their data pointers and strides:
+        // - a lhs with consecutive coefficients in its rows, row-major or a contiguous row vector beyond 8, and a
+        //   rhs with consecutive coefficients in its columns go to matmul_dot, e.g. A.transpose() * B or
+        //   v.transpose() * M;
+        // - otherwise a column-major lhs with consecutive coefficients in its columns, or a row vector, goes to
+        //   the column kernels with rhs read by coefficient, e.g. A * B.transpose();
+        // - anything else is computed coefficient by coefficient.
+        template <typename LhsType, typename RhsType, typename ResultType>
+        constexpr void view_product(const LhsType &lhs, const RhsType &rhs, ResultType &result)
+        {
+            using T = typename traits<LhsType>::Scalar;
+            using LhsPlain = typename product_operand<LhsType>::plain;
+            using RhsPlain = typename product_operand<RhsType>::plain;
+            constexpr int Rows = traits<LhsType>::RowsAtCompileTime;
+            constexpr int Depth = traits<LhsType>::ColsAtCompileTime;
+            constexpr int Cols = traits<RhsType>::ColsAtCompileTime;
+            constexpr bool LhsColumns = (!traits<LhsPlain>::IsRowMajor && traits<LhsPlain>::MapInnerStride == 1) || Rows == 1;
+            constexpr bool Unrolled = Rows <= 8 && Depth <= 8 && Cols <= 8;
+            constexpr bool LhsRows = traits<LhsPlain>::IsRowMajor ? traits<LhsPlain>::MapInnerStride == 1
+                                                                  : Rows == 1 && traits<LhsPlain>::MapOuterStride == 1;
+            constexpr bool DotKernel = LhsRows && traits<RhsPlain>::HasDirectAccess && !traits<RhsPlain>::IsRowMajor &&
+                                       traits<RhsPlain>::MapInnerStride == 1;
+            typename product_operand<LhsType>::type lhsEval(lhs);
+            typename product_operand<RhsType>::type rhsEval(rhs);
+
+            if (is_constant_evaluated() || !(LhsColumns || DotKernel))
+            {
+                for (int j = 0; j < Cols; ++j)
+                {
+                    for (int i = 0; i < Rows; ++i)
+                    {
+                        T sum = 0;
+                        for (int k = 0; k < Depth; ++k)
+                        {
+                            sum += lhsEval(i, k) * rhsEval(k, j);
+                        }
+                        result(i, j) = sum;
+                    }
+                }
+            }
+            else if constexpr (DotKernel && (!LhsColumns || !Unrolled))
+            {
+                const int lhsStride = Rows == 1 ? 0 : lhsEval.outerStride();
+                matmul_dot<T, Rows, Depth, Cols>(lhsEval.data(), lhsStride, rhsEval.data(), rhsEval.outerStride(), result);
+            }
+            else if constexpr (LhsColumns)
+            {
+                // a row vector is stored like a column-major matrix with a leading dimension of its coefficient stride
+                const int lhsStride = traits<LhsPlain>::IsRowMajor ? lhsEval.innerStride() : lhsEval.outerStride();
+                const int resStride = ResultType::IsRowMajor ? 1 : result.outerStride();
+                if constexpr (Unrolled)
+                    matmul_unrolled<T, Rows, Depth, Cols>(lhsEval.data(), lhsStride, rhsEval, result.data(), resStride);
+                else
+                    matmul_blocked<T, Rows, Depth, Cols>(lhsEval.data(), lhsStride, rhsEval, result.data(), resStride);
+            }
+        }
+
+        // Product of two plain fixed-size matrices, into a result with the storage options of lhs
+        template <typename T, int R1, int C1_R2, int C2, int O1, int O2>
+        constexpr void fixed_product(const EmbeddedCoreType<T, R1, C1_R2, O1> &lhs, const EmbeddedCoreType<T, C1_R2, C2, O2> &rhs,
+                                     EmbeddedCoreType<T, R1, C2, O1> &result)
+        {
+            using LhsType = EmbeddedCoreType<T, R1, C1_R2, O1>;
+            using RhsType = EmbeddedCoreType<T, C1_R2, C2, O2>;
+            using ResultType = EmbeddedCoreType<T, R1, C2, O1>;
+            constexpr bool LhsRowMajor = traits<LhsType>::IsRowMajor;
+            constexpr bool RhsRowMajor = traits<RhsType>::IsRowMajor;
+            constexpr bool ResRowMajor = traits<ResultType>::IsRowMajor;
+            // the fixed-size kernels expect contiguous columns
+            constexpr bool Dense = traits<LhsType>::HasLinearAccess && traits<RhsType>::HasLinearAccess &&
+                                   traits<ResultType>::HasLinearAccess && !LhsRowMajor && !RhsRowMajor && !ResRowMajor;
+            constexpr int PacketSize = packet_traits<T>::size;
+            constexpr int LhsStride = traits<LhsType>::OuterStride;
+            constexpr int RhsStride = traits<RhsType>::OuterStride;
+            constexpr int ResStride = traits<ResultType>::OuterStride;
+            constexpr bool PaddedKernel = !LhsRowMajor && !ResRowMajor && (LhsStride != R1 || ResStride != R1) &&
+                                          LhsStride % PacketSize == 0 && ResStride % PacketSize == 0;
+            // column-axpy kernels, columns of a column-major lhs streamed into columns of res, unrolled up to 8
+            // and blocked in register tiles beyond
+            constexpr bool ColumnKernel = !LhsRowMajor && (!ResRowMajor || R1 == 1);
+            constexpr bool TransposedKernel = RhsRowMajor && ResRowMajor;
+            constexpr bool Unrolled = R1 <= 8 && C1_R2 <= 8 && C2 <= 8;
+            // v^T * M beyond 8: dot products of the contiguous row vector with columns of rhs
+            constexpr bool RowVectorKernel = R1 == 1 && (LhsRowMajor || LhsStride == 1) && !RhsRowMajor && !Unrolled;
+
+            if (is_constant_evaluated())
+            {
+                for (int j = 0; j < C2; ++j)
+                {
+                    for (int i = 0; i < R1; ++i)
+                    {
+                        T sum = 0;
+                        for (int k = 0; k < C1_R2; ++k)
+                        {
+                            sum += lhs(i, k) * rhs(k, j);
+                        }
+                        result(i, j) = sum;
+                    }
+                }
+            }
+            else if constexpr (R1 == 1 && C1_R2 == 1 && C2 == 1)
+            {
+                result(0) = lhs(0) * rhs(0);
+            }
+            else if constexpr (R1 == 2 && C1_R2 == 2 && C2 == 2)
+            {
+                result(0) = lhs(0) * rhs(0) + lhs(2) * rhs(1);
+                result(1) = lhs(1) * rhs(0) + lhs(3) * rhs(1);
+                result(2) = lhs(0) * rhs(2) + lhs(2) * rhs(3);
+                result(3) = lhs(1) * rhs(2) + lhs(3) * rhs(3);
+            }
+            else if constexpr (R1 == 3 && C1_R2 == 3 && C2 == 3 && Dense)
+            {
+                matmul3x3(lhs.data(), rhs.data(), result.data());
+            }
+            else if constexpr (R1 == 3 && C1_R2 == 3 && C2 == 1 && Dense)
+            {
+                matvec3(lhs.data(), rhs.data(), result.data());
+            }
+            else if constexpr (R1 == 4 && C1_R2 == 4 && C2 == 4 && Dense)
+            {
+                matmul4x4(lhs.data(), rhs.data(), result.data());
+            }
+            else if constexpr (R1 == 4 && C1_R2 == 4 && C2 == 1 && Dense)
+            {
+                matvec4(lhs.data(), rhs.data(), result.data());
+            }
+            else if constexpr (RowVectorKernel)
+            {
+                matmul_dot<T, 1, C1_R2, C2>(lhs.data(), 0, rhs.data(), RhsStride, result);
+            }
+            else if constexpr (PaddedKernel && Unrolled)
+            {
+                constexpr bool Aligned = aligned_packet_access<LhsType>::value && aligned_packet_access<ResultType>::value;
+                matmul_padded<T, R1, C1_R2, C2, LhsStride, ResStride, Aligned>(lhs.data(), rhs, result.data());
+            }
+            else if constexpr (ColumnKernel)
+            {
+                // a row vector result is stored like a column-major matrix with a leading dimension of 1
+                constexpr int ColumnStride = ResRowMajor ? 1 : ResStride;
+                if constexpr (Unrolled)
+                    matmul_unrolled<T, R1, C1_R2, C2>(lhs.data(), LhsStride, rhs, result.data(), ColumnStride);
+                else
+                    matmul_blocked<T, R1, C1_R2, C2>(lhs.data(), LhsStride, rhs, result.data(), ColumnStride);
+            }
+            else if constexpr (LhsRowMajor && !RhsRowMajor)
+            {
+                matmul_dot<T, R1, C1_R2, C2>(lhs.data(), LhsStride, rhs.data(), RhsStride, result);
+            }
+            else if constexpr (TransposedKernel)
+            {
+                // the column kernels on the transposed product, res^T = rhs^T * lhs^T, rows of rhs being columns of rhs^T
+                const auto lhsTransposed = [&lhs](int k, int i)
+                { return lhs(i, k); };
+                if constexpr (Unrolled)
+                    matmul_unrolled<T, C2, C1_R2, R1>(rhs.data(), RhsStride, lhsTransposed, result.data(), ResStride);
+                else
+                    matmul_blocked<T, C2, C1_R2, R1>(rhs.data(), RhsStride, lhsTransposed, result.data(), ResStride);
+            }
+            else
+            {
+                for (int j = 0; j < C2; ++j)
+                {
+                    for (int i = 0; i < R1; ++i)
+                    {
+                        T sum = 0;
+                        for (int k = 0; k < C1_R2; ++k)
+                        {
+                            sum += lhs(i, k) * rhs(k, j);
+                        }
+                        result(i, j) = sum;
+                    }
+                }
+            }
+        }
+
+        // Product with a Dynamic dimension into a result already of the right size, with loop bounds from the
+        // operands at runtime. The inner sizes are expected to match.
+        template <typename LhsType, typename RhsType, typename ResultType>
+        inline void bounded_product(const LhsType &lhs, const RhsType &rhs, ResultType &result)
+        {
+            using LhsPlain = typename traits<LhsType>::PlainObject;
+            typename eval_selector<LhsType>::type lhsEval(lhs);
+            typename eval_selector<RhsType>::type rhsEval(rhs);
+            const int rows = lhsEval.rows(), depth = lhsEval.cols(), cols = rhsEval.cols();
+
+            // a row vector is stored like a column-major matrix with a leading dimension of 1
+            const int resStride = ResultType::IsRowMajor ? 1 : result.outerStride();
+            if constexpr (!LhsPlain::IsRowMajor || LhsPlain::RowsAtCompileTime == 1)
+            {
+                const int lhsStride = LhsPlain::IsRowMajor ? 1 : lhsEval.outerStride();
+                matmul_runtime(lhsEval.data(), lhsStride, rhsEval, result.data(), resStride, rows, depth, cols);
+            }
+            else
+            {
+                for (int j = 0; j < cols; ++j)
+                {
+                    for (int i = 0; i < rows; ++i)
+                    {
+                        typename ResultType::Scalar sum = 0;
+                        for (int k = 0; k < depth; ++k)
+                        {
+                            sum += lhsEval(i, k) * rhsEval(k, j);
+                        }
+                        result(i, j) = sum;
+                    }
+                }
+            }
+        }
+
+        // Evaluates lhs * rhs into result, a matrix of the plain type of the product that neither operand reads.
+        // Views and transposes of matrices or views are read in place, other expressions are evaluated once.
+        template <typename LhsType, typename RhsType, typename ResultType>
+        constexpr void evaluate_product(const LhsType &lhs, const RhsType &rhs, ResultType &result)
+        {
+            if constexpr (is_bounded_product<LhsType, RhsType>::value)
+            {
+                bounded_product(lhs, rhs, result);
+            }
+            else if constexpr (product_operand<LhsType>::InPlace || product_operand<RhsType>::InPlace)
+            {
+                view_product(lhs, rhs, result);
+            }
+            else
+            {
+                typename eval_selector<LhsType>::type lhsEval(lhs);
+                typename eval_selector<RhsType>::type rhsEval(rhs);
+                fixed_product(lhsEval, rhsEval, result);
+            }
+        }
+
+        // an operand of a product with its scalar factor split off, so that alpha * A * B, which parses as
+        // (alpha * A) * B, reads A in place and scales the sums instead
+        template <typename T>
+        struct scaled_operand
+        {
+            using Scalar = typename traits<T>::Scalar;
+            static constexpr const T &nested(const T &xpr) { return xpr; }
+            static constexpr Scalar factor(const T &) { return Scalar(1); }
+        };
+
+        template <typename Scalar, typename XprType>
+        struct scaled_operand<EmbeddedCwiseUnaryOp<scalar_multiple_op<Scalar>, XprType>>
+        {
+            using ScaledType = EmbeddedCwiseUnaryOp<scalar_multiple_op<Scalar>, XprType>;
+            static constexpr const nested_t<XprType> &nested(const ScaledType &xpr) { return xpr.nestedExpression(); }
+            static constexpr Scalar factor(const ScaledType &xpr) { return xpr.functor().factor; }
+        };
+
+        template <typename Scalar, typename XprType>
+        struct scaled_operand<EmbeddedCwiseUnaryOp<scalar_opposite_op<Scalar>, XprType>>
+        {
+            using ScaledType = EmbeddedCwiseUnaryOp<scalar_opposite_op<Scalar>, XprType>;
+            static constexpr const nested_t<XprType> &nested(const ScaledType &xpr) { return xpr.nestedExpression(); }
+            static constexpr Scalar factor(const ScaledType &) { return Scalar(-1); }
+        };
+
+        // dst = alpha * lhs * rhs, or += / -= as chosen by func, neither operand reading dst. Fixed-size operands
+        // that fit matmul_dot go there like in view_product. Otherwise a dst with consecutive coefficients in its
+        // columns, or a row vector, goes to the column kernels when lhs can be read by columns, anything else is
+        // computed coefficient by coefficient.
+        template <typename DstType, typename LhsType, typename RhsType, typename Functor>
+        constexpr void product_accumulate(DstType &dst, const LhsType &lhs, const RhsType &rhs, typename traits<DstType>::Scalar alpha,
+                                          const Functor &func)
+        {
+            using T = typename traits<DstType>::Scalar;
+            using LhsPlain = typename product_operand<LhsType>::plain;
+            using RhsPlain = typename product_operand<RhsType>::plain;
+            constexpr bool LhsColumns = (!traits<LhsPlain>::IsRowMajor && traits<LhsPlain>::MapInnerStride == 1) ||
+                                        traits<LhsType>::RowsAtCompileTime == 1;
+            constexpr bool DstColumns = traits<DstType>::HasDirectAccess &&
+                                        ((!traits<DstType>::IsRowMajor && traits<DstType>::MapInnerStride == 1) || traits<DstType>::RowsAtCompileTime == 1);
+            constexpr int Rows = traits<LhsType>::RowsAtCompileTime;
+            constexpr int Depth = traits<LhsType>::ColsAtCompileTime;
+            constexpr int Cols = traits<RhsType>::ColsAtCompileTime;
+            constexpr bool Fixed = Rows != Dynamic && Depth != Dynamic && Cols != Dynamic;
+            constexpr bool Unrolled = Fixed && Rows <= 8 && Depth <= 8 && Cols <= 8;
+            constexpr bool LhsRows = traits<LhsPlain>::IsRowMajor ? traits<LhsPlain>::MapInnerStride == 1
+                                                                  : Rows == 1 && traits<LhsPlain>::MapOuterStride == 1;
+            constexpr bool DotKernel = Fixed && LhsRows && traits<RhsPlain>::HasDirectAccess && !traits<RhsPlain>::IsRowMajor &&
+                                       traits<RhsPlain>::MapInnerStride == 1 && (!Unrolled || !(LhsColumns && DstColumns));
+            typename product_operand<LhsType>::type lhsEval(lhs);
+            typename product_operand<RhsType>::type rhsEval(rhs);
+            const int rows = lhsEval.rows(), depth = lhsEval.cols(), cols = rhsEval.cols();
+
+            if (is_constant_evaluated() || !((LhsColumns && DstColumns) || DotKernel))
+            {
+                for (int j = 0; j < cols; ++j)
+                {
+                    for (int i = 0; i < rows; ++i)
+                    {
+                        T sum = 0;
+                        for (int k = 0; k < depth; ++k)
+                        {
+                            sum += lhsEval(i, k) * rhsEval(k, j);
+                        }
+                        func.assignCoeff(dst.coeffRef(i, j), alpha * sum);
+                    }
+                }
+            }
+            else if constexpr (DotKernel)
+            {
+                const int lhsStride = Rows == 1 ? 0 : lhsEval.outerStride();
+                matmul_dot<T, Rows, Depth, Cols>(lhsEval.data(), lhsStride, rhsEval.data(), rhsEval.outerStride(), dst, alpha, func);
+            }
+            else if constexpr (LhsColumns && DstColumns)
+            {
+                const int lhsStride = traits<LhsPlain>::IsRowMajor ? lhsEval.innerStride() : lhsEval.outerStride();
+                const int resStride = traits<DstType>::IsRowMajor ? dst.innerStride() : dst.outerStride();
+                if constexpr (Unrolled)
+                    matmul_unrolled<T, Rows, Depth, Cols>(lhsEval.data(), lhsStride, rhsEval, dst.data(), resStride, alpha, func);
+                else if constexpr (Fixed)
+                    matmul_blocked<T, Rows, Depth, Cols>(lhsEval.data(), lhsStride, rhsEval, dst.data(), resStride, alpha, func);
+                else
+                    matmul_runtime(lhsEval.data(), lhsStride, rhsEval, dst.data(), resStride, rows, depth, cols, alpha, func);
+            }
+        }
+
+        // the operands of a product chain from left to right, as a tuple of references, e.g. (A, B, C) for
+        // A * B * C whichever way it was parenthesized
+        template <typename T>
+        struct product_chain
+        {
+            static constexpr std::tuple<const T &> operands(const T &xpr) { return std::tuple<const T &>(xpr); }
+        };
+
+        template <typename LhsType, typename RhsType>
+        struct product_chain<EmbeddedProductType<LhsType, RhsType>>
+        {
+            static constexpr auto operands(const EmbeddedProductType<LhsType, RhsType> &xpr)
+            {
+                return std::tuple_cat(product_chain<product_nested_t<LhsType>>::operands(xpr.lhs()),
+                                      product_chain<product_nested_t<RhsType>>::operands(xpr.rhs()));
+            }
+        };
+
+        template <int N>
+        struct chain_table
+        {
+            int split[N][N];
+        };
+
+        // The matrix-chain dynamic program over the compile-time sizes of the operands: operand i is dims[i] x
+        // dims[i + 1], cost(i, j) = min over s of cost(i, s) + cost(s + 1, j) + dims[i] * dims[s + 1] * dims[j + 1]
+        // multiply-adds and split(i, j) is the best s, the last one on a tie so that equal costs keep the left to
+        // right order. A chain with a Dynamic size is evaluated from left to right.
+        template <typename Operands, std::size_t... Is>
+        constexpr chain_table<sizeof...(Is)> chain_split_table(std::index_sequence<Is...>)
+        {
+            constexpr int N = static_cast<int>(sizeof...(Is));
+            const int dims[N + 1] = {traits<std::decay_t<std::tuple_element_t<Is, Operands>>>::RowsAtCompileTime...,
+                                     traits<std::decay_t<std::tuple_element_t<N - 1, Operands>>>::ColsAtCompileTime};
+            bool known = true;
+            for (int i = 0; i <= N; ++i)
+            {
+                known = known && dims[i] != Dynamic;
+            }
+            long long cost[N][N] = {};
+            chain_table<N> table = {};
+            for (int length = 1; length < N; ++length)
+            {
+                for (int i = 0; i + length < N; ++i)
+                {
+                    const int j = i + length;
+                    table.split[i][j] = j - 1;
+                    cost[i][j] = -1;
+                    for (int split = j - 1; known && split >= i; --split)
+                    {
+                        const long long c = cost[i][split] + cost[split + 1][j] + static_cast<long long>(dims[i]) * dims[split + 1] * dims[j + 1];
+                        if (cost[i][j] < 0 || c < cost[i][j])
+                        {
+                            cost[i][j] = c;
+                            table.split[i][j] = split;
+                        }
+                    }
+                }
+            }
+            return table;
+        }
+
+        template <typename Operands>
+        struct chain_order
+        {
+            static constexpr int N = static_cast<int>(std::tuple_size<Operands>::value);
+            static constexpr chain_table<N> table = chain_split_table<Operands>(std::make_index_sequence<N>());
+        };
+
+        // operands [I, J] of a chain: the operand itself when I == J, otherwise their product in the order of the
+        // table, evaluated into a plain matrix
+        template <int I, int J, typename Order, typename Operands>
+        constexpr decltype(auto) chain_operand(const Operands &operands)
+        {
+            if constexpr (I == J)
+            {
+                return std::get<I>(operands);
+            }
+            else
+            {
+                constexpr int Split = Order::table.split[I][J];
+                decltype(auto) lhs = chain_operand<I, Split, Order>(operands);
+                decltype(auto) rhs = chain_operand<Split + 1, J, Order>(operands);
+                using ProductType = EmbeddedProductType<std::decay_t<decltype(lhs)>, std::decay_t<decltype(rhs)>>;
+                auto result = plain_uninitialized<typename traits<ProductType>::PlainObject>(lhs.rows(), rhs.cols());
+                evaluate_product(lhs, rhs, result);
+                return result;
+            }
+        }
+
+        // A chain is split where chain_order says, both sides evaluated, and their product assigned. Otherwise a
+        // plain dst of the result type being assigned goes through the product kernels, anything else through
+        // product_accumulate. dst is already sized.
+        template <typename DstType, typename LhsType, typename RhsType, typename Functor>
+        constexpr void product_assignment(DstType &dst, const EmbeddedProductType<LhsType, RhsType> &src, const Functor &func)
+        {
+            using ProductType = EmbeddedProductType<LhsType, RhsType>;
+            using LhsScaled = scaled_operand<product_nested_t<LhsType>>;
+            using RhsScaled = scaled_operand<product_nested_t<RhsType>>;
+            static_assert(compatible_size<traits<DstType>::RowsAtCompileTime, traits<ProductType>::RowsAtCompileTime>::value &&
+                              compatible_size<traits<DstType>::ColsAtCompileTime, traits<ProductType>::ColsAtCompileTime>::value,
+                          "assignment between matrices of different sizes");
+            if constexpr (is_product<product_nested_t<LhsType>>::value || is_product<product_nested_t<RhsType>>::value)
+            {
+                const auto operands = product_chain<ProductType>::operands(src);
+                using Order = chain_order<std::remove_const_t<decltype(operands)>>;
+                constexpr int Last = Order::N - 1;
+                constexpr int Split = Order::table.split[0][Last];
+                decltype(auto) lhs = chain_operand<0, Split, Order>(operands);
+                decltype(auto) rhs = chain_operand<Split + 1, Last, Order>(operands);
+                product_assignment(dst, EmbeddedProductType<std::decay_t<decltype(lhs)>, std::decay_t<decltype(rhs)>>(lhs, rhs), func);
+            }
+            else if constexpr (std::is_same<Functor, assign_op>::value && std::is_same<DstType, typename traits<ProductType>::PlainObject>::value)
+                evaluate_product(src.lhs(), src.rhs(), dst);
+            else
+                product_accumulate(dst, LhsScaled::nested(src.lhs()), RhsScaled::nested(src.rhs()),
+                                   LhsScaled::factor(src.lhs()) * RhsScaled::factor(src.rhs()), func);
+        }
+
+        // Lower triangle of a blocked product whose result is symmetric, e.g. F * P * F^T or K * S * K^T: the
+        // panel of 4 columns from Col on only computes rows [Col, Rows), so the tiles above the diagonal are
+        // skipped and about half of the product is left. The upper part of the 4x4 diagonal blocks is written
+        // as well. Like in matmul_blocked rhs is read by coefficient and the sums times alpha are assigned,
+        // added or subtracted by func.
+        template <typename T, int Rows, int Depth, int Col, typename RhsType, typename Functor>
+        inline void matmul_lower(const T *lhs, int lhsStride, const RhsType &rhs, T *res, int resStride, T alpha, const Functor &func)
+        {
+            constexpr int PanelCols = (Rows - Col < 4) ? Rows - Col : 4;
+            matmul_panel<T, EMBEDDEDMATH_PACKET_BYTES, 2, Col, Rows, PanelCols, Depth>(lhs, lhsStride, rhs, Col, res + Col * resStride,
+                                                                                       resStride, alpha, func);
+            if constexpr (Col + PanelCols < Rows)
+                matmul_lower<T, Rows, Depth, Col + PanelCols>(lhs, lhsStride, rhs, res, resStride, alpha, func);
+        }
+
+        // a column-major plain matrix of the type and bounds of T, which the kernels read through data()
+        template <typename T>
+        struct column_major_plain
+        {
+            using Plain = typename traits<T>::PlainObject;
+            using type = EmbeddedCoreType<typename traits<T>::Scalar, traits<T>::RowsAtCompileTime, traits<T>::ColsAtCompileTime, DefaultStorage,
+                                          Plain::MaxRowsAtCompileTime, Plain::MaxColsAtCompileTime>;
+        };
+
+        // T itself when it already is that matrix, a copy otherwise
+        template <typename T>
+        using column_major_operand_t = std::conditional_t<std::is_same<T, typename column_major_plain<T>::type>::value, const T &,
+                                                          const typename column_major_plain<T>::type>;
+
+        // dst = alpha * lhs * rhs, or += / -= as chosen by func, for a product known to be symmetric: only the
+        // lower triangle is computed, then copied to the upper one so that dst is exactly symmetric. lhs is a
+        // column-major plain matrix and rhs is read by coefficient. A fixed-size dst with consecutive
+        // coefficients in its columns goes to matmul_lower, or as a whole to matmul_unrolled up to 8 where
+        // skipping tiles gains nothing, a bounded one to matmul_runtime column by column, anything else is
+        // computed coefficient by coefficient.
+        template <typename DstType, typename LhsType, typename RhsType, typename Functor>
+        constexpr void symmetric_product(DstType &dst, const LhsType &lhs, const RhsType &rhs, typename traits<DstType>::Scalar alpha,
+                                         const Functor &func)
+        {
+            using T = typename traits<DstType>::Scalar;
+            constexpr int Rows = traits<LhsType>::RowsAtCompileTime;
+            constexpr int Depth = traits<LhsType>::ColsAtCompileTime;
+            constexpr bool Fixed = Rows != Dynamic && Depth != Dynamic;
+            constexpr bool DstColumns = traits<DstType>::HasDirectAccess && !traits<DstType>::IsRowMajor && traits<DstType>::MapInnerStride == 1;
+            constexpr bool LhsColumns = !traits<LhsType>::IsRowMajor;
+            const int size = lhs.rows(), depth = lhs.cols();
+            if (is_constant_evaluated() || !(DstColumns && LhsColumns))
+            {
+                for (int j = 0; j < size; ++j)
+                {
+                    for (int i = j; i < size; ++i)
+                    {
+                        T sum = 0;
+                        for (int k = 0; k < depth; ++k)
+                        {
+                            sum += lhs(i, k) * rhs(k, j);
+                        }
+                        func.assignCoeff(dst.coeffRef(i, j), alpha * sum);
+                    }
+                }
+            }
+            else if constexpr (Fixed && DstColumns && LhsColumns && Rows <= 8 && Depth <= 8)
+            {
+                matmul_unrolled<T, Rows, Depth, Rows>(lhs.data(), lhs.outerStride(), rhs, dst.data(), dst.outerStride(), alpha, func);
+            }
+            else if constexpr (Fixed && DstColumns && LhsColumns)
+            {
+                matmul_lower<T, Rows, Depth, 0>(lhs.data(), lhs.outerStride(), rhs, dst.data(), dst.outerStride(), alpha, func);
+            }
+            else if constexpr (DstColumns && LhsColumns)
+            {
+                for (int j = 0; j < size; ++j)
+                {
+                    const auto column = [&](int k, int)
+                    { return rhs(k, j); };
+                    matmul_runtime(lhs.data() + j, lhs.outerStride(), column, dst.data() + j * dst.outerStride() + j, dst.outerStride(),
+                                   size - j, depth, 1, alpha, func);
+                }
+            }
+            mirror_triangle<Lower>(dst);
+        }
+
+        // y += a * x over n consecutive coefficients, in packets with a scalar tail
+        template <typename T>
+        inline void axpy_contiguous(T *y, const T *x, T a, int n)
+        {
+            using Packet = typename packet_traits<T>::type;
+            constexpr int PacketSize = packet_traits<T>::size;
+            int i = 0;
+            if constexpr (PacketSize > 1)
+            {
+                const Packet factor = pset1<Packet>(a);
+                for (; i + PacketSize <= n; i += PacketSize)
+                {
+                    pstoreu(y + i, ploadu<Packet>(y + i) + factor * ploadu<Packet>(x + i));
+                }
+            }
+            for (; i < n; ++i)
+            {
+                y[i] += a * x[i];
+            }
+        }
+
+        // dot product of n consecutive coefficients of x and y, in packets with a scalar tail
+        template <typename T>
+        inline T dot_contiguous(const T *x, const T *y, int n)
+        {
+            using Packet = typename packet_traits<T>::type;
+            constexpr int PacketSize = packet_traits<T>::size;
+            T sum = 0;
+            int i = 0;
+            if constexpr (PacketSize > 1)
+            {
+                if (n >= PacketSize)
+                {
+                    Packet acc = ploadu<Packet>(x) * ploadu<Packet>(y);
+                    for (i = PacketSize; i + PacketSize <= n; i += PacketSize)
+                    {
+                        acc = acc + ploadu<Packet>(x + i) * ploadu<Packet>(y + i);
+                    }
+                    sum = predux<T>(acc, scalar_sum_op<T>());
+                }
+            }
+            for (; i < n; ++i)
+            {
+                sum += x[i] * y[i];
+            }
+            return sum;
+        }
+
+        // res = S * x for a size x size symmetric S packed as its lower columns, x and res consecutive. Column j
+        // of the lower triangle is added to res times x(j), and its dot product with x, which is row j of the
+        // upper triangle, to res(j): the packed storage is read once.
+        template <typename T>
+        inline void packed_symv(const T *packed, int size, const T *x, T *res)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                res[i] = 0;
+            }
+            for (int j = 0; j < size; ++j)
+            {
+                const int below = size - j - 1;
+                axpy_contiguous(res + j + 1, packed + 1, x[j], below);
+                res[j] += packed[0] * x[j] + dot_contiguous(packed + 1, x + j + 1, below);
+                packed += size - j;
+            }
+        }
+
+        // column j of a size x size symmetric matrix packed as its lower columns, into size consecutive
+        // coefficients: the rows above the diagonal are gathered from row j of the packed columns before it
+        template <typename T>
+        inline void unpack_symmetric_column(const T *packed, int size, int j, T *column)
+        {
+            const T *source = packed + j;
+            for (int k = 0; k < j; ++k)
+            {
+                column[k] = *source;
+                source += size - k - 1;
+            }
+            for (int k = j; k < size; ++k)
+            {
+                column[k] = source[k - j];
+            }
+        }
+
+        // res = lhs * S for a column-major lhs and a Size x Size symmetric S packed as its lower columns. Panels
+        // of 4 columns of S are unpacked in turn and multiplied by the kernel of a plain product of these sizes,
+        // matmul_runtime when the rows of lhs are only known at runtime.
+        template <typename T, int Rows, int Size, int Col = 0>
+        inline void packed_rhs_product(const T *lhs, int lhsStride, const T *packed, T *res, int resStride, int rows)
+        {
+            constexpr int PanelCols = (Size - Col < 4) ? Size - Col : 4;
+            T panel[PanelCols * Size];
+            for (int c = 0; c < PanelCols; ++c)
+            {
+                unpack_symmetric_column(packed, Size, Col + c, panel + c * Size);
+            }
+            const auto rhs = [&](int k, int c)
+            { return panel[c * Size + k]; };
+            if constexpr (Rows == Dynamic)
+                matmul_runtime(lhs, lhsStride, rhs, res + Col * resStride, resStride, rows, Size, PanelCols);
+            else if constexpr (Rows <= 8 && Size <= 8)
+                matmul_unrolled<T, Rows, Size, PanelCols>(lhs, lhsStride, rhs, res + Col * resStride, resStride);
+            else
+                matmul_blocked<T, Rows, Size, PanelCols>(lhs, lhsStride, rhs, res + Col * resStride, resStride);
+            if constexpr (Col + PanelCols < Size)
+                packed_rhs_product<T, Rows, Size, Col + PanelCols>(lhs, lhsStride, packed, res, resStride, rows);
+        }
+
+        // packed_product for fixed sizes: panels of 4 columns, rows [Col, Rows), are computed by matmul_panel
+        // into a buffer like in matmul_lower, then assigned, added or subtracted by func to the packed columns
+        template <typename T, int Rows, int Depth, int Col, typename RhsType, typename Functor>
+        inline void packed_product_panels(const T *lhs, int lhsStride, const RhsType &rhs, T *packed, T alpha, const Functor &func)
+        {
+            constexpr int PanelCols = (Rows - Col < 4) ? Rows - Col : 4;
+            T panel[PanelCols * Rows];
+            matmul_panel<T, EMBEDDEDMATH_PACKET_BYTES, 2, Col, Rows, PanelCols, Depth>(lhs, lhsStride, rhs, Col, panel, Rows, alpha, assign_op());
+            for (int c = 0; c < PanelCols; ++c)
+            {
+                const int j = Col + c;
+                for (int i = j; i < Rows; ++i)
+                {
+                    func.assignCoeff(packed[i - j], panel[c * Rows + i]);
+                }
+                packed += Rows - j;
+            }
+            if constexpr (Col + PanelCols < Rows)
+                packed_product_panels<T, Rows, Depth, Col + PanelCols>(lhs, lhsStride, rhs, packed, alpha, func);
+        }
+
+        // packed = alpha * lhs * rhs, or += / -= as chosen by func, for a product known to be symmetric and
+        // stored packed as its lower columns: rows [j, n) of column j come from rows [j, n) of lhs, a
+        // column-major plain matrix, and column j of rhs, read by coefficient. This is half of the multiply-adds
+        // of the full product. Fixed sizes go to packed_product_panels, others to matmul_runtime column by column.
+        template <typename T, typename LhsType, typename RhsType, typename Functor>
+        constexpr void packed_product(T *packed, const LhsType &lhs, const RhsType &rhs, T alpha, const Functor &func)
+        {
+            constexpr int Rows = traits<LhsType>::RowsAtCompileTime;
+            constexpr int Depth = traits<LhsType>::ColsAtCompileTime;
+            constexpr bool Fixed = Rows != Dynamic && Depth != Dynamic;
+            const int size = lhs.rows(), depth = lhs.cols();
+            // a row vector is stored like a column-major matrix with a leading dimension of 1
+            const int lhsStride = traits<LhsType>::IsRowMajor ? 1 : lhs.outerStride();
+            if (is_constant_evaluated())
+            {
+                for (int j = 0; j < size; ++j)
+                {
+                    for (int i = j; i < size; ++i)
+                    {
+                        T sum = 0;
+                        for (int k = 0; k < depth; ++k)
+                        {
+                            sum += lhs(i, k) * rhs(k, j);
+                        }
+                        func.assignCoeff(packed[i - j], alpha * sum);
+                    }
+                    packed += size - j;
+                }
+            }
+            else if constexpr (Fixed)
+            {
+                packed_product_panels<T, Rows, Depth, 0>(lhs.data(), lhsStride, rhs, packed, alpha, func);
+            }
+            else
+            {
+                for (int j = 0; j < size; ++j)
+                {
+                    const auto column = [&](int k, int)
+                    { return rhs(k, j); };
+                    matmul_runtime(lhs.data() + j, lhsStride, column, packed, size - j, size - j, depth, 1, alpha, func);
+                    packed += size - j;
+                }
+            }
+        }
+
+        // the operator choosing whether a term of a block sum is its first one, assigned, or a following one, added
+        template <bool First>
+        using first_term_op = std::conditional_t<First, assign_op, add_assign_op>;
+
+        // dst = S * rhs for a structured S and a plain rhs: block row bi of dst sums, over the blocks of block row
+        // bi of S, the rows of rhs for an identity block and the dense block times them, zero blocks being
+        // skipped. A block row of zero blocks clears its rows of dst.
+        template <typename DstType, typename StructuredType, typename RhsType>
+        inline void structured_lhs_product(DstType &dst, const StructuredType &lhs, const RhsType &rhs)
+        {
+            using Structure = typename StructuredType::Structure;
+            using T = typename traits<DstType>::Scalar;
+            constexpr int Cols = traits<RhsType>::ColsAtCompileTime;
+            for_each_block<Structure>([&](auto bi, auto bj)
+                                      {
+                constexpr int BI = decltype(bi)::value, BJ = decltype(bj)::value;
+                constexpr int Kind = Structure::kindOf(BI, BJ);
+                constexpr int First = Structure::firstInRow(BI);
+                constexpr int Rows = Structure::rowSize[BI], Depth = Structure::colSize[BJ];
+                auto dstBlock = dst.template block<Rows, Cols>(Structure::rowOffset(BI), 0);
+                const auto rhsBlock = rhs.template block<Depth, Cols>(Structure::colOffset(BJ), 0);
+                if constexpr (First < 0 && BJ == 0)
+                    dstBlock.setZero();
+                else if constexpr (Kind == IdentityBlock)
+                    call_assignment(dstBlock, rhsBlock, first_term_op<First == BJ>());
+                else if constexpr (Kind == DenseBlock)
+                    product_accumulate(dstBlock, lhs.template denseBlock<BI, BJ>(), rhsBlock, T(1), first_term_op<First == BJ>()); });
+        }
+
+        // dst = lhs * S for a plain lhs and a structured S, block column by block column of S
+        template <typename DstType, typename LhsType, typename StructuredType>
+        inline void structured_rhs_product(DstType &dst, const LhsType &lhs, const StructuredType &rhs)
+        {
+            using Structure = typename StructuredType::Structure;
+            using T = typename traits<DstType>::Scalar;
+            constexpr int Rows = traits<LhsType>::RowsAtCompileTime;
+            for_each_block<Structure>([&](auto bi, auto bj)
+                                      {
+                constexpr int BI = decltype(bi)::value, BJ = decltype(bj)::value;
+                constexpr int Kind = Structure::kindOf(BI, BJ);
+                constexpr int First = Structure::firstInColumn(BJ);
+                constexpr int Depth = Structure::rowSize[BI], Cols = Structure::colSize[BJ];
+                auto dstBlock = dst.template block<Rows, Cols>(0, Structure::colOffset(BJ));
+                const auto lhsBlock = lhs.template block<Rows, Depth>(0, Structure::rowOffset(BI));
+                if constexpr (First < 0 && BI == 0)
+                    dstBlock.setZero();
+                else if constexpr (Kind == IdentityBlock)
+                    call_assignment(dstBlock, lhsBlock, first_term_op<First == BI>());
+                else if constexpr (Kind == DenseBlock)
+                    product_accumulate(dstBlock, lhsBlock, rhs.template denseBlock<BI, BJ>(), T(1), first_term_op<First == BI>()); });
+        }
+
+        // dst = lhs * S^T for a plain lhs and a structured S, e.g. (F * P) * F^T: block column bi of dst sums
+        // the products of the blocks of block row bi of S, transposed, with the matching columns of lhs
+        template <typename DstType, typename LhsType, typename StructuredType>
+        inline void structured_transpose_product(DstType &dst, const LhsType &lhs, const StructuredType &rhs)
+        {
+            using Structure = typename StructuredType::Structure;
+            using T = typename traits<DstType>::Scalar;
+            constexpr int Rows = traits<LhsType>::RowsAtCompileTime;
+            for_each_block<Structure>([&](auto bi, auto bj)
+                                      {
+                constexpr int BI = decltype(bi)::value, BJ = decltype(bj)::value;
+                constexpr int Kind = Structure::kindOf(BI, BJ);
+                constexpr int First = Structure::firstInRow(BI);
+                constexpr int Cols = Structure::rowSize[BI], Depth = Structure::colSize[BJ];
+                auto dstBlock = dst.template block<Rows, Cols>(0, Structure::rowOffset(BI));
+                const auto lhsBlock = lhs.template block<Rows, Depth>(0, Structure::colOffset(BJ));
+                if constexpr (First < 0 && BJ == 0)
+                    dstBlock.setZero();
+                else if constexpr (Kind == IdentityBlock)
+                    call_assignment(dstBlock, lhsBlock, first_term_op<First == BJ>());
+                else if constexpr (Kind == DenseBlock)
+                    product_accumulate(dstBlock, lhsBlock, rhs.template denseBlock<BI, BJ>().transpose(), T(1), first_term_op<First == BJ>()); });
+        }
+    }
+
+    // Matrix product, evaluated when assigned or nested in another expression. A matrix constructed from it, or
+    // assigned through noalias(), receives the product directly. Plain assignment goes through a temporary,
+    // since the destination may also be an operand. Operands are held like in any other expression, so a
+    // product must not outlive the temporaries it was built from. A product of products is a chain, which is
+    // evaluated in the order with the fewest multiplications when its sizes are known at compile time.
+    template <typename LhsType, typename RhsType>
+    class EmbeddedProductType : public EmbeddedExprBase<EmbeddedProductType<LhsType, RhsType>>
+    {
+    protected:
+        typename internal::product_ref_selector<LhsType>::type m_lhs;
+        typename internal::product_ref_selector<RhsType>::type m_rhs;
+
+    public:
+        using Scalar = typename internal::traits<EmbeddedProductType>::Scalar;
+
+        constexpr EmbeddedProductType(const LhsType &lhs, const RhsType &rhs)
+            : m_lhs(lhs), m_rhs(rhs)
+        {
+            static_assert(std::is_same<Scalar, typename internal::traits<RhsType>::Scalar>::value, "mixing different scalar types");
+        }
+
+        constexpr int rows() const { return m_lhs.rows(); }
+        constexpr int cols() const { return m_rhs.cols(); }
+
+        //! a single coefficient, the dot product of a row of lhs and a column of rhs
+        constexpr Scalar coeff(int row, int col) const
+        {
+            Scalar sum = 0;
+            for (int k = 0; k < m_lhs.cols(); ++k)
+            {
+                sum += m_lhs.coeff(row, k) * m_rhs.coeff(k, col);
+            }
+            return sum;
+        }
+
+        constexpr Scalar coeff(int index) const
+        {
+            return coeff(index % rows(), index / rows());
+        }
+
+        constexpr Scalar operator()(int row, int col) const
+        {
+            return coeff(row, col);
+        }
+
+        constexpr Scalar operator()(int index) const
+        {
+            return coeff(index);
+        }
+
+        constexpr const internal::product_nested_t<LhsType> &lhs() const { return m_lhs; }
+        constexpr const internal::product_nested_t<RhsType> &rhs() const { return m_rhs; }
+    };
+
+    // Destination of an assignment that does not alias its source, returned by noalias(): products are
+    // written into it directly, without the temporary of plain assignment
+    template <typename ExpressionType>
+    class EmbeddedNoAlias
+    {
+    protected:
+        ExpressionType &m_expression;
+
+    public:
+        constexpr explicit EmbeddedNoAlias(ExpressionType &expression) : m_expression(expression) {}
+
+        template <typename OtherDerived>
+        constexpr ExpressionType &operator=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            if constexpr (internal::traits<ExpressionType>::SizeAtCompileTime == Dynamic && !internal::is_view<ExpressionType>::value)
+                m_expression.resize(other.rows(), other.cols());
+            internal::call_assignment_no_alias(m_expression, other.derived(), internal::assign_op());
+            return m_expression;
+        }
+
+        template <typename OtherDerived>
+        constexpr ExpressionType &operator+=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::call_assignment_no_alias(m_expression, other.derived(), internal::add_assign_op());
+            return m_expression;
+        }
+
+        template <typename OtherDerived>
+        constexpr ExpressionType &operator-=(const EmbeddedExprBase<OtherDerived> &other)
+        {
+            internal::call_assignment_no_alias(m_expression, other.derived(), internal::sub_assign_op());
+            return m_expression;
+        }
+    };
+
+    // inner sizes are checked at compile time unless one of them is Dynamic
+    template <typename LhsType, typename RhsType,
+              std::enable_if_t<internal::compatible_size<internal::traits<LhsType>::ColsAtCompileTime, internal::traits<RhsType>::RowsAtCompileTime>::value,
+                               int> = 0>
+    constexpr const EmbeddedProductType<LhsType, RhsType> operator*(const EmbeddedExprBase<LhsType> &lhs, const EmbeddedExprBase<RhsType> &rhs)
+    {
+        return EmbeddedProductType<LhsType, RhsType>(lhs.derived(), rhs.derived());
+    }
+
+    namespace internal
+    {
+        // Loops of the small decompositions and solves. With integral constants as bounds the loop is unrolled
+        // at compile time and function receives each index as an integral constant, so inner loops bounded by
+        // it unroll too; with ints it is a plain loop.
+        template <int Begin, int End, typename Function>
+        inline void for_indices(std::integral_constant<int, Begin>, std::integral_constant<int, End>, const Function &function)
+        {
+            if constexpr (Begin < End)
+            {
+                function(std::integral_constant<int, Begin>());
+                for_indices(std::integral_constant<int, Begin + 1>(), std::integral_constant<int, End>(), function);
+            }
+        }
+
+        template <typename Function>
+        inline void for_indices(int begin, int end, const Function &function)
+        {
+            for (int i = begin; i < end; ++i)
+                function(i);
+        }
+
+        // the same indices from end - 1 down to begin
+        template <int Begin, int End, typename Function>
+        inline void for_indices_reversed(std::integral_constant<int, Begin>, std::integral_constant<int, End>, const Function &function)
+        {
+            if constexpr (Begin < End)
+            {
+                function(std::integral_constant<int, End - 1>());
+                for_indices_reversed(std::integral_constant<int, Begin>(), std::integral_constant<int, End - 1>(), function);
+            }
+        }
+
+        template <typename Function>
+        inline void for_indices_reversed(int begin, int end, const Function &function)
+        {
+            for (int i = end - 1; i >= begin; --i)
+                function(i);
+        }
+
+        template <int I>
+        constexpr std::integral_constant<int, I + 1> next_index(std::integral_constant<int, I>)
+        {
+            return {};
+        }
+
+        constexpr int next_index(int i)
+        {
+            return i + 1;
+        }
+
+        using first_index = std::integral_constant<int, 0>;
+
+        // the size of a decomposition or solve, an integral constant when its loops are unrolled: fixed sizes up to 8
+        template <int Size>
+        constexpr auto unrolled_size(int size)
+        {
+            if constexpr (Size != Dynamic && Size <= 8)
+                return std::integral_constant<int, Size>();
+            else
+                return size;
+        }
+
+        // true when the columns of T are consecutive coefficients in memory
+        template <typename T>
+        constexpr bool has_contiguous_columns = traits<T>::HasDirectAccess && !traits<T>::IsRowMajor && direct_strides<T>::Inner == 1;
+
+        // Matrices with contiguous columns whose size is not unrolled go through the axpy and dot kernels on
+        // their columns, everything else through coefficient accesses.
+        template <typename MatrixType, typename SizeType>
+        constexpr bool use_column_kernels = has_contiguous_columns<MatrixType> && std::is_same<SizeType, int>::value;
+
+        // In-place Cholesky factorization of the size x size matrix m, reading its lower triangle: L is left in the
+        // lower triangle and zeros above it. False when m is not positive definite.
+        template <typename MatrixType, typename SizeType>
+        inline bool llt_in_place(MatrixType &m, SizeType size)
+        {
+            using T = typename traits<MatrixType>::Scalar;
+            bool positive = true;
+            if constexpr (use_column_kernels<MatrixType, SizeType>)
+            {
+                // left-looking: column j less the columns before it, each an axpy down rows [j, size)
+                for (int j = 0; j < size; ++j)
+                {
+                    T *column = &m(0, j);
+                    for (int k = 0; k < j; ++k)
+                    {
+                        const T *previous = &m(0, k);
+                        axpy_contiguous(column + j, previous + j, -previous[j], size - j);
+                        column[k] = T(0);
+                    }
+                    positive = positive && column[j] > 0;
+                    const T diagonal = sqrt(column[j]);
+                    const T inverse = T(1) / diagonal;
+                    column[j] = diagonal;
+                    for (int i = j + 1; i < size; ++i)
+                        column[i] *= inverse;
+                }
+            }
+            else
+            {
+                for_indices(first_index(), size, [&](auto j)
+                            {
+                    T diagonal = m(j, j);
+                    for_indices(first_index(), j, [&](auto k)
+                                { diagonal -= m(j, k) * m(j, k); });
+                    positive = positive && diagonal > 0;
+                    diagonal = sqrt(diagonal);
+                    const T inverse = T(1) / diagonal;
+                    m(j, j) = diagonal;
+                    for_indices(next_index(j), size, [&](auto i)
+                                {
+                        T sum = m(i, j);
+                        for_indices(first_index(), j, [&](auto k)
+                                    { sum -= m(i, k) * m(j, k); });
+                        m(i, j) = sum * inverse;
+                        m(j, i) = T(0); }); });
+            }
+            return positive;
+        }
+
+        // In-place L * D * L^T factorization of the size x size matrix m, reading its lower triangle: the unit
+        // lower triangular L is left below the diagonal, D on it and zeros above it. False on a zero pivot.
+        template <typename MatrixType, typename SizeType>
+        inline bool ldlt_in_place(MatrixType &m, SizeType size)
+        {
+            using T = typename traits<MatrixType>::Scalar;
+            bool regular = true;
+            if constexpr (use_column_kernels<MatrixType, SizeType>)
+            {
+                for (int j = 0; j < size; ++j)
+                {
+                    T *column = &m(0, j);
+                    for (int k = 0; k < j; ++k)
+                    {
+                        const T *previous = &m(0, k);
+                        axpy_contiguous(column + j, previous + j, -previous[j] * previous[k], size - j);
+                        column[k] = T(0);
+                    }
+                    regular = regular && column[j] != T(0);
+                    const T inverse = T(1) / column[j];
+                    for (int i = j + 1; i < size; ++i)
+                        column[i] *= inverse;
+                }
+            }
+            else
+            {
+                // L(j, k) * D(k) is kept above the diagonal, at (k, j), while column j is computed
+                for_indices(first_index(), size, [&](auto j)
+                            {
+                    T diagonal = m(j, j);
+                    for_indices(first_index(), j, [&](auto k)
+                                {
+                        m(k, j) = m(j, k) * m(k, k);
+                        diagonal -= m(j, k) * m(k, j); });
+                    regular = regular && diagonal != T(0);
+                    const T inverse = T(1) / diagonal;
+                    m(j, j) = diagonal;
+                    for_indices(next_index(j), size, [&](auto i)
+                                {
+                        T sum = m(i, j);
+                        for_indices(first_index(), j, [&](auto k)
+                                    { sum -= m(i, k) * m(k, j); });
+                        m(i, j) = sum * inverse; });
+                    for_indices(first_index(), j, [&](auto k)
+                                { m(k, j) = T(0); }); });
+            }
+            return regular;
+        }
+
+        // x = L^-1 * x for the lower triangle L of m and a contiguous vector x, by forward substitution. With
+        // UnitDiagonal the diagonal of m is not read and taken as ones. The coefficients of x before begin are
+        // zero and skipped, e.g. for the columns of the identity.
+        template <bool UnitDiagonal, typename MatrixType, typename SizeType, typename T, typename BeginType = first_index>
+        inline void lower_solve_in_place(const MatrixType &m, T *x, SizeType size, BeginType begin = BeginType())
+        {
+            if constexpr (use_column_kernels<MatrixType, SizeType>)
+            {
+                for (int j = begin; j < size; ++j)
+                {
+                    const T *column = &m(0, j);
+                    if constexpr (!UnitDiagonal)
+                        x[j] /= column[j];
+                    axpy_contiguous(x + j + 1, column + j + 1, -x[j], size - j - 1);
+                }
+            }
+            else
+            {
+                for_indices(begin, size, [&](auto j)
+                            {
+                    T sum = x[j];
+                    for_indices(begin, j, [&](auto k)
+                                { sum -= m(j, k) * x[k]; });
+                    if constexpr (UnitDiagonal)
+                        x[j] = sum;
+                    else
+                        x[j] = sum / m(j, j); });
+            }
+        }
+
+        // x = L^-T * x for the lower triangle L of m and a contiguous vector x, by back substitution
+        template <bool UnitDiagonal, typename MatrixType, typename SizeType, typename T>
+        inline void lower_adjoint_solve_in_place(const MatrixType &m, T *x, SizeType size)
+        {
+            if constexpr (use_column_kernels<MatrixType, SizeType>)
+            {
+                for (int j = size - 1; j >= 0; --j)
+                {
+                    const T *column = &m(0, j);
+                    x[j] -= dot_contiguous(column + j + 1, x + j + 1, size - j - 1);
+                    if constexpr (!UnitDiagonal)
+                        x[j] /= column[j];
+                }
+            }
+            else
+            {
+                for_indices_reversed(first_index(), size, [&](auto j)
+                                     {
+                    T sum = x[j];
+                    for_indices(next_index(j), size, [&](auto k)
+                                { sum -= m(k, j) * x[k]; });
+                    if constexpr (UnitDiagonal)
+                        x[j] = sum;
+                    else
+                        x[j] = sum / m(j, j); });
+            }
+        }
+        // x = U^-1 * x for the upper triangle U of m and a contiguous vector x, by back substitution
+        template <bool UnitDiagonal, typename MatrixType, typename SizeType, typename T>
+        inline void upper_solve_in_place(const MatrixType &m, T *x, SizeType size)
+        {
+            if constexpr (use_column_kernels<MatrixType, SizeType>)
+            {
+                for (int j = size - 1; j >= 0; --j)
+                {
+                    const T *column = &m(0, j);
+                    if constexpr (!UnitDiagonal)
+                        x[j] /= column[j];
+                    axpy_contiguous(x, column, -x[j], j);
+                }
+            }
+            else
+            {
+                for_indices_reversed(first_index(), size, [&](auto j)
+                                     {
+                    T sum = x[j];
+                    for_indices(next_index(j), size, [&](auto k)
+                                { sum -= m(j, k) * x[k]; });
+                    if constexpr (UnitDiagonal)
+                        x[j] = sum;
+                    else
+                        x[j] = sum / m(j, j); });
+            }
+        }
+
+        // true when the rows of T are consecutive coefficients in memory
+        template <typename T>
+        constexpr bool has_contiguous_rows = traits<T>::HasDirectAccess && traits<T>::IsRowMajor && direct_strides<T>::Inner == 1;
+
+        // the panels of lu_blocked are 8 rows, two tiles of 4 columns of the product kernels deep
+        constexpr int lu_panel_size = 8;
+
+        // Steps [k, k + Panel) of the LU decomposition of the size x size matrix m, with contiguous columns: the
+        // steps of lu_in_place, pivot search along each row and swap of whole columns, with the elimination only
+        // applied to the rows of the panel, unrolled down the short columns. Rows below the panel are left to
+        // lu_blocked.
+        template <int Panel, typename MatrixType>
+        inline void lu_panel(MatrixType &m, int *pivots, int k, int size)
+        {
+            using T = typename traits<MatrixType>::Scalar;
+            T *data = &m(0, 0);
+            const int stride = m.outerStride();
+            for_indices(first_index(), std::integral_constant<int, Panel>(), [&](auto p)
+                        {
+                const int j = k + p;
+                const T *row = data + j;
+                int pivot = j;
+                T largest = fabs(row[j * stride]);
+                for (int c = j + 1; c < size; ++c)
+                {
+                    const T value = fabs(row[c * stride]);
+                    if (value > largest)
+                    {
+                        largest = value;
+                        pivot = c;
+                    }
+                }
+                pivots[j] = pivot;
+                if (pivot != j)
+                {
+                    T *column = data + j * stride;
+                    T *other = data + pivot * stride;
+                    for (int i = 0; i < size; ++i)
+                    {
+                        const T tmp = column[i];
+                        column[i] = other[i];
+                        other[i] = tmp;
+                    }
+                }
+                // the column of L in the panel is kept in registers while the columns right of it are updated
+                const T inverse = T(1) / data[j * stride + j];
+                T lower[Panel];
+                for_indices(next_index(p), std::integral_constant<int, Panel>(), [&](auto i)
+                            { lower[i] = data[j * stride + k + i]; });
+                for (int c = j + 1; c < size; ++c)
+                {
+                    T *column = data + c * stride + k;
+                    const T factor = column[p] * inverse;
+                    column[p] = factor;
+                    for_indices(next_index(p), std::integral_constant<int, Panel>(), [&](auto i)
+                                { column[i] -= lower[i] * factor; });
+                } });
+        }
+
+        // Right-looking blocked LU decomposition with column pivoting of the fixed-size matrix m, with contiguous
+        // columns. For the panel of rows [K, K + Panel), with A = [A11 A12; A21 A22] its trailing matrix:
+        // - lu_panel decomposes [A11 A12] * P = L11 * [U11 U12], swapping the whole columns;
+        // - L21 = A21 * U11^-1, column after column with axpys;
+        // - A22 -= L21 * U12 with the blocked product kernel, then the same for A22 from row K + Panel on.
+        // Each coefficient of A22 is updated once per panel instead of once per step, in register tiles.
+        template <int K, int Size, typename MatrixType>
+        inline void lu_blocked(MatrixType &m, int *pivots)
+        {
+            using T = typename traits<MatrixType>::Scalar;
+            constexpr int Panel = Size - K < lu_panel_size ? Size - K : lu_panel_size;
+            constexpr int Rest = Size - K - Panel;
+            lu_panel<Panel>(m, pivots, K, Size);
+            if constexpr (Rest > 0)
+            {
+                for (int j = 1; j < Panel; ++j)
+                {
+                    T *column = &m(K + Panel, K + j);
+                    for (int p = 0; p < j; ++p)
+                        axpy_contiguous(column, &m(K + Panel, K + p), -m(K + p, K + j), Rest);
+                }
+                const auto upper = [&](int p, int c)
+                { return m(K + p, K + Panel + c); };
+                matmul_blocked<T, Rest, Panel, Rest>(&m(K + Panel, K), m.outerStride(), upper, &m(K + Panel, K + Panel), m.outerStride(),
+                                                     T(1), sub_assign_op());
+                lu_blocked<K + Panel, Size>(m, pivots);
+            }
+        }
+
+        // In-place LU decomposition with column pivoting, m * P = L * U: at step k the column with the largest
+        // coefficient in row k is swapped with column k, pivots[k] being its index, column k below the diagonal
+        // is the column of L and row k right of it is divided by the pivot into the row of U. The trailing
+        // matrix is then updated along its contiguous dimension, with axpys when the size is not unrolled.
+        // Fixed sizes beyond the unrolled ones with contiguous columns go to lu_blocked.
+        template <typename MatrixType, typename SizeType>
+        inline void lu_in_place(MatrixType &m, int *pivots, SizeType size)
+        {
+            using T = typename traits<MatrixType>::Scalar;
+            constexpr int Size = traits<MatrixType>::RowsAtCompileTime;
+            if constexpr (has_contiguous_columns<MatrixType> && Size != Dynamic && std::is_same<SizeType, int>::value)
+            {
+                lu_blocked<0, Size>(m, pivots);
+                return;
+            }
+            for_indices(first_index(), size, [&](auto k)
+                        {
+                int pivot = k;
+                for (int j = k + 1; j < size; ++j)
+                {
+                    if (fabs(m(k, j)) > fabs(m(k, pivot)))
+                        pivot = j;
+                }
+                pivots[k] = pivot;
+                if (pivot != k)
+                {
+                    for (int i = 0; i < size; ++i)
+                    {
+                        const T tmp = m(i, k);
+                        m(i, k) = m(i, pivot);
+                        m(i, pivot) = tmp;
+                    }
+                }
+                const T inverse = T(1) / m(k, k);
+                if constexpr (has_contiguous_rows<MatrixType> && std::is_same<SizeType, int>::value)
+                {
+                    T *row = &m(k, 0);
+                    for (int j = k + 1; j < size; ++j)
+                        row[j] *= inverse;
+                    for (int i = k + 1; i < size; ++i)
+                        axpy_contiguous(&m(i, k + 1), row + k + 1, -m(i, k), size - k - 1);
+                }
+                else
+                {
+                    for_indices(next_index(k), size, [&](auto j)
+                                {
+                        const T factor = m(k, j) * inverse;
+                        m(k, j) = factor;
+                        if constexpr (use_column_kernels<MatrixType, SizeType>)
+                            axpy_contiguous(&m(k + 1, j), &m(k + 1, k), -factor, size - k - 1);
+                        else
+                            for_indices(next_index(k), size, [&](auto i)
+                                        { m(i, j) -= m(i, k) * factor; }); });
+                } });
+        }
+
+        // L^-1 for the lower triangle L of m, column-major. Unrolled sizes solve L * x = e_c for every column c,
+        // skipping the first c coefficients of x, which are zero. Larger ones compute it row after row from
+        // the rows above, coefficient by coefficient: short columns are too short for the axpy kernels to pay.
+        template <bool UnitDiagonal, typename MatrixType, typename SizeType>
+        inline auto lower_inverse(const MatrixType &m, SizeType size)
+        {
+            using T = typename traits<MatrixType>::Scalar;
+            using ResultType = typename column_major_plain<MatrixType>::type;
+            ResultType inverse = plain_uninitialized<ResultType>(size, size);
+            if constexpr (std::is_same<SizeType, int>::value)
+            {
+                for (int i = 0; i < size; ++i)
+                {
+                    const T diagonal = UnitDiagonal ? T(1) : T(1) / m(i, i);
+                    for (int j = 0; j < i; ++j)
+                    {
+                        T sum = 0;
+                        for (int k = j; k < i; ++k)
+                            sum -= m(i, k) * inverse(k, j);
+                        inverse(i, j) = sum * diagonal;
+                    }
+                    inverse(i, i) = diagonal;
+                    for (int j = i + 1; j < size; ++j)
+                        inverse(i, j) = T(0);
+                }
+            }
+            else
+            {
+                for_indices(first_index(), size, [&](auto c)
+                            {
+                    T *column = &inverse(0, c);
+                    for (int i = 0; i < size; ++i)
+                        column[i] = T(0);
+                    column[c] = T(1);
+                    lower_solve_in_place<UnitDiagonal>(m, column, size, c); });
+            }
+            return inverse;
+        }
+
+        // U^-1 for the upper triangle U of m, column-major, row after row from the bottom like lower_inverse
+        template <bool UnitDiagonal, typename MatrixType>
+        inline auto upper_inverse(const MatrixType &m, int size)
+        {
+            using T = typename traits<MatrixType>::Scalar;
+            using ResultType = typename column_major_plain<MatrixType>::type;
+            ResultType inverse = plain_uninitialized<ResultType>(size, size);
+            for (int i = size - 1; i >= 0; --i)
+            {
+                const T diagonal = UnitDiagonal ? T(1) : T(1) / m(i, i);
+                for (int j = 0; j < i; ++j)
+                    inverse(i, j) = T(0);
+                inverse(i, i) = diagonal;
+                for (int j = i + 1; j < size; ++j)
+                {
+                    T sum = 0;
+                    for (int k = i + 1; k <= j; ++k)
+                        sum -= m(i, k) * inverse(k, j);
+                    inverse(i, j) = sum * diagonal;
+                }
             }
+            return inverse;
         }
+    }
 
-        EmbeddedCoreType(const ScalarType a1, const ScalarType a2)
-        {
-            static_assert(MaxDimAtCompileTime >= 2);
-            Elements[0] = a1;
-            Elements[1] = a2;
-        }
+    // Triangular part of a square matrix or expression: the Lower or Upper triangle as stored, zeros elsewhere,
+    // and ones or zeros on the diagonal with UnitDiag or ZeroDiag. It is read-only.
+    template <typename XprType, int Mode>
+    class EmbeddedTriangularView : public EmbeddedExprBase<EmbeddedTriangularView<XprType, Mode>>
+    {
+    protected:
+        typename internal::ref_selector<XprType>::type m_xpr;
 
-        EmbeddedCoreType(const ScalarType a1, const ScalarType a2, const ScalarType a3)
-        {
-            static_assert(MaxDimAtCompileTime >= 3);
-            Elements[0] = a1;
-            Elements[1] = a2;
-            Elements[2] = a3;
-        }
+    public:
+        using Scalar = typename internal::traits<EmbeddedTriangularView>::Scalar;
 
-        EmbeddedCoreType(const ScalarType a1, const ScalarType a2, const ScalarType a3, const ScalarType a4)
+        constexpr explicit EmbeddedTriangularView(const XprType &xpr) : m_xpr(xpr)
         {
-            static_assert(MaxDimAtCompileTime >= 4);
-            Elements[0] = a1;
-            Elements[1] = a2;
-            Elements[2] = a3;
-            Elements[3] = a4;
+            static_assert(((Mode & Lower) != 0) != ((Mode & Upper) != 0), "triangularView needs either Lower or Upper");
+            static_assert(internal::compatible_size<internal::traits<XprType>::RowsAtCompileTime, internal::traits<XprType>::ColsAtCompileTime>::value,
+                          "triangularView needs a square matrix");
         }
 
-        ~EmbeddedCoreType() {}
+        constexpr int rows() const { return m_xpr.rows(); }
+        constexpr int cols() const { return m_xpr.cols(); }
 
-        inline ScalarType &x()
+        constexpr Scalar coeff(int row, int col) const
         {
-            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 1);
-            return this->Elements[0];
+            if (row == col && (Mode & (UnitDiag | ZeroDiag)))
+                return (Mode & UnitDiag) ? Scalar(1) : Scalar(0);
+            const bool inside = (Mode & Lower) ? row >= col : row <= col;
+            return inside ? m_xpr.coeff(row, col) : Scalar(0);
         }
-        inline const ScalarType &x() const
+
+        constexpr Scalar operator()(int row, int col) const
         {
-            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 1);
-            return this->Elements[0];
+            return coeff(row, col);
         }
 
-        inline ScalarType &y()
+        constexpr const internal::nested_t<XprType> &nestedExpression() const
         {
-            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 2);
-            return this->Elements[1];
+            return m_xpr;
         }
-        inline const ScalarType &y() const
+
+        //! x with T * x = b for this triangle T, by forward (Lower) or back (Upper) substitution on every column of b
+        template <typename RhsDerived>
+        auto solve(const EmbeddedExprBase<RhsDerived> &b) const
         {
-            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 2);
-            return this->Elements[1];
+            typename internal::column_major_plain<RhsDerived>::type x(b.derived());
+            solveInPlace(x);
+            return x;
         }
 
-        inline ScalarType &z()
+        //! b = T^-1 * b for a writable matrix or view b, e.g. a block of a larger matrix
+        template <typename OtherDerived>
+        inline void solveInPlace(EmbeddedExprBase<OtherDerived> &other) const
         {
-            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 3);
-            return this->Elements[2];
+            using OtherTraits = internal::traits<OtherDerived>;
+            static_assert(!(Mode & ZeroDiag), "a triangle with a zero diagonal is singular");
+            static_assert(internal::compatible_size<internal::traits<XprType>::RowsAtCompileTime, OtherTraits::RowsAtCompileTime>::value,
+                          "solve needs as many rows as the triangle");
+            // the kernels read the triangle through coefficient accesses or, when possible, contiguous columns
+            std::conditional_t<internal::traits<XprType>::HasDirectAccess, const XprType &, const typename internal::traits<XprType>::PlainObject> matrix(m_xpr);
+            const auto size = internal::unrolled_size<internal::traits<XprType>::RowsAtCompileTime>(matrix.rows());
+            OtherDerived &x = other.derived();
+            for (int c = 0; c < x.cols(); ++c)
+            {
+                if constexpr (internal::has_contiguous_columns<OtherDerived>)
+                {
+                    solveColumn(matrix, &x(0, c), size);
+                }
+                else
+                {
+                    Scalar column[OtherTraits::PlainObject::MaxRowsAtCompileTime];
+                    for (int i = 0; i < x.rows(); ++i)
+                        column[i] = x(i, c);
+                    solveColumn(matrix, column, size);
+                    for (int i = 0; i < x.rows(); ++i)
+                        x(i, c) = column[i];
+                }
+            }
         }
-        inline const ScalarType &z() const
+
+        template <typename OtherDerived>
+        inline void solveInPlace(EmbeddedExprBase<OtherDerived> &&other) const
         {
-            static_assert(MaxRankAtCompileTime == 1 && MaxDimAtCompileTime >= 3);
-            return this->Elements[2];
+            solveInPlace(other);
         }
 
-        inline ScalarType &operator()(int index)
+    private:
+        template <typename MatrixType, typename SizeType>
+        static void solveColumn(const MatrixType &matrix, Scalar *x, SizeType size)
         {
-            return Elements[index];
+            if constexpr ((Mode & Lower) != 0)
+                internal::lower_solve_in_place<(Mode & UnitDiag) != 0>(matrix, x, size);
+            else
+                internal::upper_solve_in_place<(Mode & UnitDiag) != 0>(matrix, x, size);
         }
+    };
 
-        inline const ScalarType &operator()(int index) const
+    // Symmetric matrix of which only the Lower or Upper triangle is read, the other one being its mirror. On a
+    // writable matrix or view it also updates the matrix with products known to be symmetric, such as the
+    // covariance updates of a Kalman filter, computing the triangle only and copying it to the other one: the
+    // whole matrix then holds the result and stays exactly symmetric.
+    template <typename XprType, int UpLo>
+    class EmbeddedSelfAdjointView : public EmbeddedExprBase<EmbeddedSelfAdjointView<XprType, UpLo>>
+    {
+    protected:
+        using MatrixType = std::remove_const_t<XprType>;
+        // a writable matrix is held by reference to be updated, views by value, const ones like in any expression
+        using NestedType = std::conditional_t<std::is_const<XprType>::value, typename internal::ref_selector<MatrixType>::type,
+                                              std::conditional_t<internal::traits<MatrixType>::NestByRef, MatrixType &, MatrixType>>;
+        NestedType m_xpr;
+
+        // the stored triangle copied to the lower one, which the kernels update
+        constexpr void mirrorToLower()
         {
-            return Elements[index];
+            if constexpr (UpLo == Upper)
+                internal::mirror_triangle<Upper>(m_xpr);
         }
 
-        inline ScalarType &operator()(int row, int col)
+    public:
+        using Scalar = typename internal::traits<EmbeddedSelfAdjointView>::Scalar;
+
+        constexpr explicit EmbeddedSelfAdjointView(XprType &xpr) : m_xpr(xpr)
         {
-            return Elements[col * rows + row];
+            static_assert(UpLo == Lower || UpLo == Upper, "selfadjointView needs either Lower or Upper");
+            static_assert(internal::compatible_size<internal::traits<MatrixType>::RowsAtCompileTime, internal::traits<MatrixType>::ColsAtCompileTime>::value,
+                          "selfadjointView needs a square matrix");
         }
 
-        inline const ScalarType &operator()(int row, int col) const
+        constexpr int rows() const { return m_xpr.rows(); }
+        constexpr int cols() const { return m_xpr.cols(); }
+
+        constexpr Scalar coeff(int row, int col) const
         {
-            return Elements[col * rows + row];
+            const bool stored = (UpLo == Lower) ? row >= col : row <= col;
+            return stored ? m_xpr.coeff(row, col) : m_xpr.coeff(col, row);
         }
 
-        inline ScalarType *data()
+        constexpr Scalar operator()(int row, int col) const
         {
-            return Elements;
+            return coeff(row, col);
         }
 
-        inline const ScalarType *data() const
+        constexpr const internal::nested_t<MatrixType> &nestedExpression() const
         {
-            return Elements;
+            return m_xpr;
         }
 
-        template <int length>
-        inline const EmbeddedCoreType<ScalarType, length, 1> head() const
+        //! A += alpha * u * u^T for a n x k matrix u, half of the multiply-adds of the full product
+        template <typename OtherDerived>
+        constexpr EmbeddedSelfAdjointView &rankUpdate(const EmbeddedExprBase<OtherDerived> &u, const Scalar &alpha = Scalar(1))
         {
-            EmbeddedCoreType<ScalarType, length, 1> result;
-            for (int i = 0; i < length; i++)
-            {
-                result(i) = Elements[i];
-            }
-            return result;
+            static_assert(!std::is_const<XprType>::value, "rankUpdate needs a writable matrix");
+            internal::column_major_operand_t<OtherDerived> uEval(u.derived());
+            mirrorToLower();
+            internal::symmetric_product(m_xpr, uEval, uEval.transpose(), alpha, internal::add_assign_op());
+            return *this;
         }
 
-        template <int length>
-        inline const EmbeddedCoreType<ScalarType, length, 1> tail() const
+        //! A += alpha * K * S * K^T for a n x m matrix K and a symmetric m x m matrix S, e.g. P -= K * S * K^T with
+        //! alpha = -1 in the update of a Kalman filter. K * S is a full product, K * S * K^T only its lower triangle.
+        template <typename KDerived, typename SDerived>
+        constexpr EmbeddedSelfAdjointView &congruenceUpdate(const EmbeddedExprBase<KDerived> &k, const EmbeddedExprBase<SDerived> &s,
+                                                             const Scalar &alpha = Scalar(1))
         {
-            EmbeddedCoreType<ScalarType, length, 1> result;
-            for (int i = 0; i < length; i++)
-            {
-                result(i) = Elements[size - length + i];
-            }
-            return result;
+            static_assert(!std::is_const<XprType>::value, "congruenceUpdate needs a writable matrix");
+            internal::column_major_operand_t<KDerived> kEval(k.derived());
+            const typename internal::column_major_plain<KDerived>::type ks(kEval * s.derived());
+            mirrorToLower();
+            internal::symmetric_product(m_xpr, ks, kEval.transpose(), alpha, internal::add_assign_op());
+            return *this;
         }
 
-        inline bool operator==(const EmbeddedCoreType &other) const
+        //! F * A * F^T for a m x n matrix F, e.g. the propagation F * P * F^T of a covariance. F * A is a full
+        //! product, F * A * F^T only its lower triangle, and the result is exactly symmetric.
+        template <typename OtherDerived>
+        constexpr auto congruence(const EmbeddedExprBase<OtherDerived> &f) const
         {
-            for (int i = 0; i < size; i++)
-            {
-                if (Elements[i] != other(i))
-                    return false;
-            }
-            return true;
+            using FPlain = typename internal::column_major_plain<OtherDerived>::type;
+            using ResultType = EmbeddedCoreType<Scalar, FPlain::RowsAtCompileTime, FPlain::RowsAtCompileTime, DefaultStorage,
+                                                FPlain::MaxRowsAtCompileTime, FPlain::MaxRowsAtCompileTime>;
+            internal::column_major_operand_t<OtherDerived> fEval(f.derived());
+            const FPlain fa(fEval * *this);
+            ResultType result = internal::plain_uninitialized<ResultType>(fEval.rows(), fEval.rows());
+            internal::symmetric_product(result, fa, fEval.transpose(), Scalar(1), internal::assign_op());
+            return result;
         }
+    };
+
+    // Symmetric N x N matrix of which only the lower triangle is stored, packed column by column: N(N+1)/2
+    // coefficients instead of N*N, e.g. 300 doubles for a 24x24 covariance instead of 576. (i, j) and (j, i)
+    // are the same stored coefficient. In expressions it reads like the full matrix and evaluates to an
+    // EmbeddedCoreType<ScalarType, N, N>; products with plain matrices, the symmetric updates and LLT work on
+    // the packed columns directly.
+    template <typename ScalarType, int N>
+    class EmbeddedSymmetricType : public EmbeddedExprBase<EmbeddedSymmetricType<ScalarType, N>>
+    {
+        static_assert(N > 0, "SymmetricMatrix needs a fixed size");
+
+    public:
+        using Scalar = ScalarType;
+        static constexpr int PackedSize = N * (N + 1) / 2;
+
+    protected:
+        ScalarType Elements[PackedSize];
 
-        inline bool operator!=(const EmbeddedCoreType &other) const
+        // the lower triangle of other, which is assumed symmetric, assigned, added or subtracted by func
+        template <typename OtherDerived, typename Functor>
+        constexpr void assignLower(const OtherDerived &other, const Functor &func)
         {
-            for (int i = 0; i < size; i++)
+            static_assert(internal::compatible_size<N, internal::traits<OtherDerived>::RowsAtCompileTime>::value &&
+                              internal::compatible_size<N, internal::traits<OtherDerived>::ColsAtCompileTime>::value,
+                          "assignment between matrices of different sizes");
+            internal::assignment_source_t<OtherDerived> source(other);
+            int index = 0;
+            for (int j = 0; j < N; ++j)
             {
-                if (Elements[i] != other(i))
-                    return true;
+                for (int i = j; i < N; ++i)
+                {
+                    func.assignCoeff(Elements[index++], source.coeff(i, j));
+                }
             }
-            return false;
         }
 
-        inline EmbeddedCoreType operator+(const EmbeddedCoreType &other) const
+        template <typename Functor>
+        constexpr void assignPacked(const EmbeddedSymmetricType &other, const Functor &func)
         {
-            EmbeddedCoreType result;
-            for (int i = 0; i < size; i++)
+            for (int i = 0; i < PackedSize; ++i)
             {
-                result(i) = Elements[i] + other(i);
+                func.assignCoeff(Elements[i], other.Elements[i]);
             }
-            return result;
         }
 
-        inline EmbeddedCoreType operator-(const EmbeddedCoreType &other) const
+    public:
+        constexpr EmbeddedSymmetricType() : Elements{} {}
+
+        //! leaves all elements uninitialized
+        explicit EmbeddedSymmetricType(NoInit_t) {}
+
+        //! the lower triangle of a square matrix or expression, which is assumed symmetric
+        template <typename OtherDerived>
+        constexpr EmbeddedSymmetricType(const EmbeddedExprBase<OtherDerived> &other)
+            : EmbeddedSymmetricType(internal::plain_uninitialized<EmbeddedSymmetricType>())
         {
-            EmbeddedCoreType result;
-            for (int i = 0; i < size; i++)
-            {
-                result(i) = Elements[i] - other(i);
-            }
-            return result;
+            assignLower(other.derived(), internal::assign_op());
         }
 
-        inline EmbeddedCoreType operator*(const ScalarType factor) const
+        template <typename OtherDerived>
+        constexpr EmbeddedSymmetricType &operator=(const EmbeddedExprBase<OtherDerived> &other)
         {
-            EmbeddedCoreType result;
-            for (int i = 0; i < size; i++)
-            {
-                result(i) = Elements[i] * factor;
-            }
-            return result;
+            assignLower(other.derived(), internal::assign_op());
+            return *this;
         }
 
-        friend EmbeddedCoreType operator*(ScalarType factor, const EmbeddedCoreType &matrix)
+        constexpr EmbeddedSymmetricType &operator+=(const EmbeddedSymmetricType &other)
         {
-            return matrix * factor;
+            assignPacked(other, internal::add_assign_op());
+            return *this;
         }
 
-        inline EmbeddedCoreType operator/(const ScalarType factor) const
+        constexpr EmbeddedSymmetricType &operator-=(const EmbeddedSymmetricType &other)
         {
-            EmbeddedCoreType result;
-            for (int i = 0; i < size; i++)
-            {
-                result(i) = Elements[i] / factor;
-            }
-            return result;
+            assignPacked(other, internal::sub_assign_op());
+            return *this;
         }
 
-        inline EmbeddedCoreType &operator+=(const EmbeddedCoreType &other)
+        template <typename OtherDerived>
+        constexpr EmbeddedSymmetricType &operator+=(const EmbeddedExprBase<OtherDerived> &other)
         {
-            for (int i = 0; i < size; i++)
-            {
-                Elements[i] += other(i);
-            }
+            assignLower(other.derived(), internal::add_assign_op());
             return *this;
         }
 
-        inline EmbeddedCoreType &operator-=(const EmbeddedCoreType &other)
+        template <typename OtherDerived>
+        constexpr EmbeddedSymmetricType &operator-=(const EmbeddedExprBase<OtherDerived> &other)
         {
-            for (int i = 0; i < size; i++)
-            {
-                Elements[i] -= other(i);
-            }
+            assignLower(other.derived(), internal::sub_assign_op());
             return *this;
         }
 
-        inline EmbeddedCoreType &operator*=(const ScalarType factor)
+        constexpr EmbeddedSymmetricType &operator*=(const ScalarType &factor)
         {
-            for (int i = 0; i < size; i++)
+            for (int i = 0; i < PackedSize; ++i)
             {
                 Elements[i] *= factor;
             }
             return *this;
         }
 
-        inline EmbeddedCoreType &operator/=(const ScalarType factor)
+        constexpr EmbeddedSymmetricType &operator/=(const ScalarType &divisor)
         {
-            for (int i = 0; i < size; i++)
+            for (int i = 0; i < PackedSize; ++i)
             {
-                Elements[i] /= factor;
+                Elements[i] /= divisor;
             }
             return *this;
         }
 
-        inline EmbeddedCoreType<ScalarType, cols, rows> transpose() const
+        constexpr int rows() const { return N; }
+        constexpr int cols() const { return N; }
+
+        //! position of (row, col) in the packed storage, the one of (col, row) above the diagonal
+        static constexpr int packedIndex(int row, int col)
         {
-            EmbeddedCoreType<ScalarType, cols, rows> result;
-            for (int i = 0; i < rows; i++)
-            {
-                for (int j = 0; j < cols; j++)
-                {
-                    result(j, i) = Elements[j * cols + i];
-                }
-            }
-            return result;
+            if (row < col)
+                return packedIndex(col, row);
+            return col * N - col * (col - 1) / 2 + row - col;
         }
 
-        inline void setZero()
+        constexpr ScalarType coeff(int row, int col) const
         {
-            memset(Elements, 0, size * sizeof(ScalarType));
-            return;
+            return Elements[packedIndex(row, col)];
         }
 
-        static inline EmbeddedCoreType Zero()
+        constexpr ScalarType &coeffRef(int row, int col)
         {
-            EmbeddedCoreType result;
-            memset(result.data(), (ScalarType)0, size * sizeof(ScalarType));
-            return result;
+            return Elements[packedIndex(row, col)];
         }
 
-        static inline EmbeddedCoreType Ones()
+        constexpr const ScalarType &operator()(int row, int col) const
         {
-            EmbeddedCoreType result;
-            for (int i = 0; i < size; i++)
-            {
-                result(i) = static_cast<ScalarType>(1);
-            }
-            return result;
+            return Elements[packedIndex(row, col)];
         }
 
-        inline ScalarType norm() const
+        //! also writes (col, row)
+        constexpr ScalarType &operator()(int row, int col)
         {
-            ScalarType result = 0;
-            for (int i = 0; i < size; i++)
-            {
-                result += Elements[i] * Elements[i];
-            }
-            return sqrt(result);
+            return Elements[packedIndex(row, col)];
         }
 
-        inline EmbeddedCoreType normalized() const
+        //! the PackedSize coefficients of the lower triangle, column after column
+        constexpr ScalarType *data() { return Elements; }
+        constexpr const ScalarType *data() const { return Elements; }
+
+        constexpr void setZero()
         {
-            EmbeddedCoreType result;
-            ScalarType _norm = norm();
-            for (int i = 0; i < size; i++)
+            for (int i = 0; i < PackedSize; ++i)
             {
-                result(i) = Elements[i] / _norm;
+                Elements[i] = static_cast<ScalarType>(0);
             }
-            return result;
         }
 
-        inline void normalize()
+        static constexpr EmbeddedSymmetricType Zero()
         {
-            ScalarType _norm = norm();
-            for (int i = 0; i < size; i++)
-            {
-                Elements[i] /= _norm;
-            }
-            return;
+            return EmbeddedSymmetricType();
         }
 
-        inline ScalarType trace() const
+        static constexpr EmbeddedSymmetricType Identity()
         {
-            ScalarType result = 0;
-            for (int i = 0; i < MaxRankAtCompileTime; i++)
+            EmbeddedSymmetricType result;
+            for (int i = 0; i < N; ++i)
             {
-                result += this->Elements[i * cols + i];
+                result(i, i) = static_cast<ScalarType>(1);
             }
             return result;
         }
 
-        inline ScalarType determinant() const
+        //! S += alpha * u * u^T for a N x k matrix u, computing the packed lower triangle only
+        template <typename OtherDerived>
+        constexpr EmbeddedSymmetricType &rankUpdate(const EmbeddedExprBase<OtherDerived> &u, const ScalarType &alpha = ScalarType(1))
         {
-            ScalarType result = 0;
-            if constexpr (RowsAtCompileTime == 1 && ColsAtCompileTime == 1)
-            {
-                result = this->Elements[0];
-            }
-            else if constexpr (RowsAtCompileTime == 2 && ColsAtCompileTime == 2)
-            {
-                result = this->Elements[0] * this->Elements[3] - this->Elements[1] * this->Elements[2];
-            }
-            else if constexpr (RowsAtCompileTime == 3 && ColsAtCompileTime == 3)
-            {
-                result = this->Elements[0] * this->Elements[4] * this->Elements[8] -
-                         this->Elements[0] * this->Elements[7] * this->Elements[5] -
-                         this->Elements[3] * this->Elements[1] * this->Elements[8] +
-                         this->Elements[3] * this->Elements[7] * this->Elements[2] +
-                         this->Elements[6] * this->Elements[1] * this->Elements[5] -
-                         this->Elements[6] * this->Elements[4] * this->Elements[2];
-            }
-            else
-            {
-                PartialPivLU<EmbeddedCoreType> lu(*this);
-                result = lu.determinant();
-            }
-            return result;
+            internal::column_major_operand_t<OtherDerived> uEval(u.derived());
+            internal::packed_product(Elements, uEval, uEval.transpose(), alpha, internal::add_assign_op());
+            return *this;
         }
 
-        inline ScalarType dot(const EmbeddedCoreType &other) const
+        //! S += alpha * K * M * K^T for a N x m matrix K and a symmetric m x m matrix M, plain or packed, e.g.
+        //! P -= K * S * K^T with alpha = -1 in the update of a Kalman filter
+        template <typename KDerived, typename MDerived>
+        constexpr EmbeddedSymmetricType &congruenceUpdate(const EmbeddedExprBase<KDerived> &k, const EmbeddedExprBase<MDerived> &m,
+                                                          const ScalarType &alpha = ScalarType(1))
         {
-            ScalarType result = 0;
-            for (int i = 0; i < size; i++)
-            {
-                result += this->Elements[i] * other(i);
-            }
-            return result;
+            internal::column_major_operand_t<KDerived> kEval(k.derived());
+            const typename internal::column_major_plain<KDerived>::type km(kEval * m.derived());
+            internal::packed_product(Elements, km, kEval.transpose(), alpha, internal::add_assign_op());
+            return *this;
         }
 
-        inline EmbeddedCoreType cross(const EmbeddedCoreType &other) const
+        //! F * S * F^T for a M x N matrix F, packed, e.g. the propagation F * P * F^T of a covariance. F * S is
+        //! a full product, F * S * F^T only its packed lower triangle.
+        template <typename OtherDerived>
+        constexpr auto congruence(const EmbeddedExprBase<OtherDerived> &f) const
         {
-            EmbeddedCoreType result;
-            if constexpr (RowsAtCompileTime == 2 && ColsAtCompileTime == 1)
-            {
-                result(0) = this->Elements[1] * other(0);
-                result(1) = -this->Elements[0] * other(0);
-            }
-            else if constexpr (RowsAtCompileTime == 3 && ColsAtCompileTime == 1)
-            {
-                result(0) = this->Elements[1] * other(2) - this->Elements[2] * other(1);
-                result(1) = this->Elements[2] * other(0) - this->Elements[0] * other(2);
-                result(2) = this->Elements[0] * other(1) - this->Elements[1] * other(0);
-            }
+            constexpr int M = internal::traits<OtherDerived>::RowsAtCompileTime;
+            static_assert(M != Dynamic, "congruence needs a fixed number of rows");
+            using ResultType = EmbeddedSymmetricType<ScalarType, M>;
+            internal::column_major_operand_t<OtherDerived> fEval(f.derived());
+            const typename internal::column_major_plain<OtherDerived>::type fs(fEval * *this);
+            ResultType result = internal::plain_uninitialized<ResultType>();
+            internal::packed_product(result.data(), fs, fEval.transpose(), ScalarType(1), internal::assign_op());
             return result;
         }
 
-        inline void setIdentity()
+        //! Cholesky factorization of this matrix, in packed storage too
+        LLT<EmbeddedSymmetricType> llt() const
         {
-            setZero();
-            for (int i = 0; i < MaxRankAtCompileTime; i++)
+            return LLT<EmbeddedSymmetricType>(*this);
+        }
+    };
+
+    //! S * B for a packed symmetric S: a vector goes to packed_symv, a matrix is (B^T * S)^T
+    template <typename ScalarType, int N, typename RhsType,
+              std::enable_if_t<internal::compatible_size<N, internal::traits<RhsType>::RowsAtCompileTime>::value, int> = 0>
+    constexpr auto operator*(const EmbeddedSymmetricType<ScalarType, N> &lhs, const EmbeddedExprBase<RhsType> &rhs)
+    {
+        using ResultType = typename internal::column_major_plain<RhsType>::type;
+        internal::column_major_operand_t<RhsType> rhsEval(rhs.derived());
+        ResultType result = internal::plain_uninitialized<ResultType>(rhs.rows(), rhs.cols());
+        if (internal::is_constant_evaluated())
+        {
+            for (int j = 0; j < rhsEval.cols(); ++j)
             {
-                this->Elements[i * cols + i] = static_cast<ScalarType>(1);
+                for (int i = 0; i < N; ++i)
+                {
+                    ScalarType sum = 0;
+                    for (int k = 0; k < N; ++k)
+                    {
+                        sum += lhs.coeff(i, k) * rhsEval(k, j);
+                    }
+                    result(i, j) = sum;
+                }
             }
-            return;
         }
+        else if constexpr (internal::traits<RhsType>::ColsAtCompileTime == 1)
+        {
+            internal::packed_symv(lhs.data(), N, rhsEval.data(), result.data());
+        }
+        else
+        {
+            result = (rhsEval.transpose() * lhs).transpose();
+        }
+        return result;
+    }
 
-        static inline EmbeddedCoreType Identity()
+    //! B * S for a packed symmetric S: a row vector is (S * B^T)^T, other matrices go to packed_rhs_product
+    template <typename LhsType, typename ScalarType, int N,
+              std::enable_if_t<internal::compatible_size<internal::traits<LhsType>::ColsAtCompileTime, N>::value, int> = 0>
+    constexpr auto operator*(const EmbeddedExprBase<LhsType> &lhs, const EmbeddedSymmetricType<ScalarType, N> &rhs)
+    {
+        using ResultType = typename internal::column_major_plain<LhsType>::type;
+        constexpr int Rows = internal::traits<LhsType>::RowsAtCompileTime;
+        internal::column_major_operand_t<LhsType> lhsEval(lhs.derived());
+        ResultType result = internal::plain_uninitialized<ResultType>(lhs.rows(), lhs.cols());
+        if (internal::is_constant_evaluated())
         {
-            EmbeddedCoreType result;
-            for (int i = 0; i < MaxRankAtCompileTime; i++)
+            for (int j = 0; j < N; ++j)
             {
-                result.data()[i * cols + i] = static_cast<ScalarType>(1);
+                for (int i = 0; i < lhsEval.rows(); ++i)
+                {
+                    ScalarType sum = 0;
+                    for (int k = 0; k < N; ++k)
+                    {
+                        sum += lhsEval(i, k) * rhs.coeff(k, j);
+                    }
+                    result(i, j) = sum;
+                }
             }
-            return result;
         }
-
-        static inline EmbeddedCoreType UnitX()
+        else if constexpr (Rows == 1)
         {
-            static_assert(RowsAtCompileTime >= 3 && ColsAtCompileTime == 1, "UnitX() only works for vectors longer than 3x1");
-            EmbeddedCoreType result;
-            result.x() = static_cast<ScalarType>(1.0);
-            return result;
+            internal::packed_symv(rhs.data(), N, lhsEval.data(), result.data());
+        }
+        else
+        {
+            internal::packed_rhs_product<ScalarType, Rows, N>(lhsEval.data(), lhsEval.outerStride(), rhs.data(), result.data(),
+                                                              result.outerStride(), lhsEval.rows());
         }
+        return result;
+    }
+
+    //! the product of two packed symmetric matrices is not symmetric, it is a plain matrix
+    template <typename ScalarType, int N>
+    constexpr auto operator*(const EmbeddedSymmetricType<ScalarType, N> &lhs, const EmbeddedSymmetricType<ScalarType, N> &rhs)
+    {
+        return lhs * typename internal::traits<EmbeddedSymmetricType<ScalarType, N>>::PlainObject(rhs);
+    }
+
+    // Matrix whose block structure is known at compile time, e.g. the transition matrix of an error-state
+    // Kalman filter made of identity, zero and a few dense 3x3 blocks. RowBlocks and ColBlocks are the
+    // BlockSizes of its block rows and columns, Pattern the BlockPattern giving the BlockKind of every block.
+    // Only the dense blocks are stored, and written through denseBlock<BI, BJ>(). Products with plain matrices
+    // skip the zero blocks and copy or add the operand for identity blocks, all chosen at compile time; the
+    // dense blocks go through the product kernels. In other expressions it reads like the plain matrix it
+    // evaluates to.
+    template <typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern>
+    class EmbeddedStructuredType : public EmbeddedExprBase<EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern>>
+    {
+    public:
+        using Structure = internal::block_structure<RowBlocks, ColBlocks, Pattern>;
+        using Scalar = ScalarType;
+        using PlainObject = typename internal::traits<EmbeddedStructuredType>::PlainObject;
+        static constexpr int DenseSize = Structure::DenseSize;
+
+        template <int BI, int BJ>
+        using DenseBlockType = EmbeddedCoreType<ScalarType, Structure::rowSize[BI], Structure::colSize[BJ]>;
+
+    protected:
+        ScalarType Elements[DenseSize > 0 ? DenseSize : 1];
+
+    public:
+        //! dense blocks filled with zeros
+        constexpr EmbeddedStructuredType() : Elements{} {}
+
+        //! leaves all elements uninitialized
+        explicit EmbeddedStructuredType(NoInit_t) {}
 
-        static inline EmbeddedCoreType UnitY()
+        //! the dense blocks of a matrix or expression, whose other blocks are assumed to be zero or identity
+        template <typename OtherDerived>
+        EmbeddedStructuredType(const EmbeddedExprBase<OtherDerived> &other)
         {
-            static_assert(RowsAtCompileTime >= 3 && ColsAtCompileTime == 1, "UnitY() only works for vectors longer than 3x1");
-            EmbeddedCoreType result;
-            result.y() = static_cast<ScalarType>(1.0);
-            return result;
+            *this = other;
         }
 
-        static inline EmbeddedCoreType UnitZ()
+        template <typename OtherDerived>
+        EmbeddedStructuredType &operator=(const EmbeddedExprBase<OtherDerived> &other)
         {
-            static_assert(RowsAtCompileTime >= 3 && ColsAtCompileTime == 1, "UnitZ() only works for vectors longer than 3x1");
-            EmbeddedCoreType result;
-            result.z() = static_cast<ScalarType>(1.0);
-            return result;
+            static_assert(internal::compatible_size<Structure::Rows, internal::traits<OtherDerived>::RowsAtCompileTime>::value &&
+                              internal::compatible_size<Structure::Cols, internal::traits<OtherDerived>::ColsAtCompileTime>::value,
+                          "assignment between matrices of different sizes");
+            typename internal::eval_selector<OtherDerived>::type source(other.derived());
+            internal::for_each_block<Structure>([&](auto bi, auto bj)
+                                                {
+                constexpr int BI = decltype(bi)::value, BJ = decltype(bj)::value;
+                if constexpr (Structure::kindOf(BI, BJ) == DenseBlock)
+                    denseBlock<BI, BJ>() = source.template block<Structure::rowSize[BI], Structure::colSize[BJ]>(Structure::rowOffset(BI), Structure::colOffset(BJ)); });
+            return *this;
         }
 
-        template <int subrows, int subcols>
-        inline EmbeddedRefType<Scalar, RowsAtCompileTime, ColsAtCompileTime> block(int startrows, int startcols)
+        constexpr int rows() const { return Structure::Rows; }
+        constexpr int cols() const { return Structure::Cols; }
+
+        //! a single coefficient, looking its block up at runtime, which products and assignments never do
+        constexpr ScalarType coeff(int row, int col) const
         {
-            return EmbeddedRefType<Scalar, RowsAtCompileTime, ColsAtCompileTime>(
-                *reinterpret_cast<Scalar(*)[RowsAtCompileTime * ColsAtCompileTime]>(this->data()),
-                subrows, subcols, startrows, startcols);
+            int bi = 0, bj = 0;
+            while (row >= Structure::rowOffset(bi + 1))
+                ++bi;
+            while (col >= Structure::colOffset(bj + 1))
+                ++bj;
+            const int i = row - Structure::rowOffset(bi), j = col - Structure::colOffset(bj);
+            const int kind = Structure::kindOf(bi, bj);
+            if (kind == DenseBlock)
+                return Elements[Structure::denseOffset(bi, bj) + j * Structure::rowSize[bi] + i];
+            return (kind == IdentityBlock && i == j) ? ScalarType(1) : ScalarType(0);
         }
 
-        inline EmbeddedRefType<Scalar, RowsAtCompileTime, ColsAtCompileTime> block(int startrows, int startcols, int subrows, int subcols)
+        constexpr ScalarType operator()(int row, int col) const
         {
-            return EmbeddedRefType<Scalar, RowsAtCompileTime, ColsAtCompileTime>(
-                *reinterpret_cast<Scalar(*)[RowsAtCompileTime * ColsAtCompileTime]>(this->data()),
-                subrows, subcols, startrows, startcols);
+            return coeff(row, col);
         }
 
-        inline EmbeddedRefType<Scalar, RowsAtCompileTime, ColsAtCompileTime> row(const int index)
+        //! the dense block (BI, BJ), stored column-major
+        template <int BI, int BJ>
+        inline EmbeddedMapType<DenseBlockType<BI, BJ>> denseBlock()
         {
-            return EmbeddedRefType<Scalar, RowsAtCompileTime, ColsAtCompileTime>(
-                *reinterpret_cast<Scalar(*)[RowsAtCompileTime * ColsAtCompileTime]>(this->data()),
-                1, ColsAtCompileTime, index, 0);
+            static_assert(Structure::kindOf(BI, BJ) == DenseBlock, "only dense blocks are stored");
+            return EmbeddedMapType<DenseBlockType<BI, BJ>>(Elements + Structure::denseOffset(BI, BJ));
         }
 
-        inline EmbeddedRefType<Scalar, RowsAtCompileTime, ColsAtCompileTime> col(const int index)
+        template <int BI, int BJ>
+        inline EmbeddedMapType<const DenseBlockType<BI, BJ>> denseBlock() const
         {
-            return EmbeddedRefType<Scalar, RowsAtCompileTime, ColsAtCompileTime>(
-                *reinterpret_cast<Scalar(*)[RowsAtCompileTime * ColsAtCompileTime]>(this->data()),
-                RowsAtCompileTime, 1, 0, index);
+            static_assert(Structure::kindOf(BI, BJ) == DenseBlock, "only dense blocks are stored");
+            return EmbeddedMapType<const DenseBlockType<BI, BJ>>(Elements + Structure::denseOffset(BI, BJ));
         }
 
-        inline EmbeddedCoreType inverse() const
+        //! the DenseSize coefficients of the dense blocks
+        constexpr ScalarType *data() { return Elements; }
+        constexpr const ScalarType *data() const { return Elements; }
+    };
+
+    namespace internal
+    {
+        template <typename T>
+        struct is_structured : std::false_type
         {
-            EmbeddedCoreType result;
+        };
 
-            if constexpr (RowsAtCompileTime == 2 && ColsAtCompileTime == 2)
-            {
-                ScalarType det = this->determinant();
-                if (abs(det) < FLOAT_EPSILON)
-                    return EmbeddedCoreType::Zero();
-                ScalarType invDet = (ScalarType)1.0 / det;
-                result(0, 0) = this->Elements[3] * invDet;
-                result(0, 1) = -this->Elements[2] * invDet;
-                result(1, 0) = -this->Elements[1] * invDet;
-                result(1, 1) = this->Elements[0] * invDet;
-            }
-            else if constexpr (RowsAtCompileTime == 3 && ColsAtCompileTime == 3)
-            {
-                ScalarType det = this->determinant();
-                if (abs(det) < FLOAT_EPSILON)
-                    return EmbeddedCoreType::Zero();
-                ScalarType invDet = (ScalarType)1.0 / det;
-                result(0, 0) = (this->Elements[4] * this->Elements[8] - this->Elements[5] * this->Elements[7]) * invDet;
-                result(0, 1) = (this->Elements[6] * this->Elements[5] - this->Elements[3] * this->Elements[8]) * invDet;
-                result(0, 2) = (this->Elements[3] * this->Elements[7] - this->Elements[6] * this->Elements[4]) * invDet;
+        template <typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern>
+        struct is_structured<EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern>> : std::true_type
+        {
+        };
 
-                result(1, 0) = (this->Elements[2] * this->Elements[7] - this->Elements[1] * this->Elements[8]) * invDet;
-                result(1, 1) = (this->Elements[0] * this->Elements[8] - this->Elements[2] * this->Elements[6]) * invDet;
-                result(1, 2) = (this->Elements[1] * this->Elements[6] - this->Elements[0] * this->Elements[7]) * invDet;
+        // plain result of S * rhs and lhs * S, with fixed sizes so that its blocks can be taken
+        template <typename T, int Rows, int Cols>
+        using structured_result_t = EmbeddedCoreType<T, Rows, Cols>;
+    }
 
-                result(2, 0) = (this->Elements[1] * this->Elements[5] - this->Elements[2] * this->Elements[4]) * invDet;
-                result(2, 1) = (this->Elements[2] * this->Elements[3] - this->Elements[0] * this->Elements[5]) * invDet;
-                result(2, 2) = (this->Elements[0] * this->Elements[4] - this->Elements[1] * this->Elements[3]) * invDet;
-            }
-            else
-            {
-                PartialPivLU<EmbeddedCoreType> lu(*this);
-                result = lu.inverse();
-            }
-            return result;
-        }
+    //! S * B for a structured S, see internal::structured_lhs_product
+    template <typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern, typename RhsType,
+              std::enable_if_t<!internal::is_structured<RhsType>::value, int> = 0>
+    inline auto operator*(const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &lhs, const EmbeddedExprBase<RhsType> &rhs)
+    {
+        using Structure = internal::block_structure<RowBlocks, ColBlocks, Pattern>;
+        static_assert(internal::traits<RhsType>::RowsAtCompileTime == Structure::Cols, "product between matrices of incompatible sizes");
+        using ResultType = internal::structured_result_t<ScalarType, Structure::Rows, internal::traits<RhsType>::ColsAtCompileTime>;
+        internal::column_major_operand_t<RhsType> rhsEval(rhs.derived());
+        ResultType result(NoInit);
+        internal::structured_lhs_product(result, lhs, rhsEval);
+        return result;
+    }
 
-        inline EmbeddedCoreType<ScalarType, 3, 1> eulerAngles(const int y = 2, const int p = 1, const int r = 0) const
-        {
-            // TODO: fix the first element to -PI/2 to PI/2
-            static_assert(RowsAtCompileTime == 3 && ColsAtCompileTime == 3);
-            EmbeddedCoreType<ScalarType, 3, 1> result;
+    //! B * S for a structured S, see internal::structured_rhs_product
+    template <typename LhsType, typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern,
+              std::enable_if_t<!internal::is_structured<LhsType>::value, int> = 0>
+    inline auto operator*(const EmbeddedExprBase<LhsType> &lhs, const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &rhs)
+    {
+        using Structure = internal::block_structure<RowBlocks, ColBlocks, Pattern>;
+        static_assert(internal::traits<LhsType>::ColsAtCompileTime == Structure::Rows, "product between matrices of incompatible sizes");
+        using ResultType = internal::structured_result_t<ScalarType, internal::traits<LhsType>::RowsAtCompileTime, Structure::Cols>;
+        internal::column_major_operand_t<LhsType> lhsEval(lhs.derived());
+        ResultType result(NoInit);
+        internal::structured_rhs_product(result, lhsEval, rhs);
+        return result;
+    }
+
+    //! B * S^T for a structured S, e.g. (F * P) * F^T or P * H^T, see internal::structured_transpose_product
+    template <typename LhsType, typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern,
+              std::enable_if_t<!internal::is_structured<LhsType>::value, int> = 0>
+    inline auto operator*(const EmbeddedExprBase<LhsType> &lhs,
+                          const EmbeddedTransposeType<EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern>> &rhs)
+    {
+        using Structure = internal::block_structure<RowBlocks, ColBlocks, Pattern>;
+        static_assert(internal::traits<LhsType>::ColsAtCompileTime == Structure::Cols, "product between matrices of incompatible sizes");
+        using ResultType = internal::structured_result_t<ScalarType, internal::traits<LhsType>::RowsAtCompileTime, Structure::Rows>;
+        internal::column_major_operand_t<LhsType> lhsEval(lhs.derived());
+        ResultType result(NoInit);
+        internal::structured_transpose_product(result, lhsEval, rhs.nestedExpression());
+        return result;
+    }
 
-            result(y) = atan2(this->Elements[5], this->Elements[8]);
-            result(p) = atan2(-this->Elements[2], sqrt(this->Elements[5] * this->Elements[5] + this->Elements[8] * this->Elements[8]));
-            result(r) = atan2(this->Elements[1], this->Elements[0]);
-            return result;
-        }
+    //! products of two structured matrices evaluate the right one
+    template <typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern, typename RhsType,
+              std::enable_if_t<internal::is_structured<RhsType>::value, int> = 0>
+    inline auto operator*(const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &lhs, const EmbeddedExprBase<RhsType> &rhs)
+    {
+        return lhs * typename internal::traits<RhsType>::PlainObject(rhs.derived());
+    }
 
-        template <typename T, int R1, int C1_R2, int C2>
-        friend EmbeddedCoreType<T, R1, C2> operator*(
-            const EmbeddedCoreType<T, R1, C1_R2> &lhs,
-            const EmbeddedCoreType<T, C1_R2, C2> &rhs);
+    template <typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern, typename RhsType>
+    inline auto operator*(const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &lhs, const EmbeddedTransposeType<RhsType> &rhs)
+    {
+        return lhs * typename internal::traits<EmbeddedTransposeType<RhsType>>::PlainObject(rhs);
+    }
 
-        inline EmbeddedCoreType<ScalarType, MaxDimAtCompileTime, MaxDimAtCompileTime> asDiagonal() const
-        {
-            static_assert(MaxRankAtCompileTime == 1);
+    //! with a packed symmetric matrix, e.g. F * P and P * H^T, the packed one is evaluated
+    template <typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern, int N>
+    inline auto operator*(const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &lhs, const EmbeddedSymmetricType<ScalarType, N> &rhs)
+    {
+        return lhs * typename internal::traits<EmbeddedSymmetricType<ScalarType, N>>::PlainObject(rhs);
+    }
 
-            EmbeddedCoreType<ScalarType, MaxDimAtCompileTime, MaxDimAtCompileTime> result;
-            for (int i = 0; i < MaxDimAtCompileTime; i++)
-            {
-                result(i, i) = this->Elements[i];
-            }
-            return result;
-        }
+    template <int N, typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern>
+    inline auto operator*(const EmbeddedSymmetricType<ScalarType, N> &lhs, const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &rhs)
+    {
+        return typename internal::traits<EmbeddedSymmetricType<ScalarType, N>>::PlainObject(lhs) * rhs;
+    }
 
-        bool isApprox(const EmbeddedCoreType &other, const ScalarType &epsilon = FLOAT_EPSILON) const
-        {
-            ScalarType L2_Dis = (*this - other).norm();
-            return L2_Dis <= epsilon;
-        }
+    template <int N, typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern>
+    inline auto operator*(const EmbeddedSymmetricType<ScalarType, N> &lhs,
+                          const EmbeddedTransposeType<EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern>> &rhs)
+    {
+        return typename internal::traits<EmbeddedSymmetricType<ScalarType, N>>::PlainObject(lhs) * rhs;
+    }
 
-        //! do nothing
-        inline EmbeddedCoreType eval()
-        {
-            return *this;
-        }
-    };
+    //! S + B, B + S, S - B and B - S: B is evaluated and S assigned to it block by block
+    template <typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern, typename RhsType>
+    inline auto operator+(const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &lhs, const EmbeddedExprBase<RhsType> &rhs)
+    {
+        typename internal::traits<EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern>>::PlainObject result(rhs.derived());
+        result += lhs;
+        return result;
+    }
 
-    template <typename T, int R1, int C1_R2, int C2>
-    EmbeddedCoreType<T, R1, C2> operator*(
-        const EmbeddedCoreType<T, R1, C1_R2> &lhs,
-        const EmbeddedCoreType<T, C1_R2, C2> &rhs)
+    template <typename LhsType, typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern,
+              std::enable_if_t<!internal::is_structured<LhsType>::value, int> = 0>
+    inline auto operator+(const EmbeddedExprBase<LhsType> &lhs, const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &rhs)
     {
-        EmbeddedCoreType<T, R1, C2> result;
-        if constexpr (R1 == 1 && C1_R2 == 1 && C2 == 1)
-        {
-            result(0) = lhs(0) * rhs(0);
-        }
-        else if constexpr (R1 == 2 && C1_R2 == 2 && C2 == 2)
-        {
-            __builtin_prefetch(&rhs(0), 0, 0);
-            result(0) = lhs(0) * rhs(0) + lhs(2) * rhs(1);
-            result(1) = lhs(1) * rhs(0) + lhs(3) * rhs(1);
-            result(2) = lhs(0) * rhs(2) + lhs(2) * rhs(3);
-            result(3) = lhs(1) * rhs(2) + lhs(3) * rhs(3);
-        }
-        else if constexpr (R1 == 3 && C1_R2 == 3 && C2 == 3)
-        {
-            __builtin_prefetch(&rhs(0), 0, 0);
-            result(0) = lhs(0) * rhs(0) + lhs(3) * rhs(1) + lhs(6) * rhs(2);
-            result(1) = lhs(1) * rhs(0) + lhs(4) * rhs(1) + lhs(7) * rhs(2);
-            result(2) = lhs(2) * rhs(0) + lhs(5) * rhs(1) + lhs(8) * rhs(2);
-            result(3) = lhs(0) * rhs(3) + lhs(3) * rhs(4) + lhs(6) * rhs(5);
-            result(4) = lhs(1) * rhs(3) + lhs(4) * rhs(4) + lhs(7) * rhs(5);
-            result(5) = lhs(2) * rhs(3) + lhs(5) * rhs(4) + lhs(8) * rhs(5);
-            result(6) = lhs(0) * rhs(6) + lhs(3) * rhs(7) + lhs(6) * rhs(8);
-            result(7) = lhs(1) * rhs(6) + lhs(4) * rhs(7) + lhs(7) * rhs(8);
-            result(8) = lhs(2) * rhs(6) + lhs(5) * rhs(7) + lhs(8) * rhs(8);
-        }
-        else if constexpr (R1 == 4 && C1_R2 == 4 && C2 == 4)
-        {
-            __builtin_prefetch(&rhs(0), 0, 0);
-            result(0) = lhs(0) * rhs(0) + lhs(4) * rhs(1) + lhs(8) * rhs(2) + lhs(12) * rhs(3);
-            result(1) = lhs(1) * rhs(0) + lhs(5) * rhs(1) + lhs(9) * rhs(2) + lhs(13) * rhs(3);
-            result(2) = lhs(2) * rhs(0) + lhs(6) * rhs(1) + lhs(10) * rhs(2) + lhs(14) * rhs(3);
-            result(3) = lhs(3) * rhs(0) + lhs(7) * rhs(1) + lhs(11) * rhs(2) + lhs(15) * rhs(3);
-            __builtin_prefetch(&rhs(4), 0, 0);
-            result(4) = lhs(0) * rhs(4) + lhs(4) * rhs(5) + lhs(8) * rhs(6) + lhs(12) * rhs(7);
-            result(5) = lhs(1) * rhs(4) + lhs(5) * rhs(5) + lhs(9) * rhs(6) + lhs(13) * rhs(7);
-            result(6) = lhs(2) * rhs(4) + lhs(6) * rhs(5) + lhs(10) * rhs(6) + lhs(14) * rhs(7);
-            result(7) = lhs(3) * rhs(4) + lhs(7) * rhs(5) + lhs(11) * rhs(6) + lhs(15) * rhs(7);
-            __builtin_prefetch(&rhs(8), 0, 0);
-            result(8) = lhs(0) * rhs(8) + lhs(4) * rhs(9) + lhs(8) * rhs(10) + lhs(12) * rhs(11);
-            result(9) = lhs(1) * rhs(8) + lhs(5) * rhs(9) + lhs(9) * rhs(10) + lhs(13) * rhs(11);
-            result(10) = lhs(2) * rhs(8) + lhs(6) * rhs(9) + lhs(10) * rhs(10) + lhs(14) * rhs(11);
-            result(11) = lhs(3) * rhs(8) + lhs(7) * rhs(9) + lhs(11) * rhs(10) + lhs(15) * rhs(11);
-            __builtin_prefetch(&rhs(12), 0, 0);
-            result(12) = lhs(0) * rhs(12) + lhs(4) * rhs(13) + lhs(8) * rhs(14) + lhs(12) * rhs(15);
-            result(13) = lhs(1) * rhs(12) + lhs(5) * rhs(13) + lhs(9) * rhs(14) + lhs(13) * rhs(15);
-            result(14) = lhs(2) * rhs(12) + lhs(6) * rhs(13) + lhs(10) * rhs(14) + lhs(14) * rhs(15);
-            result(15) = lhs(3) * rhs(12) + lhs(7) * rhs(13) + lhs(11) * rhs(14) + lhs(15) * rhs(15);
-        }
-        else
-        {
-            T sum;
-            for (int i = 0; i < R1; ++i)
-            {
-                for (int j = 0; j < C2; ++j)
-                {
-                    __builtin_prefetch(&rhs(i, j), 0, 0);
-                    sum = 0;
-                    for (int k = 0; k < C1_R2 - 1; k += 2)
-                    {
+        typename internal::traits<EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern>>::PlainObject result(lhs.derived());
+        result += rhs;
+        return result;
+    }
 
-                        sum += lhs(i, k) * rhs(k, j);
-                        sum += lhs(i, k + 1) * rhs(k + 1, j);
-                    }
-                    if constexpr ((C1_R2 % 2) == 1)
-                        sum += lhs(i, C1_R2 - 1) * rhs(C1_R2 - 1, j);
-                    result(i, j) = sum;
-                }
-            }
-        }
+    template <typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern, typename RhsType>
+    inline auto operator-(const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &lhs, const EmbeddedExprBase<RhsType> &rhs)
+    {
+        typename internal::traits<EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern>>::PlainObject result(-rhs.derived());
+        result += lhs;
         return result;
     }
 
+    template <typename LhsType, typename ScalarType, typename RowBlocks, typename ColBlocks, typename Pattern,
+              std::enable_if_t<!internal::is_structured<LhsType>::value, int> = 0>
+    inline auto operator-(const EmbeddedExprBase<LhsType> &lhs, const EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern> &rhs)
+    {
+        typename internal::traits<EmbeddedStructuredType<ScalarType, RowBlocks, ColBlocks, Pattern>>::PlainObject result(lhs.derived());
+        result -= rhs;
+        return result;
+    }
     // Partial Specialize Quaternion
     template <typename ScalarType>
     class EmbeddedQuaternion : public EmbeddedCoreType<ScalarType, 4, 1>
@@ -745,27 +6313,28 @@ namespace EmbeddedTypes
     public:
         using BaseType = EmbeddedCoreType<ScalarType, 4, 1>;
 
-        EmbeddedQuaternion() : BaseType() {}
+        constexpr EmbeddedQuaternion() : BaseType() {}
 
-        EmbeddedQuaternion(const ScalarType w, const ScalarType x, const ScalarType y, const ScalarType z)
-        {
-            this->Elements[0] = x;
-            this->Elements[1] = y;
-            this->Elements[2] = z;
-            this->Elements[3] = w; // w
-        }
+        //! leaves all elements uninitialized
+        explicit EmbeddedQuaternion(NoInit_t) : BaseType(NoInit) {}
 
-        EmbeddedQuaternion(const BaseType &other)
-        {
-            this->Elements[0] = other(0);
-            this->Elements[1] = other(1);
-            this->Elements[2] = other(2);
-            this->Elements[3] = other(3); // w
-        }
+        // stored as x, y, z, w
+        constexpr EmbeddedQuaternion(const ScalarType w, const ScalarType x, const ScalarType y, const ScalarType z)
+            : BaseType(x, y, z, w) {}
+
+        constexpr EmbeddedQuaternion(const BaseType &other)
+            : BaseType(other) {}
+
+        constexpr EmbeddedQuaternion(const EmbeddedQuaternion<ScalarType> &other)
+            : BaseType(other) {}
 
-        EmbeddedQuaternion(const EmbeddedQuaternion<ScalarType> &other)
+        template <typename OtherDerived>
+        constexpr EmbeddedQuaternion(const EmbeddedExprBase<OtherDerived> &other)
             : BaseType(other) {}
 
+        EmbeddedQuaternion &operator=(const EmbeddedQuaternion &other) = default;
+        using BaseType::operator=;
+
         EmbeddedQuaternion(const EmbeddedCoreType<ScalarType, 3, 3> &rot)
         {
             ScalarType trace = rot.trace();
@@ -807,13 +6376,11 @@ namespace EmbeddedTypes
             this->normalize();
         }
 
-        ~EmbeddedQuaternion() {};
-
-        inline ScalarType &w()
+        constexpr ScalarType &w()
         {
             return this->Elements[3];
         }
-        inline const ScalarType &w() const
+        constexpr const ScalarType &w() const
         {
             return this->Elements[3];
         }
@@ -828,9 +6395,9 @@ namespace EmbeddedTypes
             return *reinterpret_cast<const EmbeddedCoreType<ScalarType, 3, 1> *>(&this->Elements[0]);
         }
 
-        inline EmbeddedQuaternion conjugate() const
+        constexpr EmbeddedQuaternion conjugate() const
         {
-            EmbeddedQuaternion result;
+            EmbeddedQuaternion result = internal::plain_uninitialized<EmbeddedQuaternion>();
             result.w() = this->w();
             result.x() = -this->x();
             result.y() = -this->y();
@@ -840,7 +6407,7 @@ namespace EmbeddedTypes
 
         inline EmbeddedQuaternion inverse() const
         {
-            EmbeddedQuaternion result;
+            EmbeddedQuaternion result(NoInit);
             result.w() = this->w();
             result.x() = -this->x();
             result.y() = -this->y();
@@ -849,9 +6416,9 @@ namespace EmbeddedTypes
             return result;
         }
 
-        friend inline EmbeddedQuaternion operator*(const EmbeddedQuaternion &left, const EmbeddedQuaternion &right)
+        friend constexpr EmbeddedQuaternion operator*(const EmbeddedQuaternion &left, const EmbeddedQuaternion &right)
         {
-            EmbeddedQuaternion result;
+            EmbeddedQuaternion result = internal::plain_uninitialized<EmbeddedQuaternion>();
             result.w() = left.w() * right.w() - left.x() * right.x() - left.y() * right.y() - left.z() * right.z();
             result.x() = left.w() * right.x() + left.x() * right.w() + left.y() * right.z() - left.z() * right.y();
             result.y() = left.w() * right.y() - left.x() * right.z() + left.y() * right.w() + left.z() * right.x();
@@ -859,13 +6426,13 @@ namespace EmbeddedTypes
             return result;
         }
 
-        inline EmbeddedCoreType<ScalarType, 3, 3> toRotationMatrix() const
+        constexpr EmbeddedCoreType<ScalarType, 3, 3> toRotationMatrix() const
         {
             ScalarType w = this->w();
             ScalarType x = this->x();
             ScalarType y = this->y();
             ScalarType z = this->z();
-            EmbeddedCoreType<ScalarType, 3, 3> result;
+            EmbeddedCoreType<ScalarType, 3, 3> result = internal::plain_uninitialized<EmbeddedCoreType<ScalarType, 3, 3>>();
             result(0, 0) = (ScalarType)1.0f - (ScalarType)2.0f * (y * y + z * z);
             result(0, 1) = (ScalarType)2.0f * (x * y - w * z);
             result(0, 2) = (ScalarType)2.0f * (x * z + w * y);
@@ -883,7 +6450,7 @@ namespace EmbeddedTypes
         inline EmbeddedCoreType<ScalarType, 3, 1> toEulerAngles() const
         {
             const ScalarType singularityThreshold = 0.5f - FLOAT_EPSILON;
-            EmbeddedCoreType<ScalarType, 3, 1> result;
+            EmbeddedCoreType<ScalarType, 3, 1> result(NoInit);
             ScalarType singularity = this->w() * this->y() - this->z() * this->x();
 
             if (singularity < -singularityThreshold)
@@ -907,7 +6474,7 @@ namespace EmbeddedTypes
             return result;
         }
 
-        inline void setIdentity()
+        constexpr void setIdentity()
         {
             this->w() = (ScalarType)1;
             this->x() = (ScalarType)0;
@@ -916,7 +6483,7 @@ namespace EmbeddedTypes
             return;
         }
 
-        static inline EmbeddedQuaternion Identity()
+        static constexpr EmbeddedQuaternion Identity()
         {
             EmbeddedQuaternion result;
             result.w() = (ScalarType)1;
@@ -924,140 +6491,517 @@ namespace EmbeddedTypes
         }
     };
 
+    // LU decomposition with partial pivoting over the columns, A * P = L * U, for square matrices. L and U
+    // share one matrix like in LAPACK: L, with the pivots on its diagonal, in the lower triangle and the unit
+    // upper triangular U above it. P is kept as the column swapped with column k at every step k. With
+    // Ref<MatrixType> as MatrixType the decomposition overwrites the referenced matrix and only stores the
+    // swaps, e.g. PartialPivLU<Ref<Matrix<double, 24, 24>>> lu(A).
     template <class MatrixType>
     class PartialPivLU
     {
+    public:
+        using PlainMatrix = typename internal::traits<MatrixType>::PlainObject;
+
     protected:
-        using ScalarType = typename MatrixType::Scalar;
-        MatrixType L, U, P; // L is lower triangular, U is upper triangular, P is permutation matrix
-        ScalarType Q[MatrixType::ColsAtCompileTime];
+        using ScalarType = typename internal::traits<MatrixType>::Scalar;
+        MatrixType LU;
+        int pivots[PlainMatrix::MaxColsAtCompileTime];
+        int n; // the matrices are n x n, a runtime size for bounded matrices
+
+        // zero-filled n x n matrix, a fixed-size matrix already is after default construction
+        static PlainMatrix zeroMatrix(int size)
+        {
+            if constexpr (internal::traits<PlainMatrix>::SizeAtCompileTime == Dynamic)
+                return PlainMatrix(size, size);
+            else
+                return PlainMatrix();
+        }
+
+        auto sizeIndex() const
+        {
+            return internal::unrolled_size<PlainMatrix::RowsAtCompileTime>(n);
+        }
 
     public:
-        PartialPivLU(const MatrixType &matrix)
+        PartialPivLU(const MatrixType &matrix) : LU(matrix), n(matrix.rows())
         {
             //! currently only support square matrix
-            static_assert(MatrixType::RowsAtCompileTime == MatrixType::ColsAtCompileTime, "only support square matrix");
-            this->L;
-            this->U = matrix;
-            // initialize Q
-            for (int i = 0; i < MatrixType::RowsAtCompileTime; ++i)
+            static_assert(internal::compatible_size<PlainMatrix::RowsAtCompileTime, PlainMatrix::ColsAtCompileTime>::value, "only support square matrix");
+            internal::lu_in_place(LU, pivots, sizeIndex());
+        }
+
+        //! the lower triangular factor, with the pivots on its diagonal
+        PlainMatrix matrixL() const
+        {
+            PlainMatrix result = zeroMatrix(n);
+            for (int j = 0; j < n; ++j)
+            {
+                for (int i = j; i < n; ++i)
+                {
+                    result(i, j) = LU(i, j);
+                }
+            }
+            return result;
+        }
+
+        //! the unit upper triangular factor
+        PlainMatrix matrixU() const
+        {
+            PlainMatrix result = zeroMatrix(n);
+            for (int j = 0; j < n; ++j)
             {
-                Q[i] = i;
+                for (int i = 0; i < j; ++i)
+                {
+                    result(i, j) = LU(i, j);
+                }
+                result(j, j) = 1;
             }
-            decompose(this->U);
+            return result;
+        }
+
+        //! L and U in one matrix, L in the lower triangle and U strictly above it
+        const MatrixType &matrixLU() const
+        {
+            return LU;
         }
 
-        MatrixType matrixL()
+        //! the column swapped with column k at step k, for every k
+        const int *transpositions() const
         {
-            return this->L;
+            return pivots;
         }
 
-        MatrixType matrixU()
+        //! the permutation matrix P with A * P = L * U
+        PlainMatrix permutationP() const
         {
-            return this->U;
+            PlainMatrix result = zeroMatrix(n);
+            int columns[PlainMatrix::MaxColsAtCompileTime];
+            for (int k = 0; k < n; ++k)
+            {
+                columns[k] = k;
+            }
+            for (int k = 0; k < n; ++k)
+            {
+                const int tmp = columns[k];
+                columns[k] = columns[pivots[k]];
+                columns[pivots[k]] = tmp;
+            }
+            for (int k = 0; k < n; ++k)
+            {
+                result(columns[k], k) = 1;
+            }
+            return result;
         }
 
         ScalarType determinant() const
         {
             ScalarType det = 1.0;
-            for (int i = 0; i < MatrixType::RowsAtCompileTime; ++i)
+            for (int i = 0; i < n; ++i)
             {
-                det *= this->L(i, i);
+                det *= LU(i, i);
+                // every pivot swap flips the sign
+                if (pivots[i] != i)
+                    det = -det;
             }
             return det;
         }
 
-        MatrixType inverse()
+        //! A^-1 = P * U^-1 * L^-1, with the column swaps undone on the rows of U^-1 * L^-1. Unrolled sizes solve
+        //! with U on the columns of L^-1, larger ones invert U too and multiply with the product kernels.
+        PlainMatrix inverse() const
         {
-            MatrixType invL;
-            MatrixType invU;
-            MatrixType result;
-
-            invL(0) = 1.0 / this->L(0);
-            for (int i = 1; i < MatrixType::RowsAtCompileTime; ++i)
+            auto result = internal::lower_inverse<false>(LU, sizeIndex());
+            if constexpr (std::is_same<decltype(sizeIndex()), int>::value)
             {
-                invL(i, i) = 1.0 / this->L(i, i);
-                for (int j = 0; j < i; ++j)
+                const auto inverseU = internal::upper_inverse<true>(LU, n);
+                result = inverseU * result;
+            }
+            else
+            {
+                for (int c = 0; c < n; ++c)
                 {
-                    for (int k = j; k < i; ++k)
-                        invL(i, j) -= this->L(i, k) * invL(k, j) * invL(i, i);
+                    ScalarType *column = &result(0, c);
+                    internal::upper_solve_in_place<true>(LU, column, sizeIndex());
                 }
             }
+            for (int i = n - 1; i >= 0; --i)
+            {
+                if (pivots[i] != i)
+                    result.row(i).swap(result.row(pivots[i]));
+            }
+            return result;
+        }
 
-            for (int i = MatrixType::RowsAtCompileTime - 1; i >= 0; --i)
+        //! x with A * x = b, without forming the inverse: forward substitution with L, back substitution with the
+        //! unit upper triangular U, then the column swaps of the pivoting undone on the rows of x
+        template <typename RhsDerived>
+        auto solve(const EmbeddedExprBase<RhsDerived> &b) const
+        {
+            static_assert(internal::compatible_size<PlainMatrix::RowsAtCompileTime, internal::traits<RhsDerived>::RowsAtCompileTime>::value,
+                          "solve needs as many rows as the matrix");
+            typename internal::column_major_plain<RhsDerived>::type x(b.derived());
+            for (int c = 0; c < x.cols(); ++c)
             {
-                invU(i, i) = 1.0;
-                for (int j = i + 1; j < MatrixType::ColsAtCompileTime; ++j)
+                ScalarType *column = &x(0, c);
+                internal::lower_solve_in_place<false>(LU, column, sizeIndex());
+                internal::upper_solve_in_place<true>(LU, column, sizeIndex());
+                for (int i = n - 1; i >= 0; --i)
                 {
-                    for (int k = i + 1; k < j; ++k)
-                        invU(i, j) -= this->U(i, k) * invU(k, j);
-                    invU(i, j) -= this->U(i, j);
+                    if (pivots[i] != i)
+                    {
+                        const ScalarType tmp = column[i];
+                        column[i] = column[pivots[i]];
+                        column[pivots[i]] = tmp;
+                    }
                 }
             }
+            return x;
+        }
+    };
+
+    // Cholesky factorization A = L * L^T of a symmetric positive definite matrix, from its lower triangle. L is
+    // kept in a matrix of the same type, with zeros above the diagonal. Fixed sizes up to 8 are unrolled at
+    // compile time, larger column-major ones computed column by column with the contiguous axpy kernel. About
+    // half the work of PartialPivLU and no pivot search. info() is NumericalIssue when the matrix is not
+    // positive definite, the factor then being unusable.
+    template <class MatrixType>
+    class LLT
+    {
+    public:
+        using Scalar = typename MatrixType::Scalar;
+
+    protected:
+        using ScalarType = Scalar;
+        static constexpr int Size = MatrixType::RowsAtCompileTime;
+        MatrixType L;
+        ComputationInfo status;
+        int n; // the matrices are n x n, a runtime size for bounded matrices
+
+        // the size as an integral constant when the loops over it are unrolled
+        auto sizeIndex() const
+        {
+            return internal::unrolled_size<Size>(n);
+        }
+
+    public:
+        LLT(const MatrixType &matrix) : L(matrix), status(Success), n(matrix.rows())
+        {
+            static_assert(internal::compatible_size<MatrixType::RowsAtCompileTime, MatrixType::ColsAtCompileTime>::value, "only support square matrix");
+            if (!internal::llt_in_place(L, sizeIndex()))
+                status = NumericalIssue;
+        }
+
+        ComputationInfo info() const
+        {
+            return status;
+        }
+
+        //! the lower triangular factor, zeros above the diagonal
+        const MatrixType &matrixL() const
+        {
+            return L;
+        }
+
+        //! x with A * x = b, by forward substitution with L and back substitution with L^T on every column of b
+        template <typename RhsDerived>
+        auto solve(const EmbeddedExprBase<RhsDerived> &b) const
+        {
+            static_assert(internal::compatible_size<Size, internal::traits<RhsDerived>::RowsAtCompileTime>::value, "solve needs as many rows as the matrix");
+            typename internal::column_major_plain<RhsDerived>::type x(b.derived());
+            for (int c = 0; c < x.cols(); ++c)
+            {
+                internal::lower_solve_in_place<false>(L, &x(0, c), sizeIndex());
+                internal::lower_adjoint_solve_in_place<false>(L, &x(0, c), sizeIndex());
+            }
+            return x;
+        }
+
+        //! A^-1 = L^-T * L^-1, L^-1 by forward substitution and the product by the product kernels
+        MatrixType inverse() const
+        {
+            const auto inverseL = internal::lower_inverse<false>(L, sizeIndex());
+            return inverseL.transpose() * inverseL;
+        }
+
+        //! the square of the product of the diagonal of L
+        ScalarType determinant() const
+        {
+            ScalarType det = 1;
+            for (int j = 0; j < n; ++j)
+            {
+                det *= L(j, j);
+            }
+            return det * det;
+        }
+
+        //! log(det(A)), twice the sum of the logarithms of the diagonal of L, which neither overflows nor underflows
+        ScalarType logDeterminant() const
+        {
+            ScalarType sum = 0;
+            for (int j = 0; j < n; ++j)
+            {
+                sum += log(L(j, j));
+            }
+            return 2 * sum;
+        }
+    };
+
+    // A = L * D * L^T factorization of a symmetric matrix, from its lower triangle, with a unit lower triangular L
+    // and a diagonal D. Like LLT without square roots, and it also factors symmetric matrices that are not
+    // positive definite, as long as no pivot D(j) is zero: there is no pivoting. L is kept below the diagonal of
+    // one matrix of the same type, D on it. info() is NumericalIssue on a zero pivot.
+    template <class MatrixType>
+    class LDLT
+    {
+    public:
+        using Scalar = typename MatrixType::Scalar;
+        using DiagonalType = EmbeddedCoreType<Scalar, MatrixType::RowsAtCompileTime, 1, DefaultStorage, MatrixType::MaxRowsAtCompileTime, 1>;
+
+    protected:
+        using ScalarType = Scalar;
+        static constexpr int Size = MatrixType::RowsAtCompileTime;
+        MatrixType LD;
+        ComputationInfo status;
+        int n; // the matrices are n x n, a runtime size for bounded matrices
+
+        auto sizeIndex() const
+        {
+            return internal::unrolled_size<Size>(n);
+        }
+
+    public:
+        LDLT(const MatrixType &matrix) : LD(matrix), status(Success), n(matrix.rows())
+        {
+            static_assert(internal::compatible_size<MatrixType::RowsAtCompileTime, MatrixType::ColsAtCompileTime>::value, "only support square matrix");
+            if (!internal::ldlt_in_place(LD, sizeIndex()))
+                status = NumericalIssue;
+        }
 
-            result = invU * invL;
+        ComputationInfo info() const
+        {
+            return status;
+        }
 
-            // swap rows according to P
-            for (int i = MatrixType::RowsAtCompileTime - 1; i >= 0; --i)
+        //! the unit lower triangular factor
+        MatrixType matrixL() const
+        {
+            MatrixType result = LD;
+            for (int j = 0; j < n; ++j)
             {
-                if (Q[i] != i)
-                    result.row(i).swap(result.row(Q[i]));
+                result(j, j) = 1;
             }
             return result;
         }
 
-    private:
-        void decompose(MatrixType &matrix)
+        //! the diagonal of D
+        DiagonalType vectorD() const
+        {
+            DiagonalType result = internal::plain_uninitialized<DiagonalType>(n, 1);
+            for (int j = 0; j < n; ++j)
+            {
+                result(j) = LD(j, j);
+            }
+            return result;
+        }
+
+        //! L below the diagonal, D on it, zeros above
+        const MatrixType &matrixLDLT() const
+        {
+            return LD;
+        }
+
+        //! true when every pivot is positive, i.e. the matrix is positive definite
+        bool isPositive() const
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                if (!(LD(j, j) > 0))
+                    return false;
+            }
+            return true;
+        }
+
+        //! x with A * x = b: forward substitution with L, division by D and back substitution with L^T
+        template <typename RhsDerived>
+        auto solve(const EmbeddedExprBase<RhsDerived> &b) const
         {
-            for (int k = 0; k < MatrixType::ColsAtCompileTime; ++k)
+            static_assert(internal::compatible_size<Size, internal::traits<RhsDerived>::RowsAtCompileTime>::value, "solve needs as many rows as the matrix");
+            typename internal::column_major_plain<RhsDerived>::type x(b.derived());
+            for (int c = 0; c < x.cols(); ++c)
             {
-                // find pivoting column index
-                int pivotIndex = k;
-                for (int j = k + 1; j < MatrixType::ColsAtCompileTime; ++j)
+                ScalarType *column = &x(0, c);
+                internal::lower_solve_in_place<true>(LD, column, sizeIndex());
+                for (int j = 0; j < n; ++j)
                 {
-                    if (fabs(matrix(k, j)) > fabs(matrix(k, pivotIndex)))
-                    {
-                        pivotIndex = j;
-                    }
+                    column[j] /= LD(j, j);
                 }
+                internal::lower_adjoint_solve_in_place<true>(LD, column, sizeIndex());
+            }
+            return x;
+        }
+
+        //! A^-1 = L^-T * D^-1 * L^-1
+        MatrixType inverse() const
+        {
+            const auto inverseL = internal::lower_inverse<true>(LD, sizeIndex());
+            auto scaled = inverseL;
+            for (int j = 0; j < n; ++j)
+            {
+                scaled.row(j) *= ScalarType(1) / LD(j, j);
+            }
+            return inverseL.transpose() * scaled;
+        }
+
+        //! the product of the pivots
+        ScalarType determinant() const
+        {
+            ScalarType det = 1;
+            for (int j = 0; j < n; ++j)
+            {
+                det *= LD(j, j);
+            }
+            return det;
+        }
+
+        //! log(det(A)) for a positive definite matrix, the sum of the logarithms of the pivots
+        ScalarType logDeterminant() const
+        {
+            ScalarType sum = 0;
+            for (int j = 0; j < n; ++j)
+            {
+                sum += log(LD(j, j));
+            }
+            return sum;
+        }
+    };
+
+    // Cholesky factorization S = L * L^T of a packed symmetric positive definite matrix, L being packed in the
+    // lower triangle like S, in place. Column j is updated with the packed columns before it, each a
+    // contiguous axpy down rows [j, N), then divided by the square root of its diagonal. info() is
+    // NumericalIssue when the matrix is not positive definite, the factor then being unusable.
+    template <typename ScalarType, int N>
+    class LLT<EmbeddedSymmetricType<ScalarType, N>>
+    {
+    public:
+        using MatrixType = EmbeddedSymmetricType<ScalarType, N>;
+        using DenseType = EmbeddedCoreType<ScalarType, N, N>;
+
+    protected:
+        MatrixType L; // the factor in the packed lower triangle
+        ComputationInfo status;
 
-                if (pivotIndex != k)
+    public:
+        LLT(const MatrixType &matrix) : L(matrix), status(Success)
+        {
+            decompose();
+        }
+
+        ComputationInfo info() const
+        {
+            return status;
+        }
+
+        //! the lower triangular factor as a plain matrix, zeros above the diagonal
+        DenseType matrixL() const
+        {
+            DenseType result;
+            for (int j = 0; j < N; ++j)
+            {
+                for (int i = j; i < N; ++i)
                 {
-                    matrix.col(k).swap(matrix.col(pivotIndex));
-                    Q[k] = Q[pivotIndex];
+                    result(i, j) = L.coeff(i, j);
                 }
+            }
+            return result;
+        }
 
-                this->L(k, k) = 1.0;
-                this->L.block(k, k, MatrixType::ColsAtCompileTime - k, 1) = matrix.block(k, k, MatrixType::ColsAtCompileTime - k, 1);
-                ScalarType invPivot = 1.0 / matrix(k, k);
-                for (int i = k + 1; i < MatrixType::ColsAtCompileTime; ++i)
+        //! the factor in packed storage, its lower triangle being L
+        const MatrixType &matrixLLT() const
+        {
+            return L;
+        }
+
+        //! x with S * x = b, by forward substitution with L and back substitution with L^T on every column of b
+        template <typename RhsDerived>
+        auto solve(const EmbeddedExprBase<RhsDerived> &b) const
+        {
+            static_assert(internal::compatible_size<N, internal::traits<RhsDerived>::RowsAtCompileTime>::value, "solve needs N rows");
+            typename internal::column_major_plain<RhsDerived>::type x(b.derived());
+            const ScalarType *data = L.data();
+            for (int c = 0; c < x.cols(); ++c)
+            {
+                ScalarType *column = &x(0, c);
+                for (int j = 0; j < N; ++j)
                 {
-                    for (int j = k + 1; j < MatrixType::RowsAtCompileTime; ++j)
-                    {
-                        matrix(j, i) -= matrix(k, i) * matrix(j, k) * invPivot;
-                    }
-                    matrix(k, i) *= invPivot;
+                    const ScalarType *factor = data + MatrixType::packedIndex(j, j);
+                    column[j] /= factor[0];
+                    internal::axpy_contiguous(column + j + 1, factor + 1, -column[j], N - j - 1);
+                }
+                for (int j = N - 1; j >= 0; --j)
+                {
+                    const ScalarType *factor = data + MatrixType::packedIndex(j, j);
+                    column[j] = (column[j] - internal::dot_contiguous(factor + 1, column + j + 1, N - j - 1)) / factor[0];
                 }
             }
+            return x;
+        }
+
+        //! the square of the product of the diagonal of L
+        ScalarType determinant() const
+        {
+            ScalarType det = 1;
+            for (int j = 0; j < N; ++j)
+            {
+                det *= L.coeff(j, j);
+            }
+            return det * det;
+        }
+
+        //! log(det(S)), twice the sum of the logarithms of the diagonal of L
+        ScalarType logDeterminant() const
+        {
+            ScalarType sum = 0;
+            for (int j = 0; j < N; ++j)
+            {
+                sum += log(L.coeff(j, j));
+            }
+            return 2 * sum;
+        }
 
-            for (int k = 0; k < MatrixType::ColsAtCompileTime; ++k)
+    private:
+        void decompose()
+        {
+            ScalarType *data = L.data();
+            for (int j = 0; j < N; ++j)
             {
-                for (int i = k; i < MatrixType::RowsAtCompileTime; ++i)
+                ScalarType *column = data + MatrixType::packedIndex(j, j);
+                // L(j, k), followed by rows (j, N) of column k
+                const ScalarType *previous = data + j;
+                for (int k = 0; k < j; ++k)
                 {
-                    if (i == k)
-                        matrix(i, k) = 1;
-                    else
-                        matrix(i, k) = 0;
+                    internal::axpy_contiguous(column, previous, -*previous, N - j);
+                    previous += N - k - 1;
+                }
+                if (!(column[0] > 0))
+                {
+                    status = NumericalIssue;
+                    return;
+                }
+                const ScalarType diagonal = sqrt(column[0]);
+                const ScalarType inverse = 1 / diagonal;
+                column[0] = diagonal;
+                for (int i = 1; i < N - j; ++i)
+                {
+                    column[i] *= inverse;
                 }
             }
-            return;
         }
     };
 
     template <typename ScalarType>
     static inline EmbeddedQuaternion<ScalarType> AngleAxis(const ScalarType &angle, const EmbeddedCoreType<ScalarType, 3, 1> &axis)
     {
-        EmbeddedQuaternion<ScalarType> result;
+        EmbeddedQuaternion<ScalarType> result(NoInit);
         result.w() = cos(angle * 0.5);
         result.vec() = sin(angle * 0.5) * axis;
         return result;
@@ -1068,12 +7012,33 @@ namespace EmbeddedMath
 {
     using namespace EmbeddedTypes;
 
-    template <typename T, int rows, int cols>
-    using Matrix = EmbeddedCoreType<T, rows, cols>;
+    template <typename T, int rows, int cols, int options = DefaultStorage, int maxRows = rows, int maxCols = cols>
+    using Matrix = EmbeddedCoreType<T, rows, cols, options, maxRows, maxCols>;
 
     template <typename T>
     using Quaternion = EmbeddedQuaternion<T>;
 
+    template <typename T, int N>
+    using SymmetricMatrix = EmbeddedSymmetricType<T, N>;
+
+    template <typename T, typename RowBlocks, typename ColBlocks, typename Pattern>
+    using StructuredMatrix = EmbeddedStructuredType<T, RowBlocks, ColBlocks, Pattern>;
+
+    template <typename MatrixType, typename StrideType = EmbeddedStride<0, 0>>
+    using Map = EmbeddedMapType<MatrixType, StrideType>;
+
+    template <typename MatrixType>
+    using Ref = EmbeddedMatrixRef<MatrixType>;
+
+    template <int OuterStrideAtCompileTime, int InnerStrideAtCompileTime>
+    using Stride = EmbeddedStride<OuterStrideAtCompileTime, InnerStrideAtCompileTime>;
+
+    template <int Value = Dynamic>
+    using OuterStride = EmbeddedOuterStride<Value>;
+
+    template <int Value = Dynamic>
+    using InnerStride = EmbeddedInnerStride<Value>;
+
     using Vector2f = EmbeddedCoreType<float, 2, 1>;
     using Vector3f = EmbeddedCoreType<float, 3, 1>;
     using Vector4f = EmbeddedCoreType<float, 4, 1>;
@@ -5,6 +5,7 @@
 #include <Eigen/Dense>
 #include <chrono>
 #include <iostream>
+#include <utility>
 
 TEST_CASE("Benchmark with Eigen")
 {
@@ -60,4 +61,173 @@ TEST_CASE("Benchmark with Eigen")
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
     std::cout << "Time taken by function: " << duration.count() << " microseconds" << std::endl;
-}
\ No newline at end of file
+}
+
+// keeps the compiler from eliding the stores into the temporary
+static inline void escape(void *p)
+{
+    __asm__ volatile("" : : "g"(p) : "memory");
+}
+
+template <int N>
+void benchmarkTemporary(int iterations)
+{
+    using MatrixN = EmbeddedMath::Matrix<double, N, N>;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; ++it)
+    {
+        MatrixN result;
+        escape(result.data());
+        for (int i = 0; i < N * N; ++i)
+            result(i) = i;
+        escape(result.data());
+    }
+    auto zeroFilled = std::chrono::high_resolution_clock::now() - start;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; ++it)
+    {
+        MatrixN result(EmbeddedMath::NoInit);
+        escape(result.data());
+        for (int i = 0; i < N * N; ++i)
+            result(i) = i;
+        escape(result.data());
+    }
+    auto noInit = std::chrono::high_resolution_clock::now() - start;
+
+    std::cout << N << "x" << N << " double temporary: zero-filled "
+              << std::chrono::duration_cast<std::chrono::microseconds>(zeroFilled).count() << " us, NoInit "
+              << std::chrono::duration_cast<std::chrono::microseconds>(noInit).count() << " us, "
+              << sizeof(MatrixN) << " bytes of stores saved per temporary" << std::endl;
+}
+
+template <int... Sizes>
+void benchmarkTemporaries(std::integer_sequence<int, Sizes...>, int iterations)
+{
+    (benchmarkTemporary<Sizes>(iterations), ...);
+}
+
+TEST_CASE("Benchmark zero-filled vs NoInit temporaries")
+{
+    benchmarkTemporaries(std::integer_sequence<int, 3, 4, 6, 9, 12, 15, 18, 24>(), 200000);
+}
+
+template <int N>
+void benchmarkProduct(int iterations)
+{
+    using MatrixN = EmbeddedMath::Matrix<float, N, N>;
+    using EigenMatrixN = Eigen::Matrix<float, N, N>;
+    MatrixN A, B, C;
+    EigenMatrixN D, E, F;
+    for (int i = 0; i < N * N; ++i)
+    {
+        A(i) = D(i) = 0.001f * static_cast<float>(i % 7);
+        B(i) = E(i) = 0.002f * static_cast<float>(i % 5);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; ++it)
+    {
+        escape(A.data());
+        C = A * B;
+        escape(C.data());
+    }
+    auto blocked = std::chrono::high_resolution_clock::now() - start;
+
+    // the column loop used for these sizes before the blocked kernel
+    start = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; ++it)
+    {
+        escape(A.data());
+        EmbeddedTypes::internal::matmul_runtime(A.data(), N, B, C.data(), N, N, N, N);
+        escape(C.data());
+    }
+    auto columnLoop = std::chrono::high_resolution_clock::now() - start;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; ++it)
+    {
+        escape(D.data());
+        F.noalias() = D * E;
+        escape(F.data());
+    }
+    auto eigen = std::chrono::high_resolution_clock::now() - start;
+
+    std::cout << N << "x" << N << " float product: blocked "
+              << std::chrono::duration_cast<std::chrono::microseconds>(blocked).count() << " us, column loop "
+              << std::chrono::duration_cast<std::chrono::microseconds>(columnLoop).count() << " us, Eigen "
+              << std::chrono::duration_cast<std::chrono::microseconds>(eigen).count() << " us" << std::endl;
+}
+
+template <int... Sizes>
+void benchmarkProducts(std::integer_sequence<int, Sizes...>, int iterations)
+{
+    (benchmarkProduct<Sizes>(iterations), ...);
+}
+
+TEST_CASE("Benchmark medium-size products")
+{
+    benchmarkProducts(std::integer_sequence<int, 9, 15, 24, 45, 60, 64>(), 2000);
+}
+
+template <int N>
+void benchmarkLU(int iterations)
+{
+    using MatrixN = EmbeddedMath::Matrix<double, N, N>;
+    using BoundedN = EmbeddedMath::Matrix<double, EmbeddedMath::Dynamic, EmbeddedMath::Dynamic, EmbeddedMath::DefaultStorage, N, N>;
+    using EigenMatrixN = Eigen::Matrix<double, N, N>;
+    MatrixN A;
+    BoundedN B(N, N);
+    EigenMatrixN D;
+    unsigned state = 777u + N;
+    for (int i = 0; i < N * N; ++i)
+    {
+        state = state * 1103515245u + 12345u;
+        A(i) = B(i) = D(i) = static_cast<double>((state >> 8) % 2000) / 1000.0 - 1.0;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; ++it)
+    {
+        escape(A.data());
+        EmbeddedMath::PartialPivLU<MatrixN> lu(A);
+        escape(&lu);
+    }
+    auto blocked = std::chrono::high_resolution_clock::now() - start;
+
+    // bounded matrices keep the column-by-column elimination used for these sizes before the blocked one
+    start = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; ++it)
+    {
+        escape(B.data());
+        EmbeddedMath::PartialPivLU<BoundedN> lu(B);
+        escape(&lu);
+    }
+    auto unblocked = std::chrono::high_resolution_clock::now() - start;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iterations; ++it)
+    {
+        escape(D.data());
+        Eigen::PartialPivLU<EigenMatrixN> lu(D);
+        escape(&lu);
+    }
+    auto eigen = std::chrono::high_resolution_clock::now() - start;
+
+    std::cout << N << "x" << N << " double LU: blocked "
+              << std::chrono::duration_cast<std::chrono::microseconds>(blocked).count() << " us, unblocked "
+              << std::chrono::duration_cast<std::chrono::microseconds>(unblocked).count() << " us, Eigen "
+              << std::chrono::duration_cast<std::chrono::microseconds>(eigen).count() << " us" << std::endl;
+}
+
+template <int... Sizes>
+void benchmarkLUs(std::integer_sequence<int, Sizes...>, int iterations)
+{
+    (benchmarkLU<Sizes>(iterations), ...);
+}
+
+TEST_CASE("Benchmark LU decomposition by size")
+{
+    benchmarkLUs(std::integer_sequence<int, 9, 16, 24, 32, 45, 64>(), 2000);
+}
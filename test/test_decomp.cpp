@@ -67,4 +67,308 @@ TEST_CASE("test decomposition")
     printf("%f %f %f %f\n", invC(1,0), invC(1,1), invC(1,2), invC(1,3));
     printf("%f %f %f %f\n", invC(2,0), invC(2,1), invC(2,2), invC(2,3));
     printf("%f %f %f %f\n", invC(3,0), invC(3,1), invC(3,2), invC(3,3));
-}
\ No newline at end of file
+}
+template <typename T, int N, int Options>
+void checkSolve()
+{
+    using namespace EmbeddedMath;
+    using Square = Matrix<T, N, N, Options>;
+    Square A;
+    Matrix<T, N, 3> B;
+    for (int j = 0; j < N; ++j)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            A(i, j) = static_cast<T>((i * 5 + j * 3) % 7) - static_cast<T>(3);
+        }
+        // a dominant diagonal keeps the triangles well conditioned, the first row still pivots
+        A(j, j) += static_cast<T>(2 * N);
+        B(j, 0) = static_cast<T>(j);
+        B(j, 1) = static_cast<T>(1);
+        B(j, 2) = static_cast<T>(N - 2 * j);
+    }
+    A(0, N - 1) = static_cast<T>(4 * N);
+    const T eps = sizeof(T) == 4 ? static_cast<T>(1e-3) : static_cast<T>(1e-9);
+
+    const PartialPivLU<Square> lu(A);
+    CHECK((A * lu.solve(B)).isApprox(B, eps));
+    const Matrix<T, N, 1> b = B.col(2);
+    CHECK((A * lu.solve(b)).isApprox(b, eps));
+
+    // triangular solves, into a new matrix or in place
+    const Square L = A.template triangularView<Lower>();
+    const Square U = A.template triangularView<UnitUpper>();
+    CHECK((L * A.template triangularView<Lower>().solve(B)).isApprox(B, eps));
+    CHECK((U * A.template triangularView<UnitUpper>().solve(B)).isApprox(B, eps));
+    Matrix<T, N, 3, RowMajor> X = B;
+    A.template triangularView<Lower>().solveInPlace(X);
+    CHECK((L * X).isApprox(B, eps));
+}
+
+template <typename T, int N, int Options>
+void checkCholesky()
+{
+    using namespace EmbeddedMath;
+    using Square = Matrix<T, N, N, Options>;
+    Square A;
+    Matrix<T, N, 2> b;
+    for (int j = 0; j < N; ++j)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            A(i, j) = static_cast<T>((i * 7 + j * 13) % 11) / static_cast<T>(11) - static_cast<T>(0.5);
+        }
+        b(j, 0) = static_cast<T>(j);
+        b(j, 1) = static_cast<T>(1);
+    }
+    const Square S = A * A.transpose() + Square::Identity();
+    const T eps = sizeof(T) == 4 ? static_cast<T>(1e-3) : static_cast<T>(1e-9);
+
+    const LLT<Square> llt(S);
+    CHECK(llt.info() == Success);
+    const Square L = llt.matrixL();
+    CHECK(L(0, N - 1) == static_cast<T>(0));
+    CHECK((L * L.transpose()).isApprox(S, eps));
+    CHECK((S * llt.solve(b)).isApprox(b, eps));
+    CHECK((S * llt.inverse()).isApprox(Square::Identity(), eps));
+
+    const LDLT<Square> ldlt = S.ldlt();
+    CHECK(ldlt.info() == Success);
+    CHECK(ldlt.isPositive());
+    Square D = Square::Zero();
+    for (int j = 0; j < N; ++j)
+    {
+        D(j, j) = ldlt.vectorD()(j);
+    }
+    const Square unitL = ldlt.matrixL();
+    CHECK(unitL(0, 0) == static_cast<T>(1));
+    CHECK((unitL * D * unitL.transpose()).isApprox(S, eps));
+    CHECK((S * ldlt.solve(b)).isApprox(b, eps));
+    CHECK((S * ldlt.inverse()).isApprox(Square::Identity(), eps));
+
+    const T det = PartialPivLU<Square>(S).determinant();
+    CHECK(llt.determinant() == doctest::Approx(det).epsilon(1e-4));
+    CHECK(ldlt.determinant() == doctest::Approx(det).epsilon(1e-4));
+    CHECK(llt.logDeterminant() == doctest::Approx(log(det)).epsilon(1e-4));
+    CHECK(ldlt.logDeterminant() == doctest::Approx(log(det)).epsilon(1e-4));
+}
+
+TEST_CASE("test cholesky")
+{
+    using namespace EmbeddedMath;
+    // unrolled sizes
+    checkCholesky<double, 2, DefaultStorage>();
+    checkCholesky<float, 3, DefaultStorage>();
+    checkCholesky<double, 6, RowMajor>();
+    // column kernels, and loops over coefficients for row-major storage
+    checkCholesky<double, 9, DefaultStorage>();
+    checkCholesky<double, 24, DefaultStorage>();
+    checkCholesky<float, 15, RowMajor>();
+
+    // a bounded matrix holding 4x4
+    Matrix<double, Dynamic, Dynamic, DefaultStorage, 6, 6> bounded(4, 4);
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            bounded(i, j) = (i == j) ? 4.0 : 1.0 / (1 + i + j);
+        }
+    }
+    Matrix<double, Dynamic, 1, DefaultStorage, 6, 1> rhs(4, 1);
+    for (int i = 0; i < 4; ++i)
+    {
+        rhs(i) = i;
+    }
+    CHECK((bounded * bounded.llt().solve(rhs)).isApprox(rhs, 1e-12));
+    CHECK((bounded * bounded.ldlt().solve(rhs)).isApprox(rhs, 1e-12));
+    CHECK(bounded.llt().determinant() == doctest::Approx(bounded.determinant()));
+
+    // symmetric but indefinite: LDLT still factors it
+    Matrix3d indefinite = Matrix3d::Identity();
+    indefinite(1, 1) = -2.0;
+    indefinite(2, 0) = 0.5;
+    indefinite(0, 2) = 0.5;
+    CHECK(indefinite.llt().info() == NumericalIssue);
+    const LDLT<Matrix3d> ldlt(indefinite);
+    CHECK(ldlt.info() == Success);
+    CHECK(!ldlt.isPositive());
+    CHECK((indefinite * ldlt.solve(Vector3d(1.0, 2.0, 3.0))).isApprox(Vector3d(1.0, 2.0, 3.0), 1e-12));
+    CHECK(Matrix3d::Constant(1.0).ldlt().info() == NumericalIssue);
+}
+
+TEST_CASE("test solves")
+{
+    using namespace EmbeddedMath;
+    // unrolled sizes
+    checkSolve<double, 2, DefaultStorage>();
+    checkSolve<float, 3, DefaultStorage>();
+    checkSolve<double, 6, RowMajor>();
+    // column kernels, and loops over coefficients for row-major storage
+    checkSolve<double, 15, DefaultStorage>();
+    checkSolve<float, 12, RowMajor>();
+
+    // in place on blocks of larger matrices
+    Matrix<double, 6, 6> A = Matrix<double, 6, 6>::Identity();
+    A(4, 3) = 2.0;
+    A(5, 3) = -1.0;
+    A(5, 4) = 0.5;
+    A(3, 3) = 2.0;
+    Matrix<double, 6, 2> B = Matrix<double, 6, 2>::Constant(1.0);
+    A.block<3, 3>(3, 3).triangularView<Lower>().solveInPlace(B.block<3, 2>(3, 0));
+    CHECK(B(0, 0) == 1.0);
+    CHECK(B(3, 1) == 0.5);
+    CHECK(B(4, 1) == 0.0);
+    CHECK(B(5, 1) == 1.5);
+}
+
+TEST_CASE("test compact lu")
+{
+    using namespace EmbeddedMath;
+    using Matrix24d = Matrix<double, 24, 24>;
+    Matrix24d A;
+    for (int j = 0; j < 24; ++j)
+    {
+        for (int i = 0; i < 24; ++i)
+        {
+            A(i, j) = static_cast<double>((i * 5 + j * 11) % 13) / 13.0 - 0.5 + ((i == j) ? 1.0 : 0.0);
+        }
+    }
+
+    // L and U share one matrix, the permutation is a list of column swaps
+    const PartialPivLU<Matrix24d> lu(A);
+    const Matrix24d L = lu.matrixL();
+    const Matrix24d U = lu.matrixU();
+    CHECK((A * lu.permutationP()).isApprox(L * U, 1e-9));
+    CHECK(lu.matrixLU()(3, 2) == L(3, 2));
+    CHECK(lu.matrixLU()(2, 3) == U(2, 3));
+    CHECK(U(5, 5) == 1.0);
+    CHECK(sizeof(lu) < sizeof(Matrix24d) + 24 * sizeof(int) + 16);
+    bool swapped = false;
+    for (int k = 0; k < 24; ++k)
+    {
+        CHECK(lu.transpositions()[k] >= k);
+        swapped = swapped || lu.transpositions()[k] != k;
+    }
+    CHECK(swapped);
+
+    // in place through a Ref: A itself is overwritten with L and U
+    Matrix24d B = A;
+    const PartialPivLU<Ref<Matrix24d>> inplace(B);
+    CHECK(sizeof(inplace) < 200);
+    CHECK(B == lu.matrixLU());
+    CHECK(inplace.determinant() == doctest::Approx(lu.determinant()));
+    Matrix<double, 24, 1> b;
+    for (int i = 0; i < 24; ++i)
+    {
+        b(i) = i;
+    }
+    CHECK((A * inplace.solve(b)).isApprox(b, 1e-9));
+    CHECK((A * inplace.inverse()).isApprox(Matrix24d::Identity(), 1e-9));
+
+    // unrolled sizes
+    Matrix3d C;
+    C(0, 0) = 1.0;
+    C(0, 1) = 4.0;
+    C(0, 2) = 2.0;
+    C(1, 0) = 3.0;
+    C(1, 1) = 1.0;
+    C(1, 2) = 0.0;
+    C(2, 0) = 2.0;
+    C(2, 1) = 2.0;
+    C(2, 2) = 5.0;
+    const PartialPivLU<Matrix3d> lu3(C);
+    CHECK(lu3.transpositions()[0] == 1);
+    CHECK(lu3.matrixL()(0, 0) == 4.0);
+    CHECK((C * lu3.permutationP()).isApprox(lu3.matrixL() * lu3.matrixU(), 1e-12));
+    CHECK(lu3.determinant() == doctest::Approx(-47.0));
+}
+
+// the blocked decomposition of fixed sizes against the unblocked one of a bounded matrix with the same coefficients
+template <typename T, int N>
+void checkBlockedLU(T tolerance)
+{
+    using namespace EmbeddedMath;
+    using MatrixN = Matrix<T, N, N>;
+    using BoundedN = Matrix<T, Dynamic, Dynamic, DefaultStorage, N, N>;
+    MatrixN A;
+    BoundedN B(N, N);
+    unsigned state = 12345u + N;
+    for (int j = 0; j < N; ++j)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            state = state * 1103515245u + 12345u;
+            A(i, j) = B(i, j) = static_cast<T>((state >> 8) % 2000) / T(1000) - T(1);
+        }
+    }
+
+    const PartialPivLU<MatrixN> blocked(A);
+    const PartialPivLU<BoundedN> unblocked(B);
+    for (int k = 0; k < N; ++k)
+    {
+        CHECK(blocked.transpositions()[k] == unblocked.transpositions()[k]);
+        for (int i = 0; i < N; ++i)
+        {
+            CHECK(blocked.matrixLU()(i, k) == doctest::Approx(unblocked.matrixLU()(i, k)).epsilon(tolerance));
+        }
+    }
+    CHECK((A * blocked.permutationP()).isApprox(blocked.matrixL() * blocked.matrixU(), tolerance));
+    CHECK((A * blocked.inverse()).isApprox(MatrixN::Identity(), tolerance));
+}
+
+TEST_CASE("test blocked lu")
+{
+    // whole panels, a last panel of one row, and several panels with a shorter last one
+    checkBlockedLU<double, 16>(1e-9);
+    checkBlockedLU<double, 9>(1e-9);
+    checkBlockedLU<double, 45>(1e-9);
+    checkBlockedLU<double, 64>(1e-9);
+    checkBlockedLU<float, 30>(1e-3f);
+}
+
+TEST_CASE("test packed cholesky")
+{
+    using namespace EmbeddedMath;
+    Matrix<double, 24, 24> A;
+    for (int j = 0; j < 24; ++j)
+    {
+        for (int i = 0; i < 24; ++i)
+        {
+            A(i, j) = static_cast<double>((i * 7 + j * 13) % 11) / 11.0 - 0.5;
+        }
+    }
+    const Matrix<double, 24, 24> P = A * A.transpose() + Matrix<double, 24, 24>::Identity();
+    const SymmetricMatrix<double, 24> packed(P);
+
+    LLT<SymmetricMatrix<double, 24>> llt(packed);
+    CHECK(llt.info() == Success);
+    const Matrix<double, 24, 24> L = llt.matrixL();
+    CHECK(L(0, 1) == 0.0);
+    CHECK((L * L.transpose()).isApprox(P, 1e-9));
+
+    Matrix<double, 24, 2> b;
+    for (int i = 0; i < 24; ++i)
+    {
+        b(i, 0) = i;
+        b(i, 1) = 1.0;
+    }
+    const Matrix<double, 24, 2> x = packed.llt().solve(b);
+    CHECK((P * x).isApprox(b, 1e-9));
+
+    Matrix2d small;
+    small(0, 0) = 4.0;
+    small(1, 0) = 2.0;
+    small(0, 1) = 2.0;
+    small(1, 1) = 5.0;
+    LLT<SymmetricMatrix<double, 2>> llt2(small);
+    CHECK(llt2.determinant() == doctest::Approx(16.0));
+    CHECK(llt2.logDeterminant() == doctest::Approx(log(16.0)));
+    CHECK(llt2.matrixLLT()(0, 0) == 2.0);
+
+    // not positive definite
+    Matrix2d indefinite = Matrix2d::Constant(2.0);
+    indefinite(0, 0) = 1.0;
+    indefinite(1, 1) = 1.0;
+    LLT<SymmetricMatrix<double, 2>> llt3(indefinite);
+    CHECK(llt3.info() == NumericalIssue);
+}
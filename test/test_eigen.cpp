@@ -72,7 +72,7 @@ TEST_CASE("Test with Eigen")
     CHECK(isApprox(eigen_v2, embedded_v2));
     CHECK(isApprox(eigen_m1, embedded_m1));
     CHECK(isApprox(eigen_m1, embedded_m1.eval()));
-    CHECK(isApprox(Eigen::Matrix3d(eigen_m1.transpose()), embedded_m1.transpose()));
+    CHECK(isApprox(Eigen::Matrix3d(eigen_m1.transpose()), embedded_m1.transpose().eval()));
     CHECK(isApprox(Eigen::Matrix3d(eigen_m1.inverse()), embedded_m1.inverse()));
 
     // Test Matrix multiplication
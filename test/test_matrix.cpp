@@ -2,6 +2,8 @@
 #include "doctest.h"
 
 #include <EmbeddedMath.hpp>
+#include <algorithm>
+#include <limits>
 
 template <typename T>
 bool isApprox(T a, T b, T epsilon = 0.0001)
@@ -20,6 +22,12 @@ TEST_CASE("test Vector")
     CHECK(v1(0) == 0.0f); // Default value should be 0
     CHECK(v1(1) == 0.0f); // Default value should be 0
 
+    // Test 1.1: NoInit constructor, every element written afterwards
+    Vector2f v0(NoInit);
+    v0(0) = 1.0f;
+    v0(1) = 2.0f;
+    CHECK(v0 == Vector2f(1.0f, 2.0f));
+
     // Test 2: Scalar constructor
     Vector2f v2(5.0f); // Initialize with value 5
     CHECK(v2(0) == 5.0f);
@@ -391,4 +399,1436 @@ TEST_CASE("Matrix4f")
     }
 
     // Add other tests like Inverse, Transpose, etc.
-}
\ No newline at end of file
+}
+TEST_CASE("test expression templates")
+{
+    using namespace EmbeddedMath;
+
+    Matrix3f P = Matrix3f::Identity();
+    Matrix3f F;
+    Matrix3f Q = Matrix3f::Ones();
+    for (int i = 0; i < 9; i++)
+    {
+        F(i) = static_cast<float>(i);
+    }
+    float dt = 0.5f;
+
+    // fused expression with a product operand
+    Matrix3f R = P + dt * (F * P) - Q;
+    for (int i = 0; i < 9; i++)
+    {
+        float expected = P(i) + dt * F(i) - Q(i);
+        CHECK(R(i) == expected);
+    }
+
+    // negation and scalar division
+    Matrix3f N = -F / 2.0f;
+    CHECK(N(4) == -2.0f);
+    CHECK(N(8) == -4.0f);
+
+    // in-place compound assignment from an expression
+    Matrix3f S = Matrix3f::Zero();
+    S += F * 2.0f + P;
+    CHECK(S(0) == 1.0f);
+    CHECK(S(1) == 2.0f);
+    S -= F + F;
+    CHECK(S(1) == 0.0f);
+    CHECK(S(4) == 1.0f);
+
+    // coefficient-wise operations
+    Vector3f a(1.0f, -4.0f, 9.0f);
+    Vector3f b(2.0f, 2.0f, 3.0f);
+    Vector3f c = a.cwiseProduct(b);
+    CHECK(c == Vector3f(2.0f, -8.0f, 27.0f));
+    CHECK(a.cwiseQuotient(b) == Vector3f(0.5f, -2.0f, 3.0f));
+    CHECK(a.cwiseAbs() == Vector3f(1.0f, 4.0f, 9.0f));
+    CHECK(a.cwiseAbs().cwiseSqrt() == Vector3f(1.0f, 2.0f, 3.0f));
+    CHECK(a.cwiseMin(b) == Vector3f(1.0f, -4.0f, 3.0f));
+    CHECK(a.cwiseMax(b) == Vector3f(2.0f, 2.0f, 9.0f));
+
+    // reductions run on the expression directly
+    CHECK((a + b).sum() == 13.0f);
+    CHECK((a - b).squaredNorm() == 1.0f + 36.0f + 36.0f);
+    CHECK((a * 2.0f).dot(b) == 2.0f * a.dot(b));
+    CHECK((a + b).isApprox(b + a));
+
+    // assignment of an expression into a block
+    Matrix4f T = Matrix4f::Identity();
+    T.block<3, 3>(0, 0) = P * 2.0f - Q;
+    CHECK(T(0, 0) == 1.0f);
+    CHECK(T(0, 1) == -1.0f);
+    CHECK(T(3, 3) == 1.0f);
+    CHECK(T(0, 3) == 0.0f);
+}
+
+template <typename T, int R, int C, int Options>
+void fillPseudoRandom(EmbeddedMath::Matrix<T, R, C, Options> &m, unsigned int seed)
+{
+    for (int i = 0; i < R * C; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        m(i) = static_cast<T>((seed >> 8) % 20001) / static_cast<T>(997) - static_cast<T>(10);
+    }
+}
+
+// with FMA the compiler may contract the scalar reference kernels, so only compare bit for bit without it
+template <typename T, int R, int C>
+bool isSameResult(const EmbeddedMath::Matrix<T, R, C> &a, const EmbeddedMath::Matrix<T, R, C> &b)
+{
+#if defined(__FMA__) || defined(__ARM_FEATURE_FMA)
+    return a.isApprox(b, static_cast<T>(1e-4));
+#else
+    return memcmp(a.data(), b.data(), sizeof(a)) == 0;
+#endif
+}
+
+template <typename T>
+void checkSmallProductKernels()
+{
+    using namespace EmbeddedMath;
+
+    for (unsigned int seed = 1; seed < 64; seed++)
+    {
+        Matrix<T, 3, 3> A3, B3;
+        Matrix<T, 3, 1> v3;
+        Matrix<T, 4, 4> A4, B4;
+        Matrix<T, 4, 1> v4;
+        fillPseudoRandom(A3, seed);
+        fillPseudoRandom(B3, seed + 101);
+        fillPseudoRandom(v3, seed + 202);
+        fillPseudoRandom(A4, seed + 303);
+        fillPseudoRandom(B4, seed + 404);
+        fillPseudoRandom(v4, seed + 505);
+
+        // the dispatched (possibly SIMD) kernels must match the portable ones bit for bit
+        Matrix<T, 3, 3> C3 = A3 * B3, C3ref;
+        EmbeddedTypes::internal::matmul3x3_scalar(A3.data(), B3.data(), C3ref.data());
+        CHECK(isSameResult(C3, C3ref));
+
+        Matrix<T, 3, 1> w3 = A3 * v3, w3ref;
+        EmbeddedTypes::internal::matvec3_scalar(A3.data(), v3.data(), w3ref.data());
+        CHECK(isSameResult(w3, w3ref));
+
+        Matrix<T, 4, 4> C4 = A4 * B4, C4ref;
+        EmbeddedTypes::internal::matmul4x4_scalar(A4.data(), B4.data(), C4ref.data());
+        CHECK(isSameResult(C4, C4ref));
+
+        Matrix<T, 4, 1> w4 = A4 * v4, w4ref;
+        EmbeddedTypes::internal::matvec4_scalar(A4.data(), v4.data(), w4ref.data());
+        CHECK(isSameResult(w4, w4ref));
+    }
+}
+
+template <typename T, int R, int K, int C, int LhsOptions = EmbeddedMath::DefaultStorage, int RhsOptions = EmbeddedMath::DefaultStorage>
+void checkProductShape()
+{
+    using namespace EmbeddedMath;
+    Matrix<T, R, K, LhsOptions> a;
+    Matrix<T, K, C, RhsOptions> b;
+    fillPseudoRandom(a, static_cast<unsigned>(R * 100 + K * 10 + C));
+    fillPseudoRandom(b, static_cast<unsigned>(C * 100 + K * 10 + R));
+
+    // FMA contraction and the split sums of the matrix-vector kernels may change the last bits, up to an ulp
+    // of partial sums of K products of magnitude 100
+    const T tolerance = std::max(static_cast<T>(1e-4), static_cast<T>(K * 100) * std::numeric_limits<T>::epsilon());
+    Matrix<T, R, C, LhsOptions> c = a * b;
+    Matrix<T, R, C> acc = Matrix<T, R, C>::Ones();
+    acc.noalias() -= static_cast<T>(2) * a * b;
+    for (int j = 0; j < C; j++)
+    {
+        for (int i = 0; i < R; i++)
+        {
+            T sum = 0;
+            for (int k = 0; k < K; k++)
+            {
+                sum += a(i, k) * b(k, j);
+            }
+            CHECK(isApprox<T>(c(i, j), sum, tolerance));
+            CHECK(isApprox<T>(acc(i, j), static_cast<T>(1) - static_cast<T>(2) * sum, tolerance));
+        }
+    }
+}
+
+template <typename T>
+void checkProductShapes()
+{
+    using namespace EmbeddedMath;
+    checkProductShape<T, 3, 3, 1>();
+    checkProductShape<T, 3, 4, 3>();
+    checkProductShape<T, 4, 3, 4>();
+    checkProductShape<T, 5, 5, 5>();
+    checkProductShape<T, 6, 6, 6>();
+    checkProductShape<T, 6, 6, 1>();
+    checkProductShape<T, 6, 3, 6>();
+    checkProductShape<T, 7, 2, 8>();
+    checkProductShape<T, 8, 8, 8>();
+    checkProductShape<T, 1, 5, 4>();
+    checkProductShape<T, 5, 1, 4>();
+    checkProductShape<T, 9, 7, 10>();
+    checkProductShape<T, 6, 6, 6, RowMajor, RowMajor>();
+    checkProductShape<T, 4, 3, 5, RowMajor, RowMajor>();
+    checkProductShape<T, 5, 4, 3, RowMajor, DefaultStorage>();
+    checkProductShape<T, 5, 4, 3, DefaultStorage, RowMajor>();
+    checkProductShape<T, 5, 1, 4, RowMajor, RowMajor>();
+    checkProductShape<T, 6, 5, 7, Padded, Padded>();
+    checkProductShape<T, 10, 9, 11, RowMajor, RowMajor>();
+    checkProductShape<T, 15, 15, 15>();
+    checkProductShape<T, 17, 13, 11>();
+    checkProductShape<T, 24, 24, 1>();
+    checkProductShape<T, 45, 45, 45>();
+    checkProductShape<T, 64, 64, 64>();
+    checkProductShape<T, 15, 15, 15, RowMajor, RowMajor>();
+    checkProductShape<T, 18, 15, 9, RowMajor, DefaultStorage>();
+    checkProductShape<T, 15, 12, 10, Padded, Padded>();
+}
+
+template <typename T, int N, int M>
+void checkMatrixVectorProduct()
+{
+    using namespace EmbeddedMath;
+    Matrix<T, N, M> a;
+    Matrix<T, M, 1> x;
+    Matrix<T, N, 1> v;
+    fillPseudoRandom(a, static_cast<unsigned>(N * 10 + M));
+    fillPseudoRandom(x, static_cast<unsigned>(M * 10 + N));
+    fillPseudoRandom(v, static_cast<unsigned>(N + M));
+    const Matrix<T, 1, N> r = v.transpose();
+
+    const T tolerance = std::max(static_cast<T>(1e-4), static_cast<T>((N > M ? N : M) * 100) * std::numeric_limits<T>::epsilon());
+    Matrix<T, N, 1> y = a * x;
+    Matrix<T, 1, M> z = v.transpose() * a;
+    Matrix<T, 1, M> zPlain = r * a;
+    Matrix<T, M, 1> zTransposed = a.transpose() * v;
+    Matrix<T, 1, M> acc = Matrix<T, 1, M>::Ones();
+    acc.noalias() -= static_cast<T>(2) * v.transpose() * a;
+    for (int i = 0; i < N; i++)
+    {
+        T sum = 0;
+        for (int k = 0; k < M; k++)
+        {
+            sum += a(i, k) * x(k);
+        }
+        CHECK(isApprox<T>(y(i), sum, tolerance));
+    }
+    for (int j = 0; j < M; j++)
+    {
+        T sum = 0;
+        for (int k = 0; k < N; k++)
+        {
+            sum += v(k) * a(k, j);
+        }
+        CHECK(isApprox<T>(z(j), sum, tolerance));
+        CHECK(isApprox<T>(zPlain(j), sum, tolerance));
+        CHECK(isApprox<T>(zTransposed(j), sum, tolerance));
+        CHECK(isApprox<T>(acc(j), static_cast<T>(1) - static_cast<T>(2) * sum, tolerance));
+    }
+}
+
+template <typename T>
+void checkMatrixVectorProducts()
+{
+    checkMatrixVectorProduct<T, 3, 3>();
+    checkMatrixVectorProduct<T, 6, 5>();
+    checkMatrixVectorProduct<T, 2, 15>();
+    checkMatrixVectorProduct<T, 15, 15>();
+    checkMatrixVectorProduct<T, 21, 9>();
+    checkMatrixVectorProduct<T, 45, 45>();
+}
+
+TEST_CASE("test fixed-size product kernels")
+{
+    checkSmallProductKernels<float>();
+    checkSmallProductKernels<double>();
+    checkProductShapes<float>();
+    checkProductShapes<double>();
+    checkMatrixVectorProducts<float>();
+    checkMatrixVectorProducts<double>();
+}
+
+template <typename T, int R, int C>
+void checkPacketLoops()
+{
+    using namespace EmbeddedMath;
+    Matrix<T, R, C> a, b;
+    fillPseudoRandom(a, 7u);
+    fillPseudoRandom(b, 11u);
+
+    // element-wise results must match the scalar computation exactly, tail included
+    Matrix<T, R, C> c = a + b * static_cast<T>(2) - a / static_cast<T>(4);
+    for (int i = 0; i < R * C; i++)
+    {
+        CHECK(c(i) == a(i) + b(i) * static_cast<T>(2) - a(i) / static_cast<T>(4));
+    }
+
+    Matrix<T, R, C> d = a;
+    d *= static_cast<T>(3);
+    d -= b;
+    d += a;
+    for (int i = 0; i < R * C; i++)
+    {
+        // the reference may be contracted into FMA on targets that have it
+        CHECK(isApprox<T>(d(i), a(i) * static_cast<T>(3) - b(i) + a(i), static_cast<T>(1e-4)));
+    }
+
+    // reductions may be reordered by the packet width
+    T dot = 0, sum = 0;
+    for (int i = 0; i < R * C; i++)
+    {
+        dot += a(i) * b(i);
+        sum += a(i);
+    }
+    CHECK(isApprox<T>(a.dot(b), dot, static_cast<T>(1e-3)));
+    CHECK(isApprox<T>(a.sum(), sum, static_cast<T>(1e-3)));
+    CHECK(isApprox<T>(a.norm(), static_cast<T>(sqrt(a.dot(a))), static_cast<T>(1e-3)));
+
+    Matrix<T, R, C> n = a;
+    n.normalize();
+    CHECK(isApprox<T>(n.norm(), static_cast<T>(1), static_cast<T>(1e-5)));
+
+    CHECK(a == a);
+    Matrix<T, R, C> e = a;
+    e(R * C - 1) += static_cast<T>(1);
+    CHECK_FALSE(a == e);
+    e = a;
+    e(0) += static_cast<T>(1);
+    CHECK_FALSE(a == e);
+    CHECK(a.isApprox(a + b * static_cast<T>(0)));
+
+    Matrix<T, R, C> z = a;
+    z.setZero();
+    CHECK(z.squaredNorm() == static_cast<T>(0));
+    CHECK(Matrix<T, R, C>::Ones().sum() == static_cast<T>(R * C));
+}
+
+TEST_CASE("test packet loops")
+{
+    checkPacketLoops<float, 3, 1>();
+    checkPacketLoops<float, 7, 1>();
+    checkPacketLoops<float, 5, 5>();
+    checkPacketLoops<double, 3, 1>();
+    checkPacketLoops<double, 6, 6>();
+}
+
+// every operation on a padded or aligned matrix must agree with the default layout
+template <typename T, int R, int C, int Options>
+void checkStorageOptions()
+{
+    using namespace EmbeddedMath;
+    using Plain = Matrix<T, R, C>;
+    using Custom = Matrix<T, R, C, Options>;
+    using PlainSquare = Matrix<T, R, R>;
+    using CustomSquare = Matrix<T, R, R, Options>;
+
+    Plain a, b;
+    PlainSquare m;
+    fillPseudoRandom(a, 3u);
+    fillPseudoRandom(b, 5u);
+    fillPseudoRandom(m, 13u);
+    Custom pa(a), pb(b);
+    CustomSquare pm(m);
+
+    CHECK(reinterpret_cast<uintptr_t>(pa.data()) % EmbeddedTypes::internal::traits<Custom>::Alignment == 0);
+    CHECK(pa.outerStride() >= (Custom::IsRowMajor ? C : R));
+    for (int j = 0; j < C; j++)
+    {
+        for (int i = 0; i < R; i++)
+        {
+            const int index = Custom::IsRowMajor ? i * pa.outerStride() + j : j * pa.outerStride() + i;
+            CHECK(pa.data()[index] == a(i, j));
+        }
+    }
+    for (int i = 0; i < R * C; i++)
+    {
+        CHECK(pa(i) == a(i));
+    }
+
+    Plain sum = a + b * static_cast<T>(2);
+    Custom psum = pa + pb * static_cast<T>(2);
+    CHECK(psum == sum);
+    CHECK(psum == Custom(sum));
+    psum -= pb;
+    sum -= b;
+    CHECK(psum == sum);
+    CHECK(isApprox<T>(pa.dot(pb), a.dot(b), static_cast<T>(1e-3)));
+    CHECK(isApprox<T>(pa.norm(), a.norm(), static_cast<T>(1e-3)));
+    CHECK(isApprox<T>(pa.sum(), a.sum(), static_cast<T>(1e-3)));
+    CHECK(pa.cwiseAbs() == a.cwiseAbs());
+    Custom pc = pa;
+    pc(R - 1, C - 1) += static_cast<T>(1);
+    CHECK_FALSE(pc == pa);
+
+    Custom ones = Custom::Ones();
+    CHECK(ones.sum() == static_cast<T>(R * C));
+    CHECK(pa.transpose() == a.transpose());
+
+    // products through the padded kernels
+    Matrix<T, R, C> prod = m * a;
+    Matrix<T, R, C, Options> pprod = pm * pa;
+    for (int i = 0; i < R * C; i++)
+    {
+        CHECK(isApprox<T>(pprod(i), prod(i), static_cast<T>(1e-3)));
+    }
+    Matrix<T, R, C, Options> mixed = pm * a;
+    for (int i = 0; i < R * C; i++)
+    {
+        CHECK(isApprox<T>(mixed(i), prod(i), static_cast<T>(1e-3)));
+    }
+    Matrix<T, R, C> mixed2 = m * pa;
+    for (int i = 0; i < R * C; i++)
+    {
+        CHECK(isApprox<T>(mixed2(i), prod(i), static_cast<T>(1e-3)));
+    }
+
+    CHECK(isApprox<T>(pm.determinant(), m.determinant(), static_cast<T>(1e-2)));
+    CustomSquare pinv = pm.inverse();
+    PlainSquare inv = m.inverse();
+    for (int i = 0; i < R * R; i++)
+    {
+        CHECK(isApprox<T>(pinv(i), inv(i), static_cast<T>(1e-3)));
+    }
+
+    // blocks honour the leading dimension
+    CustomSquare pblock = CustomSquare::Identity();
+    pblock.template block<R - 1, 1>(1, R - 1) = pm.block(0, 0, R - 1, 1);
+    for (int i = 1; i < R; i++)
+    {
+        CHECK(pblock(i, R - 1) == m(i - 1, 0));
+    }
+    pblock.row(0).swap(pblock.row(R - 1));
+    CHECK(pblock(R - 1, 0) == static_cast<T>(1));
+}
+
+TEST_CASE("test storage options")
+{
+    using namespace EmbeddedMath;
+    CHECK(Matrix<float, 3, 3, Padded>::OuterStrideAtCompileTime == 4);
+    CHECK(Matrix<double, 3, 3, Padded>::OuterStrideAtCompileTime == 4);
+    CHECK(Matrix<double, 3, 3, Aligned32 | Padded>::OuterStrideAtCompileTime == 4);
+    CHECK(Matrix<float, 3, 3, Aligned16>::OuterStrideAtCompileTime == 3);
+    CHECK(alignof(Matrix<float, 3, 1, Aligned32>) == 32);
+    CHECK(sizeof(Matrix<float, 3, 3, Padded>) == 12 * sizeof(float));
+
+    checkStorageOptions<float, 3, 3, Padded>();
+    checkStorageOptions<float, 3, 1, Padded>();
+    checkStorageOptions<float, 4, 4, Aligned16>();
+    checkStorageOptions<float, 5, 3, Aligned32 | Padded>();
+    checkStorageOptions<double, 3, 3, Padded>();
+    checkStorageOptions<double, 3, 1, Aligned32 | Padded>();
+    checkStorageOptions<double, 6, 2, Padded>();
+}
+
+TEST_CASE("test row-major storage")
+{
+    using namespace EmbeddedMath;
+    CHECK(Matrix<float, 3, 3, RowMajor>::IsRowMajor);
+    CHECK_FALSE(Matrix<float, 3, 1, RowMajor>::IsRowMajor);
+    CHECK(Matrix<float, 2, 3, RowMajor | Padded>::OuterStrideAtCompileTime == 4);
+
+    // a row-major buffer from a driver is copied in as is
+    const float buffer[6] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f};
+    Matrix<float, 2, 3, RowMajor> m(NoInit);
+    memcpy(m.data(), buffer, sizeof(buffer));
+    CHECK(m(0, 1) == 2.0f);
+    CHECK(m(1, 0) == 4.0f);
+    CHECK(m(3) == 5.0f);
+    Matrix<float, 2, 3> colMajor = m;
+    CHECK(colMajor(1, 2) == 6.0f);
+    CHECK(colMajor == m);
+    CHECK(m.transpose()(2, 1) == 6.0f);
+    CHECK(m.row(1)(0, 2) == 6.0f);
+
+    Vector3f v(1.0f, -1.0f, 2.0f);
+    Vector2f mv = m * v;
+    CHECK(mv == Vector2f(5.0f, 11.0f));
+
+    checkStorageOptions<float, 3, 3, RowMajor>();
+    checkStorageOptions<float, 4, 4, RowMajor>();
+    checkStorageOptions<float, 3, 1, RowMajor>();
+    checkStorageOptions<float, 3, 3, RowMajor | Padded>();
+    checkStorageOptions<float, 5, 3, RowMajor | Aligned32 | Padded>();
+    checkStorageOptions<double, 3, 3, RowMajor | Padded>();
+    checkStorageOptions<double, 6, 2, RowMajor>();
+    checkStorageOptions<double, 5, 5, RowMajor | Padded>();
+}
+
+// a bounded matrix holding a fixed-size one must give the same results through every operation
+template <typename T, int N, int Options>
+void checkBoundedMatrix()
+{
+    using namespace EmbeddedMath;
+    using MatX = Matrix<T, Dynamic, Dynamic, Options, 8, 8>;
+    using VecX = Matrix<T, Dynamic, 1, Options, 8, 1>;
+    using Fixed = Matrix<T, N, N>;
+    using FixedVec = Matrix<T, N, 1>;
+
+    Fixed m;
+    FixedVec v;
+    fillPseudoRandom(m, 17u);
+    fillPseudoRandom(v, 19u);
+    MatX bm(m);
+    VecX bv = v;
+    CHECK(bm.rows() == N);
+    CHECK(bm.cols() == N);
+    CHECK(bv.size() == N);
+    CHECK(bm == m);
+    CHECK(bv == v);
+    CHECK(bm.outerStride() == N);
+    for (int i = 0; i < N * N; i++)
+    {
+        CHECK(bm(i) == m(i));
+    }
+
+    MatX bsum = bm + bm * static_cast<T>(2) - m;
+    Fixed sum = m + m * static_cast<T>(2) - m;
+    CHECK(bsum == sum);
+    bsum -= bm;
+    sum -= m;
+    CHECK(bsum == sum);
+    CHECK(isApprox<T>(bm.sum(), m.sum(), static_cast<T>(1e-3)));
+    CHECK(isApprox<T>(bv.dot(bv), v.dot(v), static_cast<T>(1e-3)));
+    CHECK(isApprox<T>(bm.norm(), m.norm(), static_cast<T>(1e-3)));
+    CHECK(bm.transpose() == m.transpose());
+
+    // products, between bounded matrices and mixed with fixed-size ones
+    Fixed prod = m * m;
+    MatX bprod = bm * bm;
+    CHECK(bprod.rows() == N);
+    CHECK(bprod.isApprox(prod, static_cast<T>(1e-3)));
+    CHECK((bm * m).isApprox(prod, static_cast<T>(1e-3)));
+    CHECK((m * bm).isApprox(prod, static_cast<T>(1e-3)));
+    VecX bmv = bm * bv;
+    CHECK(bmv.isApprox(m * v, static_cast<T>(1e-3)));
+    CHECK((bv.transpose() * bm).isApprox(v.transpose() * m, static_cast<T>(1e-3)));
+    CHECK(((bm + bm) * bv).isApprox((m + m) * v, static_cast<T>(1e-3)));
+    Matrix<T, 3, Dynamic, Options, 3, 8> h(3, N);
+    for (int i = 0; i < 3 * N; i++)
+    {
+        h(i) = static_cast<T>(i % 5) - static_cast<T>(2);
+    }
+    Matrix<T, 3, 3> hht = h * bm * h.transpose();
+    Matrix<T, 3, N> fh = h;
+    CHECK(hht.isApprox(fh * m * fh.transpose(), static_cast<T>(1e-2)));
+
+    // blocks and decompositions
+    MatX bi = MatX::Identity(N, N);
+    bi.block(1, N - 1, N - 1, 1) = bm.block(0, 0, N - 1, 1);
+    for (int i = 1; i < N; i++)
+    {
+        CHECK(bi(i, N - 1) == m(i - 1, 0));
+    }
+    bi.row(0).swap(bi.row(N - 1));
+    CHECK(bi(N - 1, 0) == static_cast<T>(1));
+    CHECK(isApprox<T>(bm.determinant(), m.determinant(), static_cast<T>(1e-2) * fabs(m.determinant())));
+    MatX binv = bm.inverse();
+    CHECK(binv.isApprox(m.inverse(), static_cast<T>(1e-3)));
+    CHECK((bm * binv).isApprox(MatX::Identity(N, N), static_cast<T>(1e-3)));
+
+    // resizing keeps the storage, only the visible size changes
+    bm.resize(2, 3);
+    bm.setConstant(static_cast<T>(1));
+    CHECK(bm.size() == 6);
+    CHECK(bm.sum() == static_cast<T>(6));
+    CHECK_FALSE(bm == m);
+    bm = m;
+    CHECK(bm == m);
+}
+
+TEST_CASE("test bounded matrices")
+{
+    using namespace EmbeddedMath;
+    using MatX = Matrix<float, Dynamic, Dynamic, DefaultStorage, 6, 6>;
+    CHECK(sizeof(MatX) == 36 * sizeof(float) + 2 * sizeof(int));
+    MatX empty;
+    CHECK(empty.rows() == 0);
+    CHECK(empty.size() == 0);
+    MatX zeros(2, 5);
+    CHECK(zeros == MatX::Zero(2, 5));
+    CHECK(MatX::Ones(4, 3).sum() == 12.0f);
+    Matrix<float, Dynamic, 1, DefaultStorage, 6, 1> v(4);
+    CHECK(v.rows() == 4);
+    CHECK(v.cols() == 1);
+    v.resize(6);
+    CHECK(v.size() == 6);
+
+    checkBoundedMatrix<float, 3, DefaultStorage>();
+    checkBoundedMatrix<float, 5, RowMajor>();
+    checkBoundedMatrix<float, 8, Aligned32>();
+    checkBoundedMatrix<double, 4, DefaultStorage>();
+    checkBoundedMatrix<double, 7, RowMajor | Aligned16>();
+}
+
+namespace
+{
+    using namespace EmbeddedMath;
+
+    constexpr Matrix3f kIdentity = Matrix3f::Identity();
+    constexpr Matrix3f kScaled = kIdentity * 2.0f + Matrix3f::Ones();
+    constexpr Matrix<float, 2, 3> kWide(Matrix<float, 3, 2>::Constant(0.5f).transpose());
+    constexpr Matrix3f kProduct = kScaled * kScaled;
+    constexpr Quaternionf kQuarterTurn(0.70710678f, 0.0f, 0.0f, 0.70710678f);
+    constexpr Matrix3f kRotation = (kQuarterTurn * kQuarterTurn.conjugate()).toRotationMatrix();
+
+    constexpr Matrix4d scaledIdentity(double s)
+    {
+        Matrix4d m;
+        m.setIdentity();
+        m *= s;
+        return m;
+    }
+    constexpr Matrix4d kTable = scaledIdentity(3.0) - Matrix4d::Zero();
+}
+
+TEST_CASE("test constexpr evaluation")
+{
+    static_assert(kIdentity(1, 1) == 1.0f && kIdentity(0, 1) == 0.0f);
+    static_assert(kIdentity.trace() == 3.0f);
+    static_assert(kScaled(0, 0) == 3.0f && kScaled(2, 1) == 1.0f);
+    static_assert(kWide.rows() == 2 && kWide(1, 2) == 0.5f);
+    static_assert(kWide.sum() == 3.0f);
+    static_assert(kProduct(0, 0) == 11.0f && kProduct(0, 1) == 7.0f);
+    static_assert(kProduct == kScaled * kScaled);
+    static_assert(kTable.trace() == 12.0);
+    static_assert(kTable.cwiseAbs2().sum() == 36.0);
+
+    CHECK(kProduct == kScaled * kScaled);
+    CHECK(kRotation.isApprox(Matrix3f::Identity(), 1e-5f));
+    CHECK(kTable == Matrix4d::Identity() * 3.0);
+}
+
+template <typename T, int Options>
+void checkBlocks()
+{
+    using namespace EmbeddedMath;
+    using Big = Matrix<T, 9, 9, Options>;
+    Matrix<T, 9, 9> plain, other;
+    fillPseudoRandom(plain, 23u);
+    fillPseudoRandom(other, 29u);
+    Big m = plain;
+    const Big &cm = m;
+
+    // reads, linear indices count in column-major order inside the block
+    auto b = m.template block<4, 3>(2, 5);
+    CHECK(b.rows() == 4);
+    CHECK(b.cols() == 3);
+    CHECK(b.outerStride() == Big::OuterStrideAtCompileTime);
+    for (int j = 0; j < 3; j++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            CHECK(b(i, j) == plain(i + 2, j + 5));
+            CHECK(b(j * 4 + i) == plain(i + 2, j + 5));
+        }
+    }
+    CHECK(cm.template block<4, 3>(2, 5) == b);
+    CHECK(cm.row(3)(0, 7) == plain(3, 7));
+    CHECK(cm.col(8)(6) == plain(6, 8));
+    CHECK(isApprox<T>(b.sum(), Matrix<T, 4, 3>(b).sum(), static_cast<T>(1e-3)));
+
+    // expressions and compound assignments write through to the matrix, leaving the rest untouched
+    Matrix<T, 5, 6> x, y;
+    fillPseudoRandom(x, 31u);
+    fillPseudoRandom(y, 37u);
+    m.template block<5, 6>(3, 1) = x * static_cast<T>(2) - y;
+    m.template block<5, 6>(3, 1) += y;
+    m.template block<5, 6>(3, 1) -= x;
+    m.template block<5, 6>(3, 1) *= static_cast<T>(3);
+    for (int j = 0; j < 9; j++)
+    {
+        for (int i = 0; i < 9; i++)
+        {
+            if (i >= 3 && i < 8 && j >= 1 && j < 7)
+                CHECK(isApprox<T>(m(i, j), static_cast<T>(3) * x(i - 3, j - 1), static_cast<T>(1e-3)));
+            else
+                CHECK(m(i, j) == plain(i, j));
+        }
+    }
+
+    // blocks spanning whole columns, and rows, columns and blocks of other matrices
+    m = plain;
+    m.template block<9, 2>(0, 4) = other.template block<9, 2>(0, 6);
+    m.row(8) = other.row(0);
+    m.col(0) = other.col(1) + other.col(2);
+    m.template block<2, 2>(0, 7).setZero();
+    for (int i = 0; i < 8; i++)
+    {
+        CHECK(m(i, 4) == other(i, 6));
+        CHECK(m(i, 5) == other(i, 7));
+        CHECK(m(8, i + 1) == other(0, i + 1));
+    }
+    for (int i = 0; i < 9; i++)
+    {
+        CHECK(m(i, 0) == other(i, 1) + other(i, 2));
+    }
+    CHECK(m.template block<2, 2>(0, 7) == Matrix<T, 2, 2>::Zero());
+    CHECK(m(2, 7) == plain(2, 7));
+
+    // products read blocks in place, e.g. a covariance update P = F P F^T on the top-left corner
+    m = plain;
+    Matrix<T, 6, 6> F, P = plain.template block<6, 6>(0, 0);
+    fillPseudoRandom(F, 41u);
+    Matrix<T, 6, 6> expected = F * P * F.transpose();
+    m.template block<6, 6>(0, 0) = F * m.template block<6, 6>(0, 0) * F.transpose();
+    CHECK(Matrix<T, 6, 6>(m.template block<6, 6>(0, 0)).isApprox(expected, static_cast<T>(1e-3)));
+    CHECK(m(6, 6) == plain(6, 6));
+
+    m = plain;
+    Matrix<T, 4, 5> lhs = plain.template block<4, 3>(1, 2) * other.template block<3, 5>(4, 0);
+    Matrix<T, 4, 5> lhsExpected = Matrix<T, 4, 3>(plain.template block<4, 3>(1, 2)) * Matrix<T, 3, 5>(other.template block<3, 5>(4, 0));
+    CHECK(lhs.isApprox(lhsExpected, static_cast<T>(1e-3)));
+    Matrix<T, 1, 9> rowProduct = cm.row(4) * other;
+    CHECK(rowProduct.isApprox(Matrix<T, 1, 9>(cm.row(4)) * other, static_cast<T>(1e-3)));
+
+    // swapping rows and columns
+    m = plain;
+    m.row(1).swap(m.row(7));
+    m.col(2).swap(m.col(3));
+    CHECK(m(1, 0) == plain(7, 0));
+    CHECK(m(7, 5) == plain(1, 5));
+    CHECK(m(4, 2) == plain(4, 3));
+}
+
+TEST_CASE("test block views")
+{
+    using namespace EmbeddedMath;
+    checkBlocks<float, DefaultStorage>();
+    checkBlocks<float, RowMajor>();
+    checkBlocks<float, Padded>();
+    checkBlocks<double, DefaultStorage>();
+    checkBlocks<double, RowMajor | Aligned32>();
+
+    // blocks of bounded matrices keep a runtime leading dimension
+    using MatX = Matrix<float, Dynamic, Dynamic, DefaultStorage, 8, 8>;
+    Matrix<float, 6, 5> fixed;
+    fillPseudoRandom(fixed, 43u);
+    MatX bm(fixed);
+    CHECK(bm.block<2, 3>(1, 1).outerStride() == 6);
+    CHECK(bm.block<2, 3>(1, 1)(1, 2) == fixed(2, 3));
+    bm.block<2, 3>(1, 1) = Matrix<float, 2, 3>::Ones();
+    CHECK(bm(2, 3) == 1.0f);
+    CHECK(bm(3, 3) == fixed(3, 3));
+    Vector3f v(1.0f, 2.0f, 3.0f);
+    Vector2f bv = bm.block<2, 3>(1, 1) * v;
+    CHECK(bv == Vector2f(6.0f, 6.0f));
+}
+
+namespace
+{
+    using namespace EmbeddedMath;
+
+    // functions taking matrices without copying them
+    float traceOf(Ref<const Matrix3f> m)
+    {
+        return m(0, 0) + m(1, 1) + m(2, 2);
+    }
+
+    void scaleInPlace(Ref<Vector3f> v, float factor)
+    {
+        v *= factor;
+    }
+}
+
+TEST_CASE("test maps and refs")
+{
+    using namespace EmbeddedMath;
+
+    // a map reads and writes an external buffer in column-major order
+    float buffer[12] = {1, 2, 3, 4, 5, 6, 7, 8, 10, 11, 12, 13};
+    Map<Matrix3f> m(buffer);
+    CHECK(m.data() == buffer);
+    CHECK(m(2, 1) == 6.0f);
+    CHECK(m(7) == 8.0f);
+    Matrix3f copy = m;
+    m = copy * 2.0f;
+    CHECK(buffer[4] == 10.0f);
+    m += copy;
+    m -= copy * 2.0f;
+    CHECK(Matrix3f(m) == copy);
+    m.col(1).setZero();
+    CHECK(buffer[3] == 0.0f);
+    CHECK(buffer[9] == 11.0f);
+    m.col(1) = copy.col(1);
+
+    // products read maps in place, PartialPivLU takes a map like a matrix
+    Vector3f v(1.0f, -1.0f, 2.0f);
+    CHECK((m * v).isApprox(copy * v, 1e-5f));
+    CHECK((m * m).isApprox(copy * copy, 1e-3f));
+    CHECK((copy * m).isApprox(copy * copy, 1e-3f));
+    PartialPivLU<Matrix3f> lu(m);
+    CHECK(isApprox(lu.determinant(), PartialPivLU<Matrix3f>(copy).determinant(), 1e-3f));
+    CHECK((Matrix3f(m) * lu.inverse()).isApprox(Matrix3f::Identity(), 1e-3f));
+
+    // a leading dimension of 4 skips the last element of each column, a const map is read-only
+    Map<Matrix3f, OuterStride<4>> padded(buffer);
+    CHECK(padded(0, 1) == 5.0f);
+    CHECK(padded(2, 2) == 12.0f);
+    Map<const Matrix3f, OuterStride<>> runtimePadded(buffer, OuterStride<>(4));
+    CHECK(runtimePadded.outerStride() == 4);
+    CHECK(runtimePadded == padded);
+    padded = Matrix3f::Identity();
+    CHECK(buffer[3] == 4.0f);
+    CHECK(buffer[7] == 8.0f);
+    CHECK(buffer[5] == 1.0f);
+
+    // interleaved samples: the x, y and z channels of three (x, y, z, t) records
+    float records[12] = {1, 2, 3, 0, 4, 5, 6, 0, 7, 8, 9, 0};
+    Map<Matrix3f, Stride<1, 4>> channels(records);
+    CHECK(channels(0, 2) == 3.0f);
+    CHECK(channels(2, 0) == 7.0f);
+    CHECK(channels.row(1) == Map<const Matrix<float, 1, 3>>(records + 4));
+    channels *= 2.0f;
+    CHECK(records[10] == 18.0f);
+    CHECK(records[11] == 0.0f);
+    Map<Matrix<float, 3, 1>, InnerStride<4>> xs(records);
+    CHECK(xs == Vector3f(2.0f, 8.0f, 14.0f));
+    CHECK(isApprox(xs.dot(Vector3f(1.0f, 1.0f, 1.0f)), 24.0f));
+
+    // refs bind to matrices, blocks and maps without copying
+    const float values[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    Matrix3f a = Map<const Matrix3f>(values);
+    Matrix<float, 5, 5> big = Matrix<float, 5, 5>::Zero();
+    big.block<3, 3>(1, 1) = a;
+    const Matrix3f &ca = a;
+    CHECK(traceOf(a) == 15.0f);
+    CHECK(traceOf(ca) == 15.0f);
+    CHECK(traceOf(big.block<3, 3>(1, 1)) == 15.0f);
+    CHECK(traceOf(m) == Matrix3f(m).trace());
+    CHECK(traceOf((a * 2.0f).eval()) == 30.0f);
+    Ref<const Matrix3f> ra(a);
+    CHECK(ra.data() == a.data());
+    CHECK((ra * a).isApprox(a * a, 1e-4f));
+
+    Vector3f w(1.0f, 2.0f, 3.0f);
+    scaleInPlace(w, 2.0f);
+    CHECK(w == Vector3f(2.0f, 4.0f, 6.0f));
+    scaleInPlace(big.col(2).block<3, 1>(1, 0), 10.0f);
+    CHECK(big(2, 2) == 50.0f);
+    CHECK(big(0, 2) == 0.0f);
+    scaleInPlace(Map<Vector3f>(buffer + 9), 0.5f);
+    CHECK(buffer[11] == 6.5f);
+}
+
+template <int Options>
+void checkDiagonal()
+{
+    using namespace EmbeddedMath;
+    using Mat = Matrix<float, 5, 5, Options>;
+    Matrix<float, 5, 5> plain;
+    fillPseudoRandom(plain, 47u);
+    Mat P = plain;
+    const Mat &cP = P;
+    const float qValues[5] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f};
+    Matrix<float, 5, 1> q = Map<const Matrix<float, 5, 1>>(qValues);
+    CHECK(cP.diagonal().rows() == 5);
+    CHECK(cP.diagonal()(3) == plain(3, 3));
+    P.diagonal() += q;
+    P.diagonal() *= 2.0f;
+    for (int j = 0; j < 5; j++)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            if (i == j)
+                CHECK(isApprox(P(i, j), 2.0f * (plain(i, j) + q(i))));
+            else
+                CHECK(P(i, j) == plain(i, j));
+        }
+    }
+    CHECK(isApprox(cP.diagonal().sum(), Mat(P).trace()));
+}
+
+TEST_CASE("test segments and diagonals")
+{
+    using namespace EmbeddedMath;
+    using Vector15f = Matrix<float, 15, 1>;
+
+    // error-state injection touches a few entries of the state in place
+    Vector15f x, dx;
+    fillPseudoRandom(x, 53u);
+    fillPseudoRandom(dx, 59u);
+    const Vector15f x0 = x;
+    x.segment<3>(6) += dx.segment<3>(6);
+    x.head<3>() -= dx.head<3>() * 0.5f;
+    x.tail<3>().setZero();
+    for (int i = 0; i < 15; i++)
+    {
+        if (i < 3)
+            CHECK(isApprox(x(i), x0(i) - 0.5f * dx(i)));
+        else if (i >= 6 && i < 9)
+            CHECK(isApprox(x(i), x0(i) + dx(i)));
+        else if (i >= 12)
+            CHECK(x(i) == 0.0f);
+        else
+            CHECK(x(i) == x0(i));
+    }
+    CHECK(x0.segment<4>(2) == Vector4f(x0(2), x0(3), x0(4), x0(5)));
+    CHECK(isApprox(x0.tail<2>().dot(x0.head<2>()), x0(13) * x0(0) + x0(14) * x0(1)));
+    Matrix3f R = Matrix3f::Identity() * 2.0f;
+    x.segment<3>(3) = R * x0.segment<3>(3);
+    CHECK(isApprox(x(4), 2.0f * x0(4)));
+
+    // segments of row vectors are rows, segments of views are views
+    Matrix<float, 1, 6> r = Matrix<float, 1, 6>::Ones();
+    r.segment<2>(1) *= 3.0f;
+    CHECK(r.sum() == 10.0f);
+    CHECK(r(2) == 3.0f);
+    CHECK(r(3) == 1.0f);
+    Matrix<float, 6, 6> M = Matrix<float, 6, 6>::Zero();
+    M.col(4).segment<2>(3) = Vector2f(7.0f, 8.0f);
+    M.row(1).tail<2>() = Matrix<float, 1, 2>(5.0f, 6.0f);
+    CHECK(M(3, 4) == 7.0f);
+    CHECK(M(4, 4) == 8.0f);
+    CHECK(M(1, 5) == 6.0f);
+    CHECK(M.sum() == 26.0f);
+
+    // the diagonal of the covariance, whatever the storage
+    checkDiagonal<DefaultStorage>();
+    checkDiagonal<RowMajor>();
+    checkDiagonal<Padded>();
+
+    // segments of bounded vectors
+    Matrix<float, Dynamic, 1, DefaultStorage, 15, 1> bx(x0);
+    bx.segment<3>(6) += dx.segment<3>(6);
+    bx.tail<2>() = Vector2f(1.0f, 2.0f);
+    CHECK(isApprox(bx(7), x0(7) + dx(7)));
+    CHECK(bx(14) == 2.0f);
+    CHECK(bx.head<2>() == x0.head<2>());
+
+    // runtime-sized blocks take compound assignments too
+    Matrix<float, 4, 4> A = Matrix<float, 4, 4>::Ones();
+    A.block(1, 1, 2, 2) += Matrix2f::Identity();
+    A.block(1, 1, 2, 2) -= Matrix2f::Ones() * 0.5f;
+    A.block(0, 0, 1, 4) *= 4.0f;
+    A.block(3, 0, 1, 4) /= 2.0f;
+    CHECK(A(1, 1) == 1.5f);
+    CHECK(A(1, 2) == 0.5f);
+    CHECK(A(0, 2) == 4.0f);
+    CHECK(A(3, 3) == 0.5f);
+    CHECK(A(2, 0) == 1.0f);
+}
+
+template <typename T, int Options>
+void checkTranspose()
+{
+    using namespace EmbeddedMath;
+    Matrix<T, 3, 5, Options> m;
+    fillPseudoRandom(m, 61u);
+    const auto mt = m.transpose();
+    CHECK(mt.rows() == 5);
+    CHECK(mt.cols() == 3);
+    Matrix<T, 5, 3, Options> copy = mt;
+    for (int j = 0; j < 3; j++)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            CHECK(mt(i, j) == m(j, i));
+            CHECK(copy(i, j) == m(j, i));
+            CHECK(mt(j * 5 + i) == m(j, i));
+        }
+    }
+    CHECK(copy.transpose() == m);
+    CHECK(isApprox<T>(mt.sum(), m.sum(), static_cast<T>(1e-3)));
+    Matrix<T, 5, 3> mixed = mt * static_cast<T>(2) + copy;
+    CHECK(mixed.isApprox(copy * static_cast<T>(3), static_cast<T>(1e-3)));
+
+    // products read the transposed operand in place, e.g. the Kalman gain P H^T (H P H^T + R)^-1
+    Matrix<T, 6, 6, Options> P;
+    Matrix<T, 3, 6, Options> H;
+    Matrix<T, 6, 4> B;
+    fillPseudoRandom(P, 67u);
+    fillPseudoRandom(H, 71u);
+    fillPseudoRandom(B, 73u);
+    const Matrix<T, 6, 3> Ht = H.transpose();
+    const Matrix<T, 6, 6> Pt = P.transpose();
+    const T eps = static_cast<T>(1e-3);
+    CHECK((P * H.transpose()).isApprox(P * Ht, eps));
+    CHECK((H * P * H.transpose()).isApprox(H * P * Ht, eps));
+    CHECK((H.transpose() * H).isApprox(Ht * H, eps));
+    CHECK((P.transpose() * B).isApprox(Pt * B, eps));
+    CHECK((B.transpose() * P).isApprox(Matrix<T, 4, 6>(B.transpose()) * P, eps));
+    CHECK((P.transpose() * P.transpose()).isApprox(Pt * Pt, eps));
+    CHECK((P.template block<3, 6>(1, 0).transpose() * H.transpose().transpose()).isApprox(Matrix<T, 6, 3>(P.template block<3, 6>(1, 0).transpose()) * H, eps));
+    CHECK(((P + P).transpose() * B).isApprox(Pt * B * static_cast<T>(2), eps));
+
+    // vectors: inner and outer products
+    Matrix<T, 6, 1> v = B.col(1);
+    CHECK(isApprox<T>((v.transpose() * v)(0), v.squaredNorm(), eps));
+    CHECK((v.transpose() * P).isApprox(Matrix<T, 1, 6>(v.transpose()) * P, eps));
+    Matrix<T, 6, 6> outer = v * v.transpose();
+    CHECK(isApprox<T>(outer(2, 4), v(2) * v(4), eps));
+}
+
+TEST_CASE("test transpose views")
+{
+    using namespace EmbeddedMath;
+    checkTranspose<float, DefaultStorage>();
+    checkTranspose<float, RowMajor>();
+    checkTranspose<float, Padded>();
+    checkTranspose<double, DefaultStorage>();
+
+    // a transpose is a row-major view of the same storage
+    Matrix<float, 3, 4> a;
+    fillPseudoRandom(a, 79u);
+    Ref<const Matrix<float, 4, 3, RowMajor>> r(a.transpose());
+    CHECK(r.data() == a.data());
+    CHECK(r(3, 1) == a(1, 3));
+
+    // small transposes and constant expressions
+    Matrix3f R = Matrix3f::Identity() * 2.0f;
+    R(0, 1) = 1.0f;
+    CHECK((R * R.transpose())(0, 0) == 5.0f);
+    CHECK((R.transpose() * R)(1, 1) == 5.0f);
+    constexpr Matrix<float, 2, 3> kTall = Matrix<float, 3, 2>::Constant(0.5f).transpose() * 2.0f;
+    static_assert(kTall(1, 2) == 1.0f);
+    constexpr Matrix<float, 2, 2> kGram = Matrix<float, 4, 2>::Ones().transpose() * Matrix<float, 4, 2>::Ones();
+    static_assert(kGram(0, 1) == 4.0f);
+}
+
+template <typename T, int Options>
+void checkNoAlias()
+{
+    using namespace EmbeddedMath;
+    Matrix<T, 6, 4, Options> A;
+    Matrix<T, 4, 5, Options> B;
+    Matrix<T, 5, 5> D;
+    fillPseudoRandom(A, 83u);
+    fillPseudoRandom(B, 89u);
+    fillPseudoRandom(D, 97u);
+    const T eps = static_cast<T>(1e-3);
+    const Matrix<T, 6, 5, Options> AB = A * B;
+
+    Matrix<T, 6, 5, Options> C;
+    C.noalias() = A * B;
+    CHECK(C.isApprox(AB, eps));
+    C.noalias() += A * B;
+    CHECK(C.isApprox(AB * static_cast<T>(2), eps));
+    C.noalias() -= static_cast<T>(3) * A * B;
+    CHECK(C.isApprox(-AB, eps));
+    C.noalias() -= -A * B;
+    CHECK(C.norm() < eps);
+    C.noalias() += A * (B * static_cast<T>(0.5));
+    C.noalias() += A * B * D.transpose();
+    CHECK(C.isApprox(AB * static_cast<T>(0.5) + AB * Matrix<T, 5, 5>(D.transpose()), eps));
+
+    // a block destination, the coefficients around it are left alone
+    Matrix<T, 9, 9, Options> big = Matrix<T, 9, 9, Options>::Constant(static_cast<T>(7));
+    big.template block<6, 5>(1, 2).noalias() = A * B;
+    big.template block<6, 5>(1, 2).noalias() -= static_cast<T>(2) * A * B;
+    CHECK(Matrix<T, 6, 5>(big.template block<6, 5>(1, 2)).isApprox(-AB, eps));
+    CHECK(big(0, 2) == static_cast<T>(7));
+    CHECK(big(7, 2) == static_cast<T>(7));
+    CHECK(big(1, 1) == static_cast<T>(7));
+    CHECK(big(1, 7) == static_cast<T>(7));
+
+    // covariance update P -= K (H P), with H P computed once
+    Matrix<T, 6, 6, Options> P;
+    Matrix<T, 3, 6, Options> H;
+    Matrix<T, 6, 3, Options> K;
+    fillPseudoRandom(P, 101u);
+    fillPseudoRandom(H, 103u);
+    fillPseudoRandom(K, 107u);
+    const Matrix<T, 6, 6, Options> expected = P - K * H * P;
+    const Matrix<T, 3, 6, Options> HP = H * P;
+    P.noalias() -= K * HP;
+    CHECK(P.isApprox(expected, eps));
+
+    // plain assignment stays correct when the destination is an operand
+    const Matrix<T, 6, 6, Options> P0 = P;
+    const Matrix<T, 6, 6, Options> PP = P0 * P0;
+    P = P * P;
+    CHECK(P.isApprox(PP, eps));
+    P = P0;
+    P += P * P;
+    CHECK(P.isApprox(P0 + PP, eps));
+    P = P0;
+    P.template block<3, 3>(0, 0) = P.template block<3, 3>(0, 0) * P.template block<3, 3>(3, 3);
+    CHECK(P(2, 1) != P0(2, 1));
+    CHECK(isApprox<T>(P(2, 1), (P0.template block<3, 3>(0, 0) * P0.template block<3, 3>(3, 3))(2, 1), eps));
+
+    // bounded destinations are resized by assignment
+    Matrix<T, Dynamic, Dynamic, Options & RowMajor, 8, 8> X;
+    X.noalias() = A * B;
+    CHECK(X.rows() == 6);
+    CHECK(X.cols() == 5);
+    X.noalias() -= A * B;
+    CHECK(X.norm() < eps);
+}
+
+constexpr EmbeddedMath::Matrix2f noAliasProduct()
+{
+    EmbeddedMath::Matrix2f m = EmbeddedMath::Matrix2f::Identity();
+    m.noalias() += EmbeddedMath::Matrix2f::Identity() * EmbeddedMath::Matrix2f::Constant(2.0f);
+    return m;
+}
+
+TEST_CASE("test noalias products")
+{
+    using namespace EmbeddedMath;
+    checkNoAlias<float, DefaultStorage>();
+    checkNoAlias<float, RowMajor>();
+    checkNoAlias<float, Padded>();
+    checkNoAlias<double, DefaultStorage>();
+
+    // products are lazy, nested ones are evaluated once
+    Matrix3f a = Matrix3f::Identity() * 2.0f;
+    Matrix3f b = Matrix3f::Constant(1.0f);
+    CHECK(isApprox((a * b).sum(), 18.0f));
+    CHECK((a * b + b).coeff(1, 2) == 3.0f);
+    CHECK(((a * b).transpose() * a)(0, 0) == 4.0f);
+    static_assert(noAliasProduct()(0, 0) == 3.0f);
+    static_assert(noAliasProduct()(1, 0) == 2.0f);
+}
+
+template <typename T, int Options>
+void checkProductChain()
+{
+    using namespace EmbeddedMath;
+    Matrix<T, 6, 15, Options> J;
+    Matrix<T, 15, 15, Options> P;
+    Matrix<T, 6, 1> w;
+    Matrix<T, 15, 1> v;
+    fillPseudoRandom(J, 109u);
+    fillPseudoRandom(P, 113u);
+    fillPseudoRandom(w, 127u);
+    fillPseudoRandom(v, 131u);
+    // coefficients within [-1, 1], so that float keeps the chain within eps
+    J *= static_cast<T>(0.1);
+    P *= static_cast<T>(0.1);
+    const T eps = static_cast<T>(1e-2);
+
+    // reference, evaluated from left to right one product at a time
+    const Matrix<T, 15, 15, Options> PP = P * P;
+    const Matrix<T, 15, 1> PPv = PP * v;
+    const Matrix<T, 6, 15, Options> JP = J * P;
+    const Matrix<T, 6, 6, Options> JPJt = JP * J.transpose();
+    const Matrix<T, 6, 1> JPJtw = JPJt * w;
+
+    Matrix<T, 15, 1> y = P * P * v;
+    CHECK(y.isApprox(PPv, eps));
+    CHECK(Matrix<T, 15, 1>(P * (P * v)).isApprox(PPv, eps));
+    Matrix<T, 6, 1> z = J * P * J.transpose() * w;
+    CHECK(z.isApprox(JPJtw, eps));
+    z.noalias() -= static_cast<T>(2) * J * P * J.transpose() * w;
+    CHECK(z.isApprox(-JPJtw, eps));
+    CHECK(Matrix<T, 6, 1>(J * P * J.transpose() * w + w).isApprox(JPJtw + w, eps));
+    CHECK(isApprox<T>((J * P * J.transpose())(2, 3), JPJt(2, 3), eps));
+
+    // the destination is an operand of the chain
+    y = v;
+    y = P * P * y;
+    CHECK(y.isApprox(PPv, eps));
+
+    // a bounded operand keeps the left to right order
+    Matrix<T, Dynamic, Dynamic, Options & RowMajor, 15, 15> X = P;
+    y = X * P * v;
+    CHECK(y.isApprox(PPv, eps));
+}
+
+TEST_CASE("test product chains")
+{
+    using namespace EmbeddedMath;
+    using namespace EmbeddedTypes::internal;
+    checkProductChain<float, DefaultStorage>();
+    checkProductChain<float, RowMajor>();
+    checkProductChain<double, DefaultStorage>();
+
+    // A * B * v is evaluated as A * (B * v), J * P * J^T * w as J * (P * (J^T * w))
+    using Square = Matrix<float, 15, 15>;
+    using Column = Matrix<float, 15, 1>;
+    using SquareChain = chain_order<std::tuple<const Square &, const Square &, const Column &>>;
+    static_assert(SquareChain::table.split[0][2] == 0);
+    using Jacobian = Matrix<float, 6, 15>;
+    using Update = chain_order<std::tuple<const Jacobian &, const Square &, const Matrix<float, 15, 6> &, const Matrix<float, 6, 1> &>>;
+    static_assert(Update::table.split[0][3] == 0 && Update::table.split[1][3] == 1 && Update::table.split[2][3] == 2);
+    // equal costs keep the left to right order
+    static_assert(chain_order<std::tuple<const Square &, const Square &, const Square &>>::table.split[0][2] == 1);
+
+    constexpr Matrix2f kChain = Matrix2f::Identity() * Matrix2f::Constant(2.0f) * Matrix2f::Identity();
+    static_assert(kChain(1, 0) == 2.0f);
+}
+
+template <typename T, int N, int M, int Options>
+void checkSelfAdjoint()
+{
+    using namespace EmbeddedMath;
+    using Square = Matrix<T, N, N, Options>;
+    Square A;
+    Matrix<T, N, M, Options> K;
+    Matrix<T, M, M> S0;
+    Matrix<T, M, N, Options> F;
+    Square G;
+    fillPseudoRandom(A, 137u);
+    fillPseudoRandom(K, 139u);
+    fillPseudoRandom(S0, 149u);
+    fillPseudoRandom(F, 151u);
+    fillPseudoRandom(G, 157u);
+    // coefficients within [-1, 1] and a symmetric S, so that float keeps the updates within eps
+    A *= static_cast<T>(0.1);
+    K *= static_cast<T>(0.1);
+    F *= static_cast<T>(0.1);
+    G *= static_cast<T>(0.1);
+    const Matrix<T, M, M> S = S0 * S0.transpose() * static_cast<T>(0.01);
+    const T eps = static_cast<T>(1e-3);
+
+    // the views read one triangle
+    const Square lower = A.template triangularView<Lower>();
+    const Square strictlyUpper = A.template triangularView<StrictlyUpper>();
+    const Square unitLower = A.template triangularView<UnitLower>();
+    const Square P = A.template selfadjointView<Lower>();
+    const Square PUpper = A.template selfadjointView<Upper>();
+    for (int j = 0; j < N; ++j)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            CHECK(lower(i, j) == (i >= j ? A(i, j) : static_cast<T>(0)));
+            CHECK(strictlyUpper(i, j) == (i < j ? A(i, j) : static_cast<T>(0)));
+            CHECK(unitLower(i, j) == (i == j ? static_cast<T>(1) : lower(i, j)));
+            CHECK(P(i, j) == A(i >= j ? i : j, i >= j ? j : i));
+            CHECK(PUpper(i, j) == A(i <= j ? i : j, i <= j ? j : i));
+        }
+    }
+    CHECK(P == P.transpose());
+    CHECK(Square(A.template triangularView<Upper>() + strictlyUpper.transpose() * static_cast<T>(0)).isApprox(Square(A.template triangularView<Upper>()), eps));
+    CHECK(Matrix<T, N, M>(A.template triangularView<Lower>() * K).isApprox(lower * K, eps));
+    CHECK(Matrix<T, N, M>(A.template selfadjointView<Lower>() * K).isApprox(P * K, eps));
+
+    // assigning a view of itself makes a matrix symmetric
+    Square B = A;
+    B = B.template selfadjointView<Upper>();
+    CHECK(B == PUpper);
+
+    // updates compute one triangle and leave the whole matrix exactly symmetric
+    Square Q = A;
+    Q.template selfadjointView<Lower>().rankUpdate(K, static_cast<T>(-2));
+    CHECK(Q.isApprox(P - static_cast<T>(2) * K * K.transpose(), eps));
+    CHECK(Q == Q.transpose());
+    Q = A;
+    Q.template selfadjointView<Upper>().congruenceUpdate(K, S, static_cast<T>(-1));
+    CHECK(Q.isApprox(PUpper - K * S * K.transpose(), eps));
+    CHECK(Q == Q.transpose());
+    const Square GAGt = A.template selfadjointView<Lower>().congruence(G);
+    CHECK(GAGt.isApprox(G * P * G.transpose(), eps));
+    CHECK(GAGt == GAGt.transpose());
+    const Matrix<T, M, M> FAFt = A.template selfadjointView<Lower>().congruence(F);
+    CHECK(FAFt.isApprox(F * P * F.transpose(), eps));
+    CHECK(FAFt == FAFt.transpose());
+
+    // a block of a larger matrix, the coefficients around it are left alone
+    Matrix<T, N + 2, N + 2, Options> big = Matrix<T, N + 2, N + 2, Options>::Constant(static_cast<T>(7));
+    big.template block<N, N>(1, 1) = A;
+    big.template block<N, N>(1, 1).template selfadjointView<Lower>().rankUpdate(K);
+    CHECK(Square(big.template block<N, N>(1, 1)).isApprox(P + K * K.transpose(), eps));
+    CHECK(big(0, 1) == static_cast<T>(7));
+    CHECK(big(N + 1, 1) == static_cast<T>(7));
+
+    // bounded matrices take the runtime kernels
+    Matrix<T, Dynamic, Dynamic, Options & RowMajor, N, N> X = A;
+    X.template selfadjointView<Lower>().congruenceUpdate(K, S, static_cast<T>(-1));
+    CHECK(X.isApprox(P - K * S * K.transpose(), eps));
+    CHECK(X == X.transpose());
+}
+
+constexpr EmbeddedMath::Matrix2f symmetricUpdate()
+{
+    EmbeddedMath::Matrix2f m = EmbeddedMath::Matrix2f::Identity();
+    m(1, 0) = 3.0f;
+    m.selfadjointView<EmbeddedMath::Lower>().rankUpdate(EmbeddedMath::Vector2f(1.0f, 2.0f));
+    return m;
+}
+
+TEST_CASE("test self-adjoint and triangular views")
+{
+    using namespace EmbeddedMath;
+    checkSelfAdjoint<float, 3, 2, DefaultStorage>();
+    checkSelfAdjoint<float, 6, 3, RowMajor>();
+    checkSelfAdjoint<float, 15, 6, DefaultStorage>();
+    checkSelfAdjoint<float, 15, 6, Padded>();
+    checkSelfAdjoint<double, 15, 6, DefaultStorage>();
+    checkSelfAdjoint<double, 17, 1, DefaultStorage>();
+    checkSelfAdjoint<float, 45, 12, DefaultStorage>();
+
+    constexpr Matrix2f kUnitUpper = Matrix2f::Constant(2.0f).triangularView<UnitUpper>();
+    static_assert(kUnitUpper(0, 0) == 1.0f && kUnitUpper(0, 1) == 2.0f && kUnitUpper(1, 0) == 0.0f);
+    static_assert(symmetricUpdate()(0, 1) == 5.0f && symmetricUpdate()(1, 0) == 5.0f && symmetricUpdate()(1, 1) == 5.0f);
+}
+
+template <typename T, int N, int M, int Options>
+void checkPackedSymmetric()
+{
+    using namespace EmbeddedMath;
+    using Square = Matrix<T, N, N, Options>;
+    using Sym = SymmetricMatrix<T, N>;
+    Square A;
+    Matrix<T, N, M, Options> K;
+    Matrix<T, M, M> S0;
+    Matrix<T, M, N, Options> F;
+    Square G;
+    fillPseudoRandom(A, 163u);
+    fillPseudoRandom(K, 167u);
+    fillPseudoRandom(S0, 173u);
+    fillPseudoRandom(F, 179u);
+    fillPseudoRandom(G, 181u);
+    A *= static_cast<T>(0.1);
+    K *= static_cast<T>(0.1);
+    F *= static_cast<T>(0.1);
+    G *= static_cast<T>(0.1);
+    const Matrix<T, M, M> S = S0 * S0.transpose() * static_cast<T>(0.01);
+    const T eps = static_cast<T>(1e-3);
+
+    // the lower triangle is packed, and reads back as the full symmetric matrix
+    static_assert(sizeof(Sym) == sizeof(T) * N * (N + 1) / 2);
+    const Square P = A.template selfadjointView<Lower>();
+    const Sym packed(A);
+    for (int j = 0; j < N; ++j)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            CHECK(packed(i, j) == P(i, j));
+        }
+    }
+    CHECK(Square(packed) == P);
+    CHECK(Square(packed + packed) == P + P);
+
+    Sym X = packed;
+    X(0, N - 1) = static_cast<T>(3);
+    CHECK(X(N - 1, 0) == static_cast<T>(3));
+    X = packed;
+    X += packed;
+    X -= Sym(P * static_cast<T>(0.5));
+    X *= static_cast<T>(2);
+    CHECK(Square(X).isApprox(static_cast<T>(3) * P, eps));
+
+    // products against plain matrices and vectors of either side
+    CHECK(Matrix<T, N, M>(packed * K).isApprox(P * K, eps));
+    CHECK(Matrix<T, M, N>(F * packed).isApprox(F * P, eps));
+    CHECK(Square(G * packed).isApprox(G * P, eps));
+    CHECK(Square(packed * packed).isApprox(P * P, eps));
+    const Matrix<T, N, 1> v = K.col(0);
+    CHECK(Matrix<T, N, 1>(packed * v).isApprox(P * v, eps));
+    CHECK(Matrix<T, 1, N>(v.transpose() * packed).isApprox(v.transpose() * P, eps));
+    CHECK(Matrix<T, M, M>(F * packed * F.transpose()).isApprox(F * P * F.transpose(), eps));
+
+    // symmetric updates of the packed triangle
+    X = packed;
+    X.rankUpdate(K, static_cast<T>(-2));
+    CHECK(Square(X).isApprox(P - static_cast<T>(2) * K * K.transpose(), eps));
+    X = packed;
+    X.congruenceUpdate(K, S, static_cast<T>(-1));
+    CHECK(Square(X).isApprox(P - K * S * K.transpose(), eps));
+    X = packed;
+    X.congruenceUpdate(K, SymmetricMatrix<T, M>(S), static_cast<T>(-1));
+    CHECK(Square(X).isApprox(P - K * S * K.transpose(), eps));
+    CHECK(Square(packed.congruence(G)).isApprox(G * P * G.transpose(), eps));
+    const SymmetricMatrix<T, M> FPFt = packed.congruence(F);
+    CHECK(Matrix<T, M, M>(FPFt).isApprox(F * P * F.transpose(), eps));
+}
+
+constexpr EmbeddedMath::SymmetricMatrix<float, 2> packedUpdate()
+{
+    EmbeddedMath::SymmetricMatrix<float, 2> m = EmbeddedMath::SymmetricMatrix<float, 2>::Identity();
+    m(1, 0) = 3.0f;
+    m.rankUpdate(EmbeddedMath::Vector2f(1.0f, 2.0f));
+    return m;
+}
+
+TEST_CASE("test packed symmetric matrix")
+{
+    using namespace EmbeddedMath;
+    checkPackedSymmetric<float, 3, 2, DefaultStorage>();
+    checkPackedSymmetric<float, 6, 3, RowMajor>();
+    checkPackedSymmetric<float, 15, 6, DefaultStorage>();
+    checkPackedSymmetric<float, 15, 6, Padded>();
+    checkPackedSymmetric<double, 24, 6, DefaultStorage>();
+    checkPackedSymmetric<double, 17, 1, DefaultStorage>();
+
+    static_assert(packedUpdate()(0, 1) == 5.0f && packedUpdate()(1, 0) == 5.0f && packedUpdate()(1, 1) == 5.0f);
+    constexpr Matrix2f kProduct = SymmetricMatrix<float, 2>::Identity() * Matrix2f::Constant(2.0f);
+    static_assert(kProduct(0, 1) == 2.0f);
+}
+
+template <typename T, int Options>
+void checkStructured()
+{
+    using namespace EmbeddedMath;
+    // error-state transition: identity on the diagonal except a dense bias block, a few dense couplings
+    using Transition = StructuredMatrix<T, BlockSizes<3, 3, 3, 3, 3>, BlockSizes<3, 3, 3, 3, 3>,
+                                        BlockPattern<IdentityBlock, DenseBlock, ZeroBlock, ZeroBlock, ZeroBlock,
+                                                     ZeroBlock, IdentityBlock, DenseBlock, DenseBlock, ZeroBlock,
+                                                     ZeroBlock, ZeroBlock, DenseBlock, ZeroBlock, DenseBlock,
+                                                     ZeroBlock, ZeroBlock, ZeroBlock, IdentityBlock, ZeroBlock,
+                                                     ZeroBlock, ZeroBlock, ZeroBlock, ZeroBlock, IdentityBlock>>;
+    using Measurement = StructuredMatrix<T, BlockSizes<3>, BlockSizes<3, 9, 3>, BlockPattern<DenseBlock, ZeroBlock, IdentityBlock>>;
+    using Square = Matrix<T, 15, 15, Options>;
+    Matrix<T, 3, 3> blocks[5];
+    for (int b = 0; b < 5; ++b)
+        fillPseudoRandom(blocks[b], 191u + b);
+    Square A;
+    Matrix<T, 15, 3, Options> K;
+    fillPseudoRandom(A, 197u);
+    fillPseudoRandom(K, 199u);
+    const T eps = static_cast<T>(1e-3);
+
+    // only the dense blocks are stored, the others read as zero and identity
+    static_assert(sizeof(Transition) == sizeof(T) * 5 * 9);
+    static_assert(sizeof(Measurement) == sizeof(T) * 9);
+    Transition F;
+    F.template denseBlock<0, 1>() = blocks[0];
+    F.template denseBlock<1, 2>() = blocks[1];
+    F.template denseBlock<1, 3>() = blocks[2];
+    F.template denseBlock<2, 2>() = blocks[3];
+    F.template denseBlock<2, 4>() = blocks[4];
+    Measurement H;
+    H.template denseBlock<0, 0>() = blocks[1];
+    Square Fd = Square::Identity();
+    Fd.template block<3, 3>(0, 3) = blocks[0];
+    Fd.template block<3, 3>(3, 6) = blocks[1];
+    Fd.template block<3, 3>(3, 9) = blocks[2];
+    Fd.template block<3, 3>(6, 6) = blocks[3];
+    Fd.template block<3, 3>(6, 12) = blocks[4];
+    Matrix<T, 3, 15, Options> Hd = Matrix<T, 3, 15, Options>::Zero();
+    Hd.template block<3, 3>(0, 0) = blocks[1];
+    Hd.template block<3, 3>(0, 12) = Matrix<T, 3, 3>::Identity();
+    CHECK(Square(F) == Fd);
+    CHECK(Matrix<T, 3, 15, Options>(H) == Hd);
+    CHECK(F(7, 13) == Fd(7, 13));
+    CHECK(F(9, 9) == static_cast<T>(1));
+    CHECK(F(12, 0) == static_cast<T>(0));
+    CHECK(Square(Transition(Fd)) == Fd);
+
+    // products skip the zero blocks and copy through the identity blocks
+    const Square P = A * A.transpose() * static_cast<T>(0.01);
+    CHECK(Square(F * P).isApprox(Fd * P, eps));
+    CHECK(Square(P * F).isApprox(P * Fd, eps));
+    CHECK(Square(P * F.transpose()).isApprox(P * Fd.transpose(), eps));
+    CHECK(Square(F * P * F.transpose()).isApprox(Fd * P * Fd.transpose(), eps));
+    CHECK(Square(F * F).isApprox(Fd * Fd, eps));
+    CHECK(Square(F * F.transpose()).isApprox(Fd * Fd.transpose(), eps));
+    CHECK(Matrix<T, 3, 15>(H * P).isApprox(Hd * P, eps));
+    CHECK(Matrix<T, 15, 3>(P * H.transpose()).isApprox(P * Hd.transpose(), eps));
+    CHECK(Square(K * H).isApprox(K * Hd, eps));
+    CHECK(Matrix<T, 3, 3>(H * P * H.transpose()).isApprox(Hd * P * Hd.transpose(), eps));
+    const Matrix<T, 15, 1> v = K.col(0);
+    CHECK(Matrix<T, 15, 1>(F * v).isApprox(Fd * v, eps));
+
+    // with packed symmetric covariances
+    const SymmetricMatrix<T, 15> packed(P);
+    CHECK(Square(F * packed * F.transpose()).isApprox(Fd * P * Fd.transpose(), eps));
+    CHECK(Square(packed * F.transpose()).isApprox(P * Fd.transpose(), eps));
+    CHECK(Square(packed * F).isApprox(P * Fd, eps));
+
+    // sums with plain matrices
+    CHECK(Square(F + P) == Fd + P);
+    CHECK(Square(P + F) == P + Fd);
+    CHECK(Square(F - P) == Fd - P);
+    CHECK(Square(P - F) == P - Fd);
+    Square X = P;
+    X += F;
+    X -= F;
+    X -= F;
+    CHECK(X.isApprox(P - Fd, eps));
+}
+
+TEST_CASE("test structured matrix")
+{
+    checkStructured<float, EmbeddedMath::DefaultStorage>();
+    checkStructured<float, EmbeddedMath::RowMajor>();
+    checkStructured<double, EmbeddedMath::DefaultStorage>();
+}